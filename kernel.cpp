@@ -0,0 +1,8589 @@
+#include "kernel.h"
+
+// 内核状态经当前线程的kernel指针访问。这些宏只在内核实现内部定义，
+// 前端与其他使用者须经kernel->字段或os_api.h访问，不会被同名标识符误伤
+#define ready_queue (kernel->ready_queue)
+#define ready_tail (kernel->ready_tail)
+#define running_process (kernel->running_process)
+#define blocked_queue (kernel->blocked_queue)
+#define pid_table (kernel->pid_table)
+#define pid_table_size (kernel->pid_table_size)
+#define memory_total (kernel->memory_total)
+#define memory (kernel->memory)
+#define disk (kernel->disk)
+#define mem_free_size_count (kernel->mem_free_size_count)
+#define mem_free_space (kernel->mem_free_space)
+#define disk_run_size_count (kernel->disk_run_size_count)
+#define disk_free_space (kernel->disk_free_space)
+#define disk_run_len (kernel->disk_run_len)
+#define file_frag (kernel->file_frag)
+#define disk_owner (kernel->disk_owner)
+#define defrag_active (kernel->defrag_active)
+#define defrag_budget (kernel->defrag_budget)
+#define defrag_cursor (kernel->defrag_cursor)
+#define defrag_inode (kernel->defrag_inode)
+#define defrag_started (kernel->defrag_started)
+#define defrag_run_blocks (kernel->defrag_run_blocks)
+#define defrag_run_files (kernel->defrag_run_files)
+#define defrag_stats (kernel->defrag_stats)
+#define snapshot_arenas (kernel->snapshot_arenas)
+#define root_directory (kernel->root_directory)
+#define inode_table (kernel->inode_table)
+#define inode_capacity (kernel->inode_capacity)
+#define inode_slots (kernel->inode_slots)
+#define inode_free_list (kernel->inode_free_list)
+#define inodes_in_use (kernel->inodes_in_use)
+#define current_directory (kernel->current_directory)
+#define next_pid (kernel->next_pid)
+#define time_counter (kernel->time_counter)
+#define current_algorithm (kernel->current_algorithm)
+#define rand_state (kernel->rand_state)
+#define processes_finished (kernel->processes_finished)
+#define turnaround_total (kernel->turnaround_total)
+#define turnaround_max (kernel->turnaround_max)
+#define creates_failed (kernel->creates_failed)
+#define mlfq_head (kernel->mlfq_head)
+#define mlfq_tail (kernel->mlfq_tail)
+#define mlfq_depth (kernel->mlfq_depth)
+#define mlfq_bitmap (kernel->mlfq_bitmap)
+#define mlfq_last_boost (kernel->mlfq_last_boost)
+#define sjf_heap (kernel->sjf_heap)
+#define cfs_root (kernel->cfs_root)
+#define cfs_leftmost (kernel->cfs_leftmost)
+#define cfs_nr_ready (kernel->cfs_nr_ready)
+#define cfs_ready_weight (kernel->cfs_ready_weight)
+#define cfs_min_vruntime (kernel->cfs_min_vruntime)
+#define edf_heap (kernel->edf_heap)
+#define edf_release_heap (kernel->edf_release_heap)
+#define rt_utilization (kernel->rt_utilization)
+#define rt_admitted (kernel->rt_admitted)
+#define rt_rejected (kernel->rt_rejected)
+#define rt_jobs_completed (kernel->rt_jobs_completed)
+#define rt_deadline_misses (kernel->rt_deadline_misses)
+#define event_queue (kernel->event_queue)
+#define event_count (kernel->event_count)
+#define event_capacity (kernel->event_capacity)
+#define event_seq (kernel->event_seq)
+#define events_processed (kernel->events_processed)
+#define clock_jumps (kernel->clock_jumps)
+#define idle_ticks (kernel->idle_ticks)
+#define devices (kernel->devices)
+#define pending_heaps (kernel->pending_heaps)
+#define pending_count (kernel->pending_count)
+#define interrupt_seq (kernel->interrupt_seq)
+#define interrupt_mask (kernel->interrupt_mask)
+#define interrupt_nesting (kernel->interrupt_nesting)
+#define max_interrupt_nesting (kernel->max_interrupt_nesting)
+#define in_service_priority (kernel->in_service_priority)
+#define timer_interrupt_pending (kernel->timer_interrupt_pending)
+#define interrupt_vector (kernel->interrupt_vector)
+#define interrupt_stats (kernel->interrupt_stats)
+#define system_interrupt_flag (kernel->system_interrupt_flag)
+#define interrupted_process (kernel->interrupted_process)
+#define compaction_active (kernel->compaction_active)
+#define compaction_budget (kernel->compaction_budget)
+#define compaction_started (kernel->compaction_started)
+#define compaction_run_bytes (kernel->compaction_run_bytes)
+#define incremental_tick (kernel->incremental_tick)
+#define pending_creates (kernel->pending_creates)
+#define pending_creates_tail (kernel->pending_creates_tail)
+#define compaction_stats (kernel->compaction_stats)
+#define shm_segments (kernel->shm_segments)
+#define next_shm_id (kernel->next_shm_id)
+#define sync_objects (kernel->sync_objects)
+#define next_sync_id (kernel->next_sync_id)
+#define priority_inheritance (kernel->priority_inheritance)
+#define sync_pi_boosts (kernel->sync_pi_boosts)
+#define resources (kernel->resources)
+#define num_resources (kernel->num_resources)
+#define banker_enabled (kernel->banker_enabled)
+#define banker_checks (kernel->banker_checks)
+#define banker_rejections (kernel->banker_rejections)
+#define deadlock_stats (kernel->deadlock_stats)
+#define wfg_epoch (kernel->wfg_epoch)
+#define memory_mode (kernel->memory_mode)
+#define frames (kernel->frames)
+#define free_frames (kernel->free_frames)
+#define free_frame_count (kernel->free_frame_count)
+#define frame_load_seq (kernel->frame_load_seq)
+#define tlb (kernel->tlb)
+#define tlb_clock (kernel->tlb_clock)
+#define vm_stats (kernel->vm_stats)
+#define repl_policy (kernel->repl_policy)
+#define repl_stats (kernel->repl_stats)
+#define clock_hand (kernel->clock_hand)
+#define swap_pages_used (kernel->swap_pages_used)
+#define swap_refs (kernel->swap_refs)
+#define cow_stats (kernel->cow_stats)
+#define disk_head (kernel->disk_head)
+#define disk_policy (kernel->disk_policy)
+#define disk_stats (kernel->disk_stats)
+#define metric_context_switches (kernel->metric_context_switches)
+#define metric_alloc_success (kernel->metric_alloc_success)
+#define metric_alloc_failure (kernel->metric_alloc_failure)
+#define metric_alloc_search (kernel->metric_alloc_search)
+#define metric_find_probes (kernel->metric_find_probes)
+#define ready_list_count (kernel->ready_list_count)
+#define blocked_count (kernel->blocked_count)
+#define disk_free_blocks (kernel->disk_free_blocks)
+#define metrics_dump_interval (kernel->metrics_dump_interval)
+#define metrics_next_dump (kernel->metrics_next_dump)
+#define metrics_dump_path (kernel->metrics_dump_path)
+#define metrics_dumps (kernel->metrics_dumps)
+
+// 全局变量（整个程序共享：宿主线程、指标注册表与跟踪设施）
+
+// 多级反馈队列各级时间量子
+const int mlfq_quantum[MLFQ_LEVELS] = {2, 4, 8, 16};  // 各级时间量子
+
+// SJF/SRTF与EDF堆的比较函数
+bool sjf_before(const PCB *a, const PCB *b);
+bool edf_before(const PCB *a, const PCB *b);
+bool release_before(const PCB *a, const PCB *b);
+
+// nice值(-20..19)到权重的映射，相邻nice约相差10%的CPU份额
+const int cfs_prio_to_weight[40] = {
+    /* -20 */ 88761, 71755, 56483, 46273, 36291,
+    /* -15 */ 29154, 23254, 18705, 14949, 11916,
+    /* -10 */  9548,  7620,  6100,  4904,  3906,
+    /*  -5 */  3121,  2501,  1991,  1586,  1277,
+    /*   0 */  1024,   820,   655,   526,   423,
+    /*   5 */   335,   272,   215,   172,   137,
+    /*  10 */   110,    87,    70,    56,    45,
+    /*  15 */    36,    29,    23,    18,    15,
+};
+
+// I/O设备的初始配置：磁盘、终端、网络
+const IODevice device_table[NUM_DEVICES] = {
+    {"disk", DEVICE_DISK, 3, 4, NULL, NULL, 0, NULL, 0, 0, 0},
+    {"tty", DEVICE_TERMINAL, 10, 20, NULL, NULL, 0, NULL, 0, 0, 0},
+    {"net", DEVICE_NETWORK, 5, 10, NULL, NULL, 0, NULL, 0, 0, 0},
+};
+
+const int interrupt_priority[NUM_INTERRUPT_TYPES] = {0, 1, 2};  // 时钟 > I/O > 系统调用
+const char *interrupt_names[NUM_INTERRUPT_TYPES] = {"timer", "io", "syscall"};
+const char *algorithm_keys[] = {"fcfs", "priority", "rr", "mlfq", "sjf", "srtf", "cfs"};
+const char *sync_type_names[] = {"互斥锁", "信号量", "条件变量"};
+const char *repl_names[NUM_REPL_POLICIES] = {"fifo", "lru", "clock", "wsclock"};
+const char *disk_policy_names[NUM_DISK_POLICIES] = {"fcfs", "sstf", "scan", "clook"};
+
+// 主机线程（定时器、设备）经无锁队列注入中断，内核在时钟边界取出
+InjectRing injection_ring;
+CRITICAL_SECTION kernel_lock;           // 内核状态锁：命令处理与自动运行互斥
+int host_clock_ticks = 0;               // 已注入但尚未运行的时钟数
+
+// 指标注册表
+Metric metrics[MAX_METRICS];
+int num_metrics = 0;
+CommandMetric *command_metrics = NULL;
+
+// 事件跟踪
+TraceRing trace_rings[TRACE_MAX_THREADS];
+volatile LONG trace_thread_count = 0;   // 已登记跟踪环的线程数
+volatile LONG trace_active = 0;         // 运行期跟踪开关
+volatile LONG trace_unregistered_drops = 0;
+long long trace_records_written = 0;
+FILE *trace_file = NULL;
+char trace_path[FILE_MAX_PATH] = "";
+HANDLE trace_thread = NULL;             // 异步刷写线程
+bool kernel_text_log = true;            // 运行期内核文本日志开关
+const char *trace_event_names[] = {
+    "switch", "preempt", "idle", "block", "wakeup", "create", "exit",
+    "timer", "irq", "io_done", "mem_alloc", "mem_free", "page_fault", "inject"
+};
+
+Kernel *main_kernel = NULL;             // 命令行使用的内核
+thread_local Kernel *kernel = NULL;     // 当前线程正在运行的内核
+void (*command_handler)(char *command) = NULL;  // 执行到达事件中的命令，由前端设置
+
+// 内核文字输出：格式化后交给当前内核的输出函数，未设置输出函数的内核（参数扫描的工作内核）不输出
+int klog(const char *format, ...) {
+    if (kernel == NULL || kernel->output == NULL) {
+        return 0;
+    }
+    char buf[KLOG_BUFFER_SIZE];
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (written < 0) {
+        return written;
+    }
+    if (written < (int)sizeof(buf)) {
+        kernel->output(kernel->output_context, buf);
+        return written;
+    }
+    // 超出栈缓冲区的长行（如长路径、长命令）在堆上重新格式化
+    char *text = (char*)malloc(written + 1);
+    va_start(args, format);
+    vsnprintf(text, written + 1, format, args);
+    va_end(args);
+    kernel->output(kernel->output_context, text);
+    free(text);
+    return written;
+}
+
+// 创建一个内核并设为当前线程的内核：memory_size为内存大小，seed为随机数种子，
+// 文字日志与报告交给output（为NULL时不输出）
+Kernel* kernel_create(int memory_size, unsigned int seed, OsOutputFunc output, void *context) {
+    kernel = (Kernel*)calloc(1, sizeof(Kernel));
+    memory_total = memory_size;
+    kernel->output = output;
+    kernel->output_context = context;
+    rand_state = seed;
+    next_pid = 1;
+    current_algorithm = RR;
+    sjf_heap.before = sjf_before;
+    edf_heap.before = edf_before;
+    edf_release_heap.before = release_before;
+    memcpy(devices, device_table, sizeof(devices));
+    in_service_priority = INT_MAX;
+    compaction_budget = COMPACT_BUDGET_DEFAULT;
+    defrag_budget = DEFRAG_BUDGET_DEFAULT;
+    incremental_tick = -1;
+    memory_mode = MEM_CONTIGUOUS;
+    repl_policy = REPL_FIFO;
+    disk_policy = DISK_FCFS;
+    disk_head.cylinder = 0;
+    disk_head.direction = 1;
+    mem_free_size_count = (int*)calloc(memory_size + 1, sizeof(int));
+    mem_free_space.size_count = mem_free_size_count;
+    disk_free_space.size_count = disk_run_size_count;
+
+    // 初始化内存：一个大内存块
+    memory = (MemoryBlock*)malloc(sizeof(MemoryBlock));
+    memory->start_address = 0;
+    memory->size = memory_total;
+    memory->is_allocated = false;
+    memory->pid = -1;
+    memory->next = NULL;
+    free_space_add(&mem_free_space, memory_total);
+    vm_init();
+
+    // 初始化中断控制器
+    init_interrupt_controller();
+
+    // 初始化文件系统
+    init_file_system();
+    return kernel;
+}
+
+// 本内核的伪随机数（线性同余，取值0..32767）：同一种子的内核产生相同序列，互不干扰
+int kernel_rand() {
+    rand_state = rand_state * 214013u + 2531011u;
+    return (rand_state >> 16) & 0x7fff;
+}
+
+// 初始化文件系统
+void init_file_system() {
+    // 初始化磁盘块
+    for (int i = 0; i < DISK_SIZE/BLOCK_SIZE; i++) {
+        disk[i].is_allocated = false;
+        disk[i].next_block = -1;
+    }
+    disk_free_blocks = DISK_SIZE/BLOCK_SIZE;
+    disk_run_len[0] = disk_run_len[DISK_SIZE/BLOCK_SIZE - 1] = DISK_SIZE/BLOCK_SIZE;
+    free_space_add(&disk_free_space, DISK_SIZE/BLOCK_SIZE);
+
+    // inode表：根目录占0号
+    inode_capacity = INODE_TABLE_INITIAL;
+    inode_table = (Inode*)malloc(inode_capacity * sizeof(Inode));
+    inode_slots = 0;
+    inode_free_list = -1;
+    inodes_in_use = 0;
+
+    // 创建根目录
+    root_directory = (FCB*)malloc(sizeof(FCB));
+    strcpy(root_directory->name, "/");
+    root_directory->type = DIRECTORY_TYPE;
+    root_directory->ino = inode_alloc(DIRECTORY_TYPE);
+    inode_table[root_directory->ino].links = 1;
+    root_directory->parent = root_directory; // 根目录的父目录是它自己
+    root_directory->child = NULL;
+    root_directory->sibling = NULL;
+    root_directory->next_link = NULL;
+    root_directory->tree_size = 0;
+    root_directory->tree_blocks = 0;
+    root_directory->tree_files = 0;
+    root_directory->tree_dirs = 1;
+
+    // 设置当前目录为根目录
+    current_directory = root_directory;
+}
+
+// 分配并初始化PCB（不分配内存、不入队）
+static PCB* alloc_pcb(const char *name, int memory_size, int priority, int time_slice,
+                      int mem_start, const RTParams *rt) {
+    PCB *proc = (PCB*)malloc(sizeof(PCB));
+    proc->pid = next_pid++;
+    strncpy(proc->name, name, sizeof(proc->name) - 1);
+    proc->name[sizeof(proc->name) - 1] = '\0';
+    proc->state = READY;
+    proc->priority = priority;
+    proc->base_priority = priority;
+    proc->sync_wait = NULL;
+    proc->sync_next = NULL;
+    proc->sync_wait_start = 0;
+    for (int r = 0; r < MAX_RESOURCE_TYPES; r++) {
+        proc->res_alloc[r] = 0;
+        proc->res_claim[r] = r < num_resources ? resources[r].default_claim : 0;
+    }
+    proc->res_wait = -1;
+    proc->res_wait_count = 0;
+    proc->res_wait_start = 0;
+    proc->res_next = NULL;
+    proc->wfg_stamp = 0;
+    proc->wfg_from = NULL;
+    TRACE(TRACE_CREATE, proc->pid, memory_size, priority);
+    proc->time_slice = time_slice;  // 使用传入的时间片
+    proc->arrival_time = time_counter;
+    proc->memory_start = mem_start;
+    proc->memory_size = memory_size;
+    proc->mlfq_level = 0;
+    proc->quantum_left = mlfq_quantum[0];
+    proc->burst_time = 0;
+    proc->burst_estimate = INITIAL_BURST_ESTIMATE;
+    proc->heap_index = -1;
+    proc->vruntime = cfs_min_vruntime;  // 新进程从当前最小vruntime开始，避免独占CPU
+    proc->rb_left = proc->rb_right = proc->rb_parent = NULL;
+    proc->rb_red = false;
+    proc->rt_runtime = 0;
+    proc->rt_period = 0;
+    proc->rt_deadline = 0;
+    proc->rt_budget = 0;
+    proc->rt_abs_deadline = 0;
+    proc->rt_next_release = 0;
+    proc->rt_misses = 0;
+    if (rt != NULL) {
+        proc->rt_runtime = rt->runtime;
+        proc->rt_period = rt->period;
+        proc->rt_deadline = rt->deadline;
+        proc->rt_budget = rt->runtime;
+        proc->rt_abs_deadline = time_counter + rt->deadline;
+        proc->rt_next_release = time_counter + rt->period;
+        rt_utilization += (double)rt->runtime / rt->deadline;
+        rt_admitted++;
+    }
+    proc->io_request = NULL;
+    proc->page_table = NULL;
+    proc->page_count = 0;
+    proc->resident_pages = 0;
+    proc->page_faults = 0;
+    proc->vm_locality = 0;
+    proc->vm_refs = 0;
+    proc->prev = NULL;
+    proc->next = NULL;
+    return proc;
+}
+
+// 创建进程 - 修改为接受time_slice参数
+// 创建进程；失败时返回NULL，status（可为NULL）给出原因
+PCB* create_process(char *name, int memory_size, int priority, int time_slice, const RTParams *rt,
+                    OsStatus *status) {
+    OsStatus ignored;
+    if (status == NULL) status = &ignored;
+
+    // 检查进程名是否为空
+    if (name == NULL || strlen(name) == 0) {
+        klog("错误: 进程名不能为空\n");
+        *status = OS_ERR_INVALID;
+        return NULL;
+    }
+
+    // 检查内存大小是否有效：分页模式下允许超过物理内存
+    int max_size = memory_mode == MEM_PAGING ? MAX_VIRTUAL_SIZE : memory_total;
+    if (memory_size <= 0 || memory_size > max_size) {
+        klog("错误: 内存大小无效\n");
+        *status = OS_ERR_INVALID;
+        return NULL;
+    }
+
+    // 银行家算法准入检查
+    if (!banker_admit(name)) {
+        *status = OS_ERR_REJECTED;
+        return NULL;
+    }
+
+    // 检查时间片是否有效
+    if (time_slice <= 0) {
+        klog("错误: 时间片必须大于0\n");
+        *status = OS_ERR_INVALID;
+        return NULL;
+    }
+
+    // 实时进程：参数检查与基于利用率的准入控制
+    if (rt != NULL) {
+        if (rt->runtime <= 0 || rt->period <= 0 || rt->deadline <= 0 ||
+            rt->runtime > rt->deadline || rt->deadline > rt->period) {
+            klog("错误: 实时参数须满足 0 < runtime <= deadline <= period\n");
+            *status = OS_ERR_INVALID;
+            return NULL;
+        }
+        // 截止期短于周期时按密度 runtime/deadline 计入，保证EDF可调度
+        double density = (double)rt->runtime / rt->deadline;
+        if (rt_utilization + density > RT_UTIL_BOUND) {
+            rt_rejected++;
+            klog("错误: 准入控制拒绝，实时利用率 %.3f + %.3f 超过上限 %.2f\n",
+                   rt_utilization, density, RT_UTIL_BOUND);
+            *status = OS_ERR_REJECTED;
+            return NULL;
+        }
+    }
+
+    // 分配内存：分页模式下只建立页表，页面在首次访问时调入
+    int mem_start = 0;
+    if (memory_mode == MEM_CONTIGUOUS) {
+        mem_start = compaction_active ? -1 : allocate_memory(memory_size, next_pid);
+        if (mem_start == -1) {
+            // 空闲总量足够但被碎片分散：启动紧缩，创建请求推迟到紧缩完成
+            if (total_free_memory() >= memory_size) {
+                PendingCreate *pending = (PendingCreate*)malloc(sizeof(PendingCreate));
+                strncpy(pending->name, name, sizeof(pending->name) - 1);
+                pending->name[sizeof(pending->name) - 1] = '\0';
+                pending->memory_size = memory_size;
+                pending->priority = priority;
+                pending->time_slice = time_slice;
+                pending->has_rt = rt != NULL;
+                if (rt != NULL) pending->rt = *rt;
+                pending->next = NULL;
+                if (pending_creates_tail == NULL) {
+                    pending_creates = pending;
+                } else {
+                    pending_creates_tail->next = pending;
+                }
+                pending_creates_tail = pending;
+                klog("内存碎片: 空闲 %d 足够但不连续，进程 %s 将在内存紧缩完成后创建\n",
+                       total_free_memory(), name);
+                start_compaction();
+                *status = OS_ERR_DEFERRED;
+                return NULL;
+            }
+            creates_failed++;
+            klog("错误: 无足够内存可分配\n");
+            *status = OS_ERR_NO_MEMORY;
+            return NULL;
+        }
+    }
+
+    // 创建PCB
+    PCB *new_process = alloc_pcb(name, memory_size, priority, time_slice, mem_start, rt);
+    if (memory_mode == MEM_PAGING) {
+        vm_setup_process(new_process);
+    }
+    register_process(new_process);
+
+    // 添加到就绪队列
+    add_to_ready_queue(new_process);
+
+    if (memory_mode == MEM_PAGING) {
+        klog("进程 %s (PID=%d) 已创建，虚拟地址空间: %d 字节 (%d 页，请求调页), 时间片=%d\n",
+               name, new_process->pid, memory_size, new_process->page_count, time_slice);
+    } else {
+        klog("进程 %s (PID=%d) 已创建，内存分配: 起始=%d, 大小=%d, 时间片=%d\n",
+               name, new_process->pid, mem_start, memory_size, time_slice);
+    }
+
+    *status = OS_OK;
+    return new_process;
+}
+
+// fork：复制父进程创建子进程。分页模式下子进程共享父进程的页框，双方写时复制；
+// 连续分配模式下为子进程分配新区域并完整复制。实时父进程的子进程作为普通进程运行
+PCB* fork_process(int pid) {
+    PCB *parent = lookup_process(pid);
+    if (parent == NULL) {
+        klog("未找到PID=%d的进程\n", pid);
+        return NULL;
+    }
+
+    int mem_start = 0;
+    if (parent->page_table == NULL) {
+        mem_start = allocate_memory(parent->memory_size, next_pid);
+        if (mem_start == -1) {
+            klog("错误: 无足够连续内存复制进程 %s (PID=%d)\n", parent->name, parent->pid);
+            return NULL;
+        }
+    }
+
+    int time_slice = parent->time_slice > 0 ? parent->time_slice : 1;
+    PCB *child = alloc_pcb(parent->name, parent->memory_size, parent->base_priority, time_slice,
+                           mem_start, NULL);
+    child->burst_estimate = parent->burst_estimate;
+    child->vruntime = parent->vruntime;
+    child->vm_locality = parent->vm_locality;
+    if (parent->page_table != NULL) {
+        long long shared_before = cow_stats.pages_shared;
+        vm_fork(parent, child);
+        cow_stats.cow_forks++;
+        klog("fork: 进程 %s (PID=%d) -> 子进程 PID=%d，共享 %lld 个驻留页（写时复制）\n",
+               parent->name, parent->pid, child->pid, cow_stats.pages_shared - shared_before);
+    } else {
+        cow_stats.copy_forks++;
+        cow_stats.bytes_copied += parent->memory_size;
+        klog("fork: 进程 %s (PID=%d) -> 子进程 PID=%d，复制内存 %d 字节到地址 %d\n",
+               parent->name, parent->pid, child->pid, parent->memory_size, mem_start);
+    }
+    register_process(child);
+    add_to_ready_queue(child);
+    return child;
+}
+
+// 终止进程
+OsStatus terminate_process(int pid) {
+    // 检查正在运行的进程
+    if (running_process && running_process->pid == pid) {
+        klog("终止运行中的进程 %s (PID=%d)\n", running_process->name, running_process->pid);
+        release_process(running_process);
+        running_process = NULL;
+        schedule_process(); // 重新调度
+        return OS_OK;
+    }
+
+    // 检查就绪队列
+    PCB *ready_proc = remove_pid_from_ready_queue(pid);
+    if (ready_proc != NULL) {
+        klog("终止就绪队列中的进程 %s (PID=%d)\n", ready_proc->name, ready_proc->pid);
+        release_process(ready_proc);
+        return OS_OK;
+    }
+
+    // 检查阻塞队列
+    PCB *blocked_proc = remove_from_blocked_queue(pid);
+    if (blocked_proc != NULL) {
+        klog("终止阻塞队列中的进程 %s (PID=%d)\n", blocked_proc->name, blocked_proc->pid);
+        release_process(blocked_proc);
+        return OS_OK;
+    }
+
+    klog("未找到PID=%d的进程\n", pid);
+    return OS_ERR_NOT_FOUND;
+}
+
+// 阻塞进程：向设备提交I/O请求，完成中断到来时唤醒；
+// device为WAIT_IPC/WAIT_SYNC时不提交I/O，由通道另一端或同步对象的释放者唤醒
+void block_process(int pid, int device) {
+    // 只能阻塞当前运行的进程
+    if (running_process && running_process->pid == pid) {
+        if (device >= 0) {
+            KLOG("阻塞进程 %s (PID=%d)，等待设备 %s\n",
+                   running_process->name, running_process->pid, devices[device].name);
+        } else {
+            KLOG("阻塞进程 %s (PID=%d)，等待%s\n", running_process->name, running_process->pid,
+                   device == WAIT_IPC ? "通道" : device == WAIT_SYNC ? "同步对象" : "资源");
+        }
+        TRACE(TRACE_BLOCK, running_process->pid, device, 0);
+        update_burst_estimate(running_process);
+        running_process->state = BLOCKED;
+        add_to_blocked_queue(running_process);
+        if (device >= 0) {
+            submit_io_request(running_process, device);
+        }
+        running_process = NULL;
+        schedule_process(); // 重新调度
+    } else {
+        klog("只能阻塞当前运行的进程，PID=%d不是当前运行的进程\n", pid);
+    }
+}
+
+// 唤醒进程
+OsStatus wakeup_process(int pid) {
+    PCB *proc = remove_from_blocked_queue(pid);
+    if (proc != NULL) {
+        KLOG("唤醒进程 %s (PID=%d)\n", proc->name, proc->pid);
+        cancel_io_request(proc);  // 手动唤醒时放弃未完成的I/O
+        ipc_cancel_wait(proc->pid);
+        sync_cancel_wait(proc);
+        resource_cancel_wait(proc);
+        TRACE(TRACE_WAKEUP, proc->pid, 0, 0);
+        proc->state = READY;
+        mlfq_promote(proc);
+        add_to_ready_queue(proc);
+        return OS_OK;
+    }
+    klog("未找到阻塞队列中PID=%d的进程\n", pid);
+    return OS_ERR_NOT_FOUND;
+}
+
+// 进程调度
+void schedule_process() {
+    // 实时调度类优先于普通调度类：有截止期更早的实时作业就绪则抢占
+    if (running_process != NULL && edf_heap.size > 0 &&
+        (!is_rt(running_process) || edf_before(edf_heap.items[0], running_process))) {
+        PCB *proc = running_process;
+        KLOG("进程 %s (PID=%d) 被实时进程 %s (PID=%d) 抢占\n",
+               proc->name, proc->pid, edf_heap.items[0]->name, edf_heap.items[0]->pid);
+        proc->state = READY;
+        TRACE(TRACE_PREEMPT, proc->pid, 0, 0);
+        add_to_ready_queue(proc);
+        running_process = NULL;
+    }
+
+    // 以下普通调度类的抢占规则不作用于实时进程
+    if (running_process != NULL && is_rt(running_process)) {
+        return;
+    }
+
+    // 多级反馈队列：量子用完则降级，有更高级别进程就绪则抢占
+    if (running_process != NULL && current_algorithm == MLFQ) {
+        if (running_process->quantum_left <= 0) {
+            PCB *proc = running_process;
+            if (proc->mlfq_level < MLFQ_LEVELS - 1) {
+                proc->mlfq_level++;
+            }
+            proc->quantum_left = mlfq_quantum[proc->mlfq_level];
+            KLOG("进程 %s (PID=%d) 量子用完，降至第%d级\n", proc->name, proc->pid, proc->mlfq_level);
+            proc->state = READY;
+            TRACE(TRACE_PREEMPT, proc->pid, 0, 0);
+            add_to_ready_queue(proc);
+            running_process = NULL;
+        } else if ((mlfq_bitmap & ((1u << running_process->mlfq_level) - 1)) != 0) {
+            PCB *proc = running_process;
+            KLOG("进程 %s (PID=%d) 被更高级别进程抢占\n", proc->name, proc->pid);
+            proc->state = READY;
+            TRACE(TRACE_PREEMPT, proc->pid, 0, 0);
+            add_to_ready_queue(proc);
+            running_process = NULL;
+        }
+    }
+
+    // 完全公平调度：动态时间片用完则按vruntime放回红黑树
+    if (running_process != NULL && current_algorithm == CFS && running_process->quantum_left <= 0) {
+        PCB *proc = running_process;
+        KLOG("进程 %s (PID=%d) 时间片用完，vruntime=%.2f\n",
+               proc->name, proc->pid, (double)proc->vruntime / CFS_VRUNTIME_SCALE);
+        proc->state = READY;
+        TRACE(TRACE_PREEMPT, proc->pid, 0, 0);
+        add_to_ready_queue(proc);
+        running_process = NULL;
+    }
+
+    // 最短剩余时间优先：就绪进程的预测剩余时间更短则抢占
+    if (running_process != NULL && current_algorithm == SRTF && sjf_heap.size > 0 &&
+        predicted_remaining(sjf_heap.items[0]) < predicted_remaining(running_process)) {
+        PCB *proc = running_process;
+        KLOG("进程 %s (PID=%d) 被剩余时间更短的进程 %s (PID=%d) 抢占\n",
+               proc->name, proc->pid, sjf_heap.items[0]->name, sjf_heap.items[0]->pid);
+        proc->state = READY;
+        TRACE(TRACE_PREEMPT, proc->pid, 0, 0);
+        add_to_ready_queue(proc);
+        running_process = NULL;
+    }
+
+    // 时间片轮转：量子用完且有其他就绪进程时放回队尾，否则以新的量子继续运行
+    if (running_process != NULL && current_algorithm == RR && running_process->quantum_left <= 0) {
+        PCB *proc = running_process;
+        if (ready_queue == NULL) {
+            proc->quantum_left = RR_QUANTUM;
+        } else {
+            KLOG("进程 %s (PID=%d) 量子用完，放回就绪队列尾部\n", proc->name, proc->pid);
+            proc->state = READY;
+            TRACE(TRACE_PREEMPT, proc->pid, 0, 0);
+            add_to_ready_queue(proc);
+            running_process = NULL;
+        }
+    }
+
+    // 运行中的进程继续运行：time_slice是剩余运行需求，耗尽时由到期的时钟中断在
+    // handle_timer_interrupt中结束进程，这里不再重置或重新排队
+    if (running_process != NULL) {
+        return;
+    }
+
+    // 从就绪队列选择下一个进程，实时作业优先
+    PCB *next_process = (edf_heap.size > 0) ? heap_pop(&edf_heap) : remove_from_ready_queue();
+    
+    // 如果找到了下一个要运行的进程
+    if (next_process != NULL) {
+        running_process = next_process;
+        running_process->state = RUNNING;
+        if (current_algorithm == CFS && !is_rt(running_process)) {
+            running_process->quantum_left = cfs_timeslice(running_process);
+        } else if (current_algorithm == RR && !is_rt(running_process)) {
+            running_process->quantum_left = RR_QUANTUM;
+        }
+        KLOG("调度进程 %s (PID=%d) 开始运行\n", running_process->name, running_process->pid);
+        TRACE(TRACE_SWITCH, running_process->pid, running_process->time_slice, 0);
+        metric_context_switches++;
+    } else {
+        KLOG("就绪队列为空，没有可运行的进程\n");
+        TRACE(TRACE_IDLE, -1, 0, 0);
+        
+        // 如果没有其他进程可运行，且有被中断的进程，考虑自动恢复
+        if (system_interrupt_flag && interrupted_process != NULL) {
+            KLOG("就绪队列为空，系统自动恢复被中断的进程\n");
+            resume_interrupted_process();
+        }
+    }
+}
+
+// ======= 碎片统计 =======
+
+// 登记一个空闲区
+void free_space_add(FreeSpaceStats *fs, int size) {
+    if (size <= 0) return;
+    fs->size_count[size]++;
+    fs->regions++;
+    fs->total += size;
+    fs->classes[std::bit_width((unsigned)size) - 1]++;
+    if (size > fs->largest) {
+        fs->largest = size;
+    }
+}
+
+// 注销一个空闲区；最大空闲区的计数归零时才向下查找新的最大值
+void free_space_remove(FreeSpaceStats *fs, int size) {
+    if (size <= 0) return;
+    fs->size_count[size]--;
+    fs->regions--;
+    fs->total -= size;
+    fs->classes[std::bit_width((unsigned)size) - 1]--;
+    while (fs->largest > 0 && fs->size_count[fs->largest] == 0) {
+        fs->largest--;
+    }
+}
+
+// 外部碎片指数（千分比）：1 - 最大空闲区/空闲总量，0表示空闲空间完全连续
+int fragmentation_permille(const FreeSpaceStats *fs) {
+    if (fs->total == 0) return 0;
+    return (int)(1000 - (long long)fs->largest * 1000 / fs->total);
+}
+
+// 以start开始、长len的空闲段：写首尾边界标记并登记
+static void disk_set_run(int start, int len) {
+    disk_run_len[start] = len;
+    disk_run_len[start + len - 1] = len;
+    free_space_add(&disk_free_space, len);
+}
+
+// 把块从所在空闲段中摘出，剩余的左右两部分各成一段；
+// 顺序分配时块总是段首，无需向左查找
+void disk_mark_allocated(int block) {
+    if (disk[block].is_allocated) return;
+    int start = block;
+    while (start > 0 && !disk[start - 1].is_allocated) {
+        start--;
+    }
+    int end = start + disk_run_len[start] - 1;
+    free_space_remove(&disk_free_space, end - start + 1);
+    disk[block].is_allocated = true;
+    disk_free_blocks--;
+    if (block > start) disk_set_run(start, block - start);
+    if (block < end) disk_set_run(block + 1, end - block);
+}
+
+// 释放块并通过相邻块的边界标记与左右空闲段合并
+void disk_mark_free(int block) {
+    if (!disk[block].is_allocated) return;
+    int left = (block > 0 && !disk[block - 1].is_allocated) ? disk_run_len[block - 1] : 0;
+    int right = (block + 1 < DISK_SIZE/BLOCK_SIZE && !disk[block + 1].is_allocated) ?
+                disk_run_len[block + 1] : 0;
+    free_space_remove(&disk_free_space, left);
+    free_space_remove(&disk_free_space, right);
+    disk[block].is_allocated = false;
+    disk_free_blocks++;
+    disk_set_run(block - left, left + right + 1);
+}
+
+// 块链中的连续段数：下一块不紧接上一块时开始新段
+int chain_runs(int first_block) {
+    int runs = 0;
+    int prev = -2;
+    for (int b = first_block; b != -1; b = disk[b].next_block) {
+        if (b != prev + 1) runs++;
+        prev = b;
+    }
+    return runs;
+}
+
+// 文件块链创建(sign=1)/释放(sign=-1)时更新连续性汇总
+void file_frag_account(const Inode *file, int sign) {
+    if (file->type != FILE_TYPE || file->block_count == 0) return;
+    file_frag.files += sign;
+    file_frag.blocks += sign * file->block_count;
+    file_frag.runs += sign * file->block_runs;
+    if (file->block_runs > 1) {
+        file_frag.fragmented += sign;
+    }
+}
+
+// 内存分配（使用最佳适应算法）
+int allocate_memory(int size, int pid) {
+    MemoryBlock *current = memory;
+    MemoryBlock *best_fit = NULL;
+    int best_size = memory_total + 1; // 初始化为一个很大的值
+
+    // 查找最合适的内存块（最小合适)
+    int searched = 0;
+    while (current != NULL) {
+        searched++;
+        if (!current->is_allocated && current->size >= size && current->size < best_size) {
+            best_fit = current;
+            best_size = current->size;
+        }
+        current = current->next;
+    }
+
+    // 没有找到合适的内存块
+    hist_record(&metric_alloc_search, searched);
+    if (best_fit == NULL) {
+        TRACE(TRACE_MEM_ALLOC, pid, -1, size);
+        metric_alloc_failure++;
+        return -1;
+    }
+
+    // 找到合适的内存块，进行分配
+    int start_address = best_fit->start_address;
+    free_space_remove(&mem_free_space, best_fit->size);
+
+    if (best_fit->size > size) {
+        // 分割内存块
+        MemoryBlock *new_block = (MemoryBlock*)malloc(sizeof(MemoryBlock));
+        new_block->start_address = start_address + size;
+        new_block->size = best_fit->size - size;
+        new_block->is_allocated = false;
+        new_block->pid = -1;
+        new_block->next = best_fit->next;
+        free_space_add(&mem_free_space, new_block->size);
+
+        best_fit->size = size;
+        best_fit->next = new_block;
+    }
+
+    // 分配这个内存块
+    best_fit->is_allocated = true;
+    best_fit->pid = pid;
+    TRACE(TRACE_MEM_ALLOC, pid, start_address, size);
+    metric_alloc_success++;
+
+    return start_address;
+}
+
+// 释放内存
+void free_memory(int pid) {
+    KLOG("尝试释放进程 PID=%d 的内存资源\n", pid);
+    
+    // 第一遍：标记所有要释放的内存块
+    MemoryBlock *current = memory;
+    int freed_blocks = 0;
+    int total_freed_size = 0;
+    
+    while (current != NULL) {
+        if (current->is_allocated && current->pid == pid) {
+            KLOG("释放内存: 地址=%d, 大小=%d\n", current->start_address, current->size);
+            current->is_allocated = false;
+            current->pid = -1;
+            free_space_add(&mem_free_space, current->size);
+            freed_blocks++;
+            total_freed_size += current->size;
+        }
+        current = current->next;
+    }
+    
+    if (freed_blocks == 0) {
+        KLOG("没有找到PID=%d的内存块\n", pid);
+        return;
+    }
+    TRACE(TRACE_MEM_FREE, pid, freed_blocks, total_freed_size);
+    
+    // 第二遍：合并相邻的空闲内存块（循环直到无法继续合并）
+    bool merged;
+    do {
+        merged = false;
+        current = memory;
+        
+        while (current != NULL && current->next != NULL) {
+            if (!current->is_allocated && !current->next->is_allocated) {
+                // 合并当前块和下一个块
+                MemoryBlock *next_block = current->next;
+                KLOG("合并内存块: 地址=%d+%d, 大小=%d+%d\n", 
+                       current->start_address, current->size,
+                       next_block->start_address, next_block->size);
+                
+                free_space_remove(&mem_free_space, current->size);
+                free_space_remove(&mem_free_space, next_block->size);
+                current->size += next_block->size;
+                free_space_add(&mem_free_space, current->size);
+                current->next = next_block->next;
+                
+                // 释放被合并的块
+                node_free(next_block);
+                merged = true;
+                
+                // 不移动当前指针，继续检查是否可以与新的next块合并
+                continue;
+            }
+            
+            // 移动到下一块
+            current = current->next;
+        }
+    } while (merged);
+    
+    KLOG("内存释放完成: 共释放%d个块，总大小%d\n", freed_blocks, total_freed_size);
+    
+    // 打印当前内存状态，帮助调试
+    KLOG("内存块状态检查:\n");
+    current = memory;
+    while (current != NULL) {
+        KLOG("  地址=%d, 大小=%d, 状态=%s, PID=%d\n",
+               current->start_address, current->size,
+               current->is_allocated ? "已分配" : "空闲",
+               current->pid);
+        current = current->next;
+    }
+}
+
+static const char* file_type_name(FileType type) {
+    return type == FILE_TYPE ? "文件" : type == DIRECTORY_TYPE ? "目录" : "符号链接";
+}
+
+// 目录项引用的inode
+Inode* file_inode(const FCB* file) {
+    return &inode_table[file->ino];
+}
+
+// 分配一个inode（链接数为0，由目录项引用后加1）：优先复用空闲槽，表满时倍增
+int inode_alloc(FileType type) {
+    int ino = inode_free_list;
+    if (ino != -1) {
+        inode_free_list = inode_table[ino].next_free;
+    } else {
+        if (inode_slots == inode_capacity) {
+            inode_capacity *= 2;
+            inode_table = (Inode*)realloc(inode_table, inode_capacity * sizeof(Inode));
+        }
+        ino = inode_slots++;
+    }
+    Inode* node = &inode_table[ino];
+    node->type = type;
+    node->links = 0;
+    node->size = 0;
+    node->block_count = 0;
+    node->first_block = -1;
+    node->block_runs = 0;
+    node->next_free = -1;
+    node->create_time = time(NULL);
+    node->modify_time = node->create_time;
+    node->target = NULL;
+    node->entries = NULL;
+    inodes_in_use++;
+    return ino;
+}
+
+// 去掉inode的一个链接；最后一个链接消失时释放数据块并归还槽位
+void inode_put(int ino) {
+    Inode* node = &inode_table[ino];
+    if (--node->links > 0) return;
+    if (ino == defrag_inode) {
+        defrag_inode = 0;
+    }
+    if (node->first_block != -1) {
+        file_frag_account(node, -1);
+        free_disk_block(node->first_block);
+    }
+    free(node->target);
+    node->target = NULL;
+    node->next_free = inode_free_list;
+    inode_free_list = ino;
+    inodes_in_use--;
+}
+
+// 在parent下建立指向inode的目录项，inode链接数加1，子树聚合计入该目录项
+static FCB* link_entry(const char* name, int ino, FCB* parent) {
+    FCB* file = (FCB*)malloc(sizeof(FCB));
+    if (file == NULL) {
+        klog("错误: 内存不足，无法创建%s\n", file_type_name(inode_table[ino].type));
+        return NULL;
+    }
+    
+    Inode* node = &inode_table[ino];
+    node->links++;
+    strncpy(file->name, name, MAX_FILENAME-1);
+    file->name[MAX_FILENAME-1] = '\0';
+    file->type = node->type;
+    file->ino = ino;
+    file->parent = parent;
+    file->child = NULL;
+    file->sibling = NULL;
+    file->next_link = NULL;
+    file->tree_size = 0;
+    file->tree_blocks = 0;
+    file->tree_files = 0;
+    file->tree_dirs = 0;
+    
+    // 添加到父目录的子列表
+    if (parent->child == NULL) {
+        parent->child = file;
+    } else {
+        FCB* sibling = parent->child;
+        while (sibling->sibling != NULL) {
+            sibling = sibling->sibling;
+        }
+        sibling->sibling = file;
+    }
+    // 符号链接不计入子树聚合；文件数按目录项计，大小和块数只计在inode的首个目录项下，
+    // 硬链接排在表头之后，du不会把同一文件的块算多次
+    if (node->type == FILE_TYPE) {
+        bool first = node->entries == NULL;
+        if (first) {
+            node->entries = file;
+        } else {
+            file->next_link = node->entries->next_link;
+            node->entries->next_link = file;
+        }
+        fs_account(file, first ? node->size : 0, first ? node->block_count : 0, 1, 0);
+    } else if (node->type == DIRECTORY_TYPE) {
+        fs_account(file, 0, 0, 0, 1);
+    }
+    
+    file_inode(parent)->modify_time = time(NULL);
+    return file;
+}
+
+// 创建文件节点；失败时返回NULL，status（可为NULL）给出原因
+FCB* create_file(const char* name, FileType type, FCB* parent, OsStatus* status) {
+    OsStatus ignored;
+    if (status == NULL) status = &ignored;
+
+    // 检查同名文件是否已存在
+    FCB* existing = find_file(parent, name);
+    if (existing != NULL) {
+        klog("错误: %s '%s' 已存在\n", file_type_name(type), name);
+        *status = OS_ERR_EXISTS;
+        return NULL;
+    }
+    
+    int ino = inode_alloc(type);
+    FCB* file = link_entry(name, ino, parent);
+    if (file == NULL) {
+        inode_table[ino].links = 1;
+        inode_put(ino);
+        *status = OS_ERR_NO_MEMORY;
+        return NULL;
+    }
+    *status = OS_OK;
+    return file;
+}
+
+// 把子树聚合的变化加到node及其全部祖先上：代价为树深，读取聚合为O(1)
+void fs_account(FCB* node, long long size, int blocks, int files, int dirs) {
+    for (FCB* dir = node; ; dir = dir->parent) {
+        dir->tree_size += size;
+        dir->tree_blocks += blocks;
+        dir->tree_files += files;
+        dir->tree_dirs += dirs;
+        if (dir->parent == dir) break;
+    }
+}
+
+// 分配磁盘块
+int allocate_disk_block(int count) {
+    if (count <= 0) return -1;
+    
+    int first_block = -1;
+    int last_block = -1;
+    int blocks_allocated = 0;
+    
+    // 寻找空闲块并分配
+    for (int i = 0; i < DISK_SIZE/BLOCK_SIZE && blocks_allocated < count; i++) {
+        if (!disk[i].is_allocated) {
+            disk_mark_allocated(i);
+            disk[i].next_block = -1;
+            
+            if (first_block == -1) {
+                first_block = i;
+                last_block = i;
+            } else {
+                disk[last_block].next_block = i;
+                last_block = i;
+            }
+            
+            blocks_allocated++;
+        }
+    }
+    
+    // 如果无法满足请求数量，释放已分配的块
+    if (blocks_allocated < count) {
+        if (first_block != -1) {
+            free_disk_block(first_block);
+        }
+        return -1;
+    }
+    
+    return first_block;
+}
+
+// 释放磁盘块
+void free_disk_block(int first_block) {
+    if (first_block < 0 || first_block >= DISK_SIZE/BLOCK_SIZE) return;
+    
+    int current = first_block;
+    int next;
+    
+    while (current != -1) {
+        if (current >= 0 && current < DISK_SIZE/BLOCK_SIZE) {
+            next = disk[current].next_block;
+            disk_mark_free(current);
+            disk_owner[current] = 0;
+            disk[current].next_block = -1;
+            current = next;
+        } else {
+            break;
+        }
+    }
+}
+
+// node是否在以root为根的子树中
+static bool in_subtree(const FCB* node, const FCB* root) {
+    for (const FCB* dir = node; ; dir = dir->parent) {
+        if (dir == root) return true;
+        if (dir->parent == dir) return false;
+    }
+}
+
+// 从文件inode的目录项链表摘除file；file在表头（承担文件的大小和块数）时，
+// 把它们转给一个不在被删子树doomed中的目录项，被删子树外的祖先已由delete_file扣除
+static void unlink_entry(FCB* file, const FCB* doomed) {
+    Inode* node = file_inode(file);
+    FCB** link = &node->entries;
+    while (*link != file) {
+        link = &(*link)->next_link;
+    }
+    *link = file->next_link;
+    if (link != &node->entries) return;
+    for (FCB** p = &node->entries; *p != NULL; p = &(*p)->next_link) {
+        FCB* heir = *p;
+        if (in_subtree(heir, doomed)) continue;
+        *p = heir->next_link;
+        heir->next_link = node->entries;
+        node->entries = heir;
+        fs_account(heir, node->size, node->block_count, 0, 0);
+        return;
+    }
+}
+
+// 递归释放doomed子树中的文件/目录；祖先的子树聚合由delete_file一次扣除
+static void delete_node(FCB* file, const FCB* doomed) {
+    // 如果是目录，先删除所有子文件/目录
+    if (file->type == DIRECTORY_TYPE) {
+        FCB* child = file->child;
+        while (child != NULL) {
+            FCB* next_child = child->sibling;
+            delete_node(child, doomed);
+            child = next_child;
+        }
+    }
+    
+    // 从父目录中移除
+    FCB* parent = file->parent;
+    if (parent != NULL) {
+        if (parent->child == file) {
+            parent->child = file->sibling;
+        } else {
+            FCB* sibling = parent->child;
+            while (sibling != NULL && sibling->sibling != file) {
+                sibling = sibling->sibling;
+            }
+            if (sibling != NULL) {
+                sibling->sibling = file->sibling;
+            }
+        }
+        
+        file_inode(parent)->modify_time = time(NULL);
+    }
+    
+    // 去掉inode的一个链接（最后一个链接时释放磁盘块），再释放目录项
+    if (file->type == FILE_TYPE) {
+        unlink_entry(file, doomed);
+    }
+    inode_put(file->ino);
+    node_free(file);
+}
+
+// 递归删除文件/目录
+void delete_file(FCB* file) {
+    if (file == NULL) return;
+    if (file->parent != file) {
+        fs_account(file->parent, -file->tree_size, -file->tree_blocks, -file->tree_files, -file->tree_dirs);
+    }
+    delete_node(file, file);
+}
+
+// 查找文件/目录
+FCB* find_file(FCB* dir, const char* name) {
+    if (dir == NULL || name == NULL) return NULL;
+    
+    FCB* child = dir->child;
+    int probes = 0;
+    while (child != NULL) {
+        probes++;
+        if (strcmp(child->name, name) == 0) {
+            hist_record(&metric_find_probes, probes);
+            return child;
+        }
+        child = child->sibling;
+    }
+    
+    hist_record(&metric_find_probes, probes);
+    return NULL;
+}
+
+// 列出目录内容
+void list_directory(FCB* dir) {
+    if (dir == NULL || dir->type != DIRECTORY_TYPE) {
+        klog("错误: 不是有效的目录\n");
+        return;
+    }
+    
+    klog("\n目录 '%s' 的内容:\n", dir->name);
+    klog("类型\t链接\t大小\t块数\t名称\t\t创建时间\n");
+    klog("--------------------------------------------------------------\n");
+    
+    FCB* child = dir->child;
+    while (child != NULL) {
+        const Inode* node = file_inode(child);
+        char time_str[26];
+        ctime_s(time_str, sizeof(time_str), &node->create_time);
+        time_str[24] = '\0'; // 移除换行符
+        
+        klog("%s\t%d\t%d\t%d\t%-16s\t%s",
+               (child->type == FILE_TYPE) ? "文件" : (child->type == DIRECTORY_TYPE) ? "目录" : "链接",
+               node->links,
+               node->size,
+               node->block_count,
+               child->name,
+               time_str);
+        if (child->type == SYMLINK_TYPE) {
+            klog("\t-> %s", node->target);
+        }
+        klog("\n");
+        
+        child = child->sibling;
+    }
+    klog("\n");
+}
+
+// 从start目录出发解析path（以'/'开头时从根目录）。中间的符号链接总是跟随，末级的按follow决定；
+// 链接目标相对于链接所在的目录解析，followed累计已跟随的链接数，超过上限视为成环
+static FCB* walk_path(FCB* start, const char* path, bool follow, int* followed) {
+    FCB* target = path[0] == '/' ? root_directory : start;
+    const char* p = path;
+    while (true) {
+        p += strspn(p, "/");
+        if (*p == '\0') break;
+        size_t len = strcspn(p, "/");
+        char token[MAX_FILENAME];
+        if (len >= sizeof(token)) {
+            klog("错误: 名称 '%.*s' 过长\n", (int)len, p);
+            return NULL;
+        }
+        memcpy(token, p, len);
+        token[len] = '\0';
+        p += len;
+        bool last = p[strspn(p, "/")] == '\0';
+
+        if (target->type != DIRECTORY_TYPE) {
+            klog("错误: '%s' 不是目录\n", target->name);
+            return NULL;
+        }
+        if (strcmp(token, ".") == 0) {
+            // 当前目录，什么都不做
+        } else if (strcmp(token, "..") == 0) {
+            // 上级目录
+            if (target != root_directory) {
+                target = target->parent;
+            }
+        } else {
+            FCB* next = find_file(target, token);
+            if (next == NULL) {
+                klog("错误: '%s' 不存在\n", token);
+                return NULL;
+            }
+            if (next->type == SYMLINK_TYPE && (follow || !last)) {
+                if (++*followed > SYMLINK_MAX_FOLLOW) {
+                    klog("错误: 解析 '%s' 时跟随的符号链接超过 %d 层（可能成环）\n", token, SYMLINK_MAX_FOLLOW);
+                    return NULL;
+                }
+                next = walk_path(target, file_inode(next)->target, true, followed);
+                if (next == NULL) return NULL;
+            }
+            target = next;
+        }
+    }
+    return target;
+}
+
+// 解析路径（绝对或相对于当前目录），末级可以是文件；follow为假时末级的符号链接本身作为结果。
+// 不存在时输出错误并返回NULL
+FCB* resolve_path(const char* path, bool follow) {
+    if (path == NULL || strlen(path) == 0) {
+        return current_directory;
+    }
+    int followed = 0;
+    return walk_path(current_directory, path, follow, &followed);
+}
+
+// 根据路径切换目录
+FCB* change_directory(const char* path) {
+    FCB* target = resolve_path(path, true);
+    if (target != NULL && target->type != DIRECTORY_TYPE) {
+        klog("错误: '%s' 不是目录\n", target->name);
+        return NULL;
+    }
+    return target;
+}
+
+// 节点的绝对路径：自底向上从缓冲区末尾填入各级名称，过长时保留末尾部分并以...开头
+void file_path(const FCB* node, char* buf, size_t size) {
+    char* p = buf + size - 1;
+    *p = '\0';
+    for (; node->parent != node; node = node->parent) {
+        size_t len = strlen(node->name);
+        if ((size_t)(p - buf) < len + 1 + 3) {
+            p -= 3;
+            memcpy(p, "...", 3);
+            break;
+        }
+        p -= len;
+        memcpy(p, node->name, len);
+        *--p = '/';
+    }
+    if (*p == '\0') {
+        *--p = '/';
+    }
+    memmove(buf, p, strlen(p) + 1);
+}
+
+// ======= 文件系统命令实现 =======
+
+// 创建文件命令
+OsStatus create_file_command(const char* name, int size) {
+    if (size <= 0) {
+        klog("错误: 文件大小必须大于零\n");
+        return OS_ERR_INVALID;
+    }
+    
+    // 计算所需块数（向上取整）
+    int blocks_needed = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    
+    if (blocks_needed > MAX_FILE_BLOCKS) {
+        klog("错误: 文件过大，超过最大允许大小\n");
+        return OS_ERR_INVALID;
+    }
+    
+    // 创建文件节点
+    OsStatus status;
+    FCB* file = create_file(name, FILE_TYPE, current_directory, &status);
+    if (file == NULL) {
+        return status;
+    }
+    
+    // ���配磁盘块
+    int first_block = allocate_disk_block(blocks_needed);
+    if (first_block == -1) {
+        klog("错误: 磁盘空间不足，无法分配%d个块\n", blocks_needed);
+        delete_file(file);
+        return OS_ERR_NO_SPACE;
+    }
+    
+    Inode* node = file_inode(file);
+    node->size = size;
+    node->block_count = blocks_needed;
+    node->first_block = first_block;
+    node->block_runs = chain_runs(first_block);
+    fs_account(file, size, blocks_needed, 0, 0);
+    file_frag_account(node, 1);
+    for (int b = first_block; b != -1; b = disk[b].next_block) {
+        disk_owner[b] = file->ino;
+    }
+    submit_block_chain(first_block, true);  // 写入文件数据块
+    
+    klog("文件 '%s' 已创建，大小: %d 字节，占用 %d 个磁盘块（%d 个连续段）\n",
+           name, size, blocks_needed, node->block_runs);
+    return OS_OK;
+}
+
+// 创建目录命令
+OsStatus create_directory_command(const char* name) {
+    OsStatus status;
+    FCB* dir = create_file(name, DIRECTORY_TYPE, current_directory, &status);
+    if (dir != NULL) {
+        klog("目录 '%s' 已创建\n", name);
+    }
+    return status;
+}
+
+// 删除文件命令
+OsStatus delete_file_command(const char* name) {
+    FCB* file = find_file(current_directory, name);
+    if (file == NULL) {
+        klog("错误: 文件 '%s' 不存在\n", name);
+        return OS_ERR_NOT_FOUND;
+    }
+    
+    if (file->type == DIRECTORY_TYPE) {
+        klog("错误: '%s' 是一个目录，请使用 rmdir 命令\n", name);
+        return OS_ERR_WRONG_TYPE;
+    }
+    
+    int remaining = file_inode(file)->links - 1;
+    delete_file(file);
+    if (remaining > 0) {
+        klog("文件 '%s' 已删除（inode 还有 %d 个链接）\n", name, remaining);
+    } else {
+        klog("文件 '%s' 已删除\n", name);
+    }
+    return OS_OK;
+}
+
+// 删除目录命令
+OsStatus delete_directory_command(const char* name) {
+    FCB* dir = find_file(current_directory, name);
+    if (dir == NULL) {
+        klog("错误: 目录 '%s' 不存在\n", name);
+        return OS_ERR_NOT_FOUND;
+    }
+    
+    if (dir->type != DIRECTORY_TYPE) {
+        klog("错误: '%s' 是一个文件，请使用 rm 命令\n", name);
+        return OS_ERR_WRONG_TYPE;
+    }
+    
+    if (dir->child != NULL) {
+        klog("警告: 目录 '%s' 不为空，将删除其所有内容\n", name);
+    }
+    
+    delete_file(dir);
+    klog("目录 '%s' 已删除\n", name);
+    return OS_OK;
+}
+
+// 在当前目录建立名为name的链接：硬链接指向target的inode；
+// 符号链接原样保存目标路径，使用时才解析
+OsStatus link_file(const char* target, const char* name, bool symbolic) {
+    if (strchr(name, '/') != NULL || strlen(name) >= MAX_FILENAME ||
+        strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+        klog("错误: 链接名 '%s' 无效（须为当前目录下少于 %d 个字符的名称）\n", name, MAX_FILENAME);
+        return OS_ERR_INVALID;
+    }
+    
+    if (symbolic) {
+        OsStatus status;
+        FCB* link = create_file(name, SYMLINK_TYPE, current_directory, &status);
+        if (link == NULL) return status;
+        Inode* node = file_inode(link);
+        node->target = strdup(target);
+        node->size = (int)strlen(target);
+        klog("符号链接 '%s' -> '%s' 已创建\n", name, target);
+        return OS_OK;
+    }
+    
+    // 硬链接不跟随末级的符号链接：对符号链接做硬链接得到同一个符号链接inode
+    FCB* source = resolve_path(target, false);
+    if (source == NULL) return OS_ERR_NOT_FOUND;
+    if (source->type == DIRECTORY_TYPE) {
+        klog("错误: 不能为目录 '%s' 创建硬链接\n", target);
+        return OS_ERR_WRONG_TYPE;
+    }
+    if (find_file(current_directory, name) != NULL) {
+        klog("错误: '%s' 已存在\n", name);
+        return OS_ERR_EXISTS;
+    }
+    FCB* link = link_entry(name, source->ino, current_directory);
+    if (link == NULL) {
+        return OS_ERR_NO_MEMORY;
+    }
+    klog("硬链接 '%s' -> '%s' 已创建，inode %d 现有 %d 个链接\n",
+           name, target, link->ino, file_inode(link)->links);
+    return OS_OK;
+}
+
+// 列出当前目录内容
+void list_command() {
+    list_directory(current_directory);
+}
+
+// 切换目录命令
+OsStatus change_directory_command(const char* path) {
+    if (path == NULL || strlen(path) == 0) {
+        // 无参数时切换到根目录
+        current_directory = root_directory;
+        klog("已切换到根目录\n");
+        return OS_OK;
+    }
+    
+    FCB* new_dir = change_directory(path);
+    if (new_dir == NULL) {
+        return OS_ERR_NOT_FOUND;
+    }
+    current_directory = new_dir;
+    klog("已切换到目录 '%s'\n", path);
+    return OS_OK;
+}
+
+// ======= 目录树遍历：tree/du/find =======
+
+// 打印dir的子节点，prefix为各级祖先留下的竖线/空白
+static void tree_print(const FCB* dir, char* prefix, size_t prefix_len, int depth) {
+    for (const FCB* child = dir->child; child != NULL; child = child->sibling) {
+        bool last = child->sibling == NULL;
+        if (child->type == DIRECTORY_TYPE) {
+            klog("%s%s%s/  (%lld 字节, %d 个文件)\n", prefix, last ? "└── " : "├── ",
+                   child->name, child->tree_size, child->tree_files);
+            if (child->child == NULL) continue;
+            if (depth + 1 >= TREE_MAX_DEPTH) {
+                klog("%s%s└── ...\n", prefix, last ? "    " : "│   ");
+                continue;
+            }
+            size_t len = strlen(prefix);
+            strcpy(prefix + len, last ? "    " : "│   ");
+            tree_print(child, prefix, prefix_len, depth + 1);
+            prefix[len] = '\0';
+        } else {
+            const Inode* node = file_inode(child);
+            if (child->type == SYMLINK_TYPE) {
+                klog("%s%s%s -> %s\n", prefix, last ? "└── " : "├── ", child->name, node->target);
+            } else {
+                klog("%s%s%s  (%d 字节)\n", prefix, last ? "└── " : "├── ", child->name, node->size);
+            }
+        }
+    }
+}
+
+// tree [path]：以树形显示目录的全部内容，目录后附子树总大小
+OsStatus tree_command(const char* path) {
+    FCB* dir = resolve_path(path, true);
+    if (dir == NULL) return OS_ERR_NOT_FOUND;
+    if (dir->type != DIRECTORY_TYPE) {
+        klog("错误: '%s' 不是目录\n", dir->name);
+        return OS_ERR_WRONG_TYPE;
+    }
+    char name[FILE_MAX_PATH];
+    file_path(dir, name, sizeof(name));
+    klog("%s\n", name);
+    char prefix[TREE_MAX_DEPTH * 6 + 1] = "";   // 每级最多一个"│   "（6字节）
+    tree_print(dir, prefix, sizeof(prefix), 0);
+    klog("\n%d 个目录, %d 个文件, 共 %lld 字节\n", dir->tree_dirs - 1, dir->tree_files, dir->tree_size);
+    return OS_OK;
+}
+
+// du [path]：读取增量维护的子树聚合，与子树大小无关；文件直接读inode（硬链接的聚合只在首个目录项下）
+OsStatus disk_usage(const char* path, OsDiskUsage* usage) {
+    FCB* node = resolve_path(path, true);
+    if (node == NULL) return OS_ERR_NOT_FOUND;
+    file_path(node, usage->path, sizeof(usage->path));
+    usage->directory = node->type == DIRECTORY_TYPE;
+    usage->size = node->tree_size;
+    usage->blocks = node->tree_blocks;
+    usage->files = node->tree_files;
+    usage->directories = node->tree_dirs - 1;
+    if (node->type == FILE_TYPE) {
+        usage->size = file_inode(node)->size;
+        usage->blocks = file_inode(node)->block_count;
+    }
+    usage->allocated = (long long)usage->blocks * BLOCK_SIZE;
+    return OS_OK;
+}
+
+// 通配符匹配：*匹配任意串，?匹配任意一个字符，[abc]/[a-z]/[!abc]匹配字符集
+static bool glob_match(const char* pattern, const char* name) {
+    const char* star = NULL;     // 最近一个*之后的模式位置
+    const char* resume = NULL;   // 该*当前吞到的名字位置
+    while (*name != '\0') {
+        bool matched = false;
+        const char* next = pattern + 1;
+        if (*pattern == '?') {
+            matched = true;
+        } else if (*pattern == '[') {
+            const char* p = pattern + 1;
+            bool negate = *p == '!';
+            if (negate) p++;
+            bool in_set = false;
+            for (bool first = true; *p != '\0' && (first || *p != ']'); first = false, p++) {
+                if (p[1] == '-' && p[2] != '\0' && p[2] != ']') {
+                    in_set |= *name >= p[0] && *name <= p[2];
+                    p += 2;
+                } else {
+                    in_set |= *name == *p;
+                }
+            }
+            if (*p == ']') {
+                matched = in_set != negate;
+                next = p + 1;
+            } else {
+                matched = *name == '[';   // 没有闭合的]：按普通字符处理
+            }
+        } else if (*pattern == '*') {
+            star = ++pattern;
+            resume = name;
+            continue;
+        } else {
+            matched = *pattern == *name;
+        }
+        if (matched && *pattern != '\0') {
+            pattern = next;
+            name++;
+        } else if (star != NULL) {
+            pattern = star;
+            name = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (*pattern == '*') pattern++;
+    return *pattern == '\0';
+}
+
+// find的工作线程：自己的目录队列从尾部取（深度优先），空闲时从其他线程的队列头部窃取
+typedef struct {
+    FCB** dirs;
+    int head, tail, capacity;       // 队列中为[head, tail)
+    CRITICAL_SECTION lock;
+    FCB** matches;
+    int match_count, match_capacity;
+    long long visited;              // 遍历的目录数
+    struct FindPool* pool;
+} FindWorker;
+
+typedef struct FindPool {
+    FindWorker* workers;
+    int count;
+    const char* pattern;
+    volatile LONG pending;          // 已入队但尚未遍历完的目录数，归零即结束
+} FindPool;
+
+static void find_push(FindWorker* w, FCB* dir) {
+    EnterCriticalSection(&w->lock);
+    if (w->tail == w->capacity) {
+        // 先把剩余元素移到开头，仍然满时扩容
+        int live = w->tail - w->head;
+        memmove(w->dirs, w->dirs + w->head, live * sizeof(FCB*));
+        w->head = 0;
+        w->tail = live;
+        if (live == w->capacity) {
+            w->capacity *= 2;
+            w->dirs = (FCB**)realloc(w->dirs, w->capacity * sizeof(FCB*));
+        }
+    }
+    w->dirs[w->tail++] = dir;
+    LeaveCriticalSection(&w->lock);
+}
+
+static FCB* find_take(FindPool* pool, int self) {
+    FindWorker* own = &pool->workers[self];
+    FCB* dir = NULL;
+    EnterCriticalSection(&own->lock);
+    if (own->tail > own->head) {
+        dir = own->dirs[--own->tail];
+    }
+    LeaveCriticalSection(&own->lock);
+    for (int i = 1; dir == NULL && i < pool->count; i++) {
+        FindWorker* victim = &pool->workers[(self + i) % pool->count];
+        EnterCriticalSection(&victim->lock);
+        if (victim->tail > victim->head) {
+            dir = victim->dirs[victim->head++];
+        }
+        LeaveCriticalSection(&victim->lock);
+    }
+    return dir;
+}
+
+static void find_add_match(FindWorker* w, FCB* node) {
+    if (w->match_count == w->match_capacity) {
+        w->match_capacity = w->match_capacity > 0 ? w->match_capacity * 2 : 64;
+        w->matches = (FCB**)realloc(w->matches, w->match_capacity * sizeof(FCB*));
+    }
+    w->matches[w->match_count++] = node;
+}
+
+// 工作线程只读目录树（命令执行期间持有内核锁，树不会变化），不访问内核状态
+static unsigned __stdcall find_worker_func(void* arg) {
+    FindWorker* w = (FindWorker*)arg;
+    FindPool* pool = w->pool;
+    int self = (int)(w - pool->workers);
+    while (true) {
+        FCB* dir = find_take(pool, self);
+        if (dir == NULL) {
+            // 原子读：其他线程可能正在把子目录入队
+            if (InterlockedCompareExchange(&pool->pending, 0, 0) == 0) break;
+            SwitchToThread();
+            continue;
+        }
+        w->visited++;
+        for (FCB* child = dir->child; child != NULL; child = child->sibling) {
+            if (glob_match(pool->pattern, child->name)) {
+                find_add_match(w, child);
+            }
+            if (child->type == DIRECTORY_TYPE && child->child != NULL) {
+                InterlockedIncrement(&pool->pending);
+                find_push(w, child);
+            }
+        }
+        InterlockedDecrement(&pool->pending);
+    }
+    return 0;
+}
+
+static int compare_paths(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// find [path] -name <glob>：按名称匹配子树中的文件和目录，结果按路径排序。
+// 子树较大时在多个线程上做窃取式遍历
+OsStatus find_files(const char* path, const char* pattern) {
+    FCB* start = resolve_path(path[0] != '\0' ? path : ".", true);
+    if (start == NULL) return OS_ERR_NOT_FOUND;
+
+    long long begin = now_ns();
+    int threads = 1;
+    if (start->tree_files + start->tree_dirs >= FIND_PARALLEL_MIN) {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        threads = (int)info.dwNumberOfProcessors;
+        if (threads > FIND_MAX_THREADS) threads = FIND_MAX_THREADS;
+        if (threads < 1) threads = 1;
+    }
+
+    FindPool pool;
+    pool.workers = (FindWorker*)calloc(threads, sizeof(FindWorker));
+    pool.count = threads;
+    pool.pattern = pattern;
+    pool.pending = 0;
+    for (int i = 0; i < threads; i++) {
+        FindWorker* w = &pool.workers[i];
+        w->capacity = 64;
+        w->dirs = (FCB**)malloc(w->capacity * sizeof(FCB*));
+        InitializeCriticalSection(&w->lock);
+        w->pool = &pool;
+    }
+    if (glob_match(pattern, start->name)) {
+        find_add_match(&pool.workers[0], start);
+    }
+    if (start->type == DIRECTORY_TYPE) {
+        pool.pending = 1;
+        find_push(&pool.workers[0], start);
+    }
+
+    HANDLE handles[FIND_MAX_THREADS];
+    int started = 0;
+    for (int i = 1; i < threads; i++) {
+        handles[started] = (HANDLE)_beginthreadex(NULL, 0, find_worker_func, &pool.workers[i], 0, NULL);
+        if (handles[started] == NULL) break;
+        started++;
+    }
+    find_worker_func(&pool.workers[0]);   // 当前线程也参与遍历
+    for (int i = 0; i < started; i++) {
+        WaitForSingleObject(handles[i], INFINITE);
+        CloseHandle(handles[i]);
+    }
+
+    // 汇总各线程的结果并按路径排序，输出与线程数无关
+    int total = 0;
+    long long visited = 0;
+    for (int i = 0; i < threads; i++) {
+        total += pool.workers[i].match_count;
+        visited += pool.workers[i].visited;
+    }
+    char** paths = (char**)malloc((total > 0 ? total : 1) * sizeof(char*));
+    int n = 0;
+    for (int i = 0; i < threads; i++) {
+        FindWorker* w = &pool.workers[i];
+        for (int j = 0; j < w->match_count; j++) {
+            char buf[FILE_MAX_PATH];
+            file_path(w->matches[j], buf, sizeof(buf));
+            if (w->matches[j]->type == DIRECTORY_TYPE && w->matches[j] != root_directory) {
+                strncat(buf, "/", sizeof(buf) - strlen(buf) - 1);
+            }
+            paths[n++] = strdup(buf);
+        }
+        free(w->matches);
+        free(w->dirs);
+        DeleteCriticalSection(&w->lock);
+    }
+    qsort(paths, n, sizeof(char*), compare_paths);
+    for (int i = 0; i < n; i++) {
+        klog("%s\n", paths[i]);
+        free(paths[i]);
+    }
+    free(paths);
+    free(pool.workers);
+    klog("find: %d 个匹配，遍历 %lld 个目录，%d 个线程，用时 %.3f ms\n",
+           total, visited, started + 1, (now_ns() - begin) / 1e6);
+    return OS_OK;
+}
+
+// 显示磁盘使用情况
+void display_disk() {
+    int total_blocks = DISK_SIZE / BLOCK_SIZE;
+    int free_blocks = disk_free_blocks;
+    int used_blocks = total_blocks - free_blocks;
+    
+    klog("\n===== 磁盘使用情况 =====\n");
+    klog("总块数: %d\n", total_blocks);
+    klog("已用块数: %d (%.2f%%)\n", used_blocks, 100.0 * used_blocks / total_blocks);
+    klog("空闲块数: %d (%.2f%%)\n", free_blocks, 100.0 * free_blocks / total_blocks);
+    klog("块大小: %d 字节\n", BLOCK_SIZE);
+    klog("总容量: %d 字节\n", DISK_SIZE);
+    klog("已用容量: %d 字节\n", used_blocks * BLOCK_SIZE);
+    klog("可用容量: %d 字节\n", free_blocks * BLOCK_SIZE);
+    klog("空闲段数: %d, 最大连续空闲段: %d 块, 外部碎片指数: %.3f\n",
+           disk_free_space.regions, disk_free_space.largest,
+           fragmentation_permille(&disk_free_space) / 1000.0);
+    if (file_frag.files > 0) {
+        klog("文件: %lld 个, 平均 %.2f 段/文件, 不连续 %lld 个\n",
+               file_frag.files, (double)file_frag.runs / file_frag.files, file_frag.fragmented);
+    }
+
+    klog("\n磁盘几何: %d 柱面 x %d 扇区, 旋转一周 %d us\n",
+           DISK_CYLINDERS, DISK_SECTORS_PER_TRACK, DISK_ROTATION_US);
+    klog("磁头调度: %s, 磁头位于柱面 %d (方向 %s), 等待请求 %d\n",
+           disk_policy_names[disk_policy], disk_head.cylinder,
+           disk_head.direction > 0 ? "向外" : "向内", devices[find_device("disk")].queue_length);
+    klog("算法\t请求数\t总寻道距离\t平均寻道距离\t平均服务(us)\t(寻道/旋转/传输)\t平均排队(时钟)\n");
+    for (int p = 0; p < NUM_DISK_POLICIES; p++) {
+        DiskPolicyStats *stats = &disk_stats[p];
+        if (stats->requests == 0) continue;
+        double n = (double)stats->requests;
+        klog("%s\t%lld\t%lld\t\t%.2f\t\t%.1f\t\t(%.1f/%.1f/%.1f)\t%.2f\n",
+               disk_policy_names[p], stats->requests, stats->seek_distance,
+               stats->seek_distance / n,
+               (stats->seek_us + stats->rotation_us + stats->transfer_us) / n,
+               stats->seek_us / n, stats->rotation_us / n, stats->transfer_us / n,
+               stats->wait_ticks / n);
+    }
+    klog("==========================\n\n");
+}
+
+// 清理系统资源
+// 释放内核的全部状态：进程、设备请求、事件、内存链表与文件系统等
+void kernel_destroy(Kernel *k) {
+    kernel = k;
+
+    // 释放页表和共享页框的反向映射
+    for (int pid = 0; pid < pid_table_size; pid++) {
+        if (pid_table[pid] != NULL) {
+            free(pid_table[pid]->page_table);
+        }
+    }
+    for (int f = 0; f < NUM_FRAMES; f++) {
+        while (frames[f].shared != NULL) {
+            FrameMapping *next = frames[f].shared->next;
+            free(frames[f].shared);
+            frames[f].shared = next;
+        }
+    }
+
+    // 释放所有进程资源
+    if (running_process != NULL) {
+        node_free(running_process);
+        running_process = NULL;
+    }
+
+    // 清理设备请求队列（进程本身随各队列释放）
+    for (int d = 0; d < NUM_DEVICES; d++) {
+        node_free(devices[d].current);
+        devices[d].current = NULL;
+        while (devices[d].queue_head != NULL) {
+            IORequest *req = devices[d].queue_head;
+            devices[d].queue_head = req->next;
+            node_free(req);
+        }
+        devices[d].queue_tail = NULL;
+        devices[d].queue_length = 0;
+    }
+
+    // 清理就绪队列
+    PCB *temp_proc;
+    while ((temp_proc = remove_from_ready_queue()) != NULL) {
+        node_free(temp_proc);
+    }
+    free(sjf_heap.items);
+    sjf_heap.items = NULL;
+    sjf_heap.size = sjf_heap.capacity = 0;
+
+    // 清理实时进程
+    while ((temp_proc = heap_pop(&edf_heap)) != NULL) {
+        node_free(temp_proc);
+    }
+    while ((temp_proc = heap_pop(&edf_release_heap)) != NULL) {
+        node_free(temp_proc);
+    }
+    free(edf_heap.items);
+    free(edf_release_heap.items);
+    edf_heap.items = edf_release_heap.items = NULL;
+    edf_heap.capacity = edf_release_heap.capacity = 0;
+
+    // 清理阻塞队列
+    while (blocked_queue != NULL) {
+        PCB *temp = blocked_queue;
+        blocked_queue = blocked_queue->next;
+        node_free(temp);
+    }
+    free(pid_table);
+    pid_table = NULL;
+    pid_table_size = 0;
+
+    // 清理未处理的事件
+    while (event_count > 0) {
+        SimEvent ev = pop_event();
+        free(ev.command);
+    }
+    free(event_queue);
+    event_queue = NULL;
+    event_capacity = 0;
+    for (int t = 0; t < NUM_INTERRUPT_TYPES; t++) {
+        free(pending_heaps[t].items);
+        memset(&pending_heaps[t], 0, sizeof(InterruptHeap));
+    }
+    pending_count = 0;
+    while (pending_creates != NULL) {
+        PendingCreate *next = pending_creates->next;
+        free(pending_creates);
+        pending_creates = next;
+    }
+    pending_creates_tail = NULL;
+    for (int r = 0; r < num_resources; r++) {
+        free(resources[r].holders);
+    }
+    num_resources = 0;
+    while (sync_objects != NULL) {
+        SyncObject *next = sync_objects->next;
+        free(sync_objects);
+        sync_objects = next;
+    }
+    while (shm_segments != NULL) {
+        ShmSegment *next = shm_segments->next;
+        free(shm_segments->channel);
+        free(shm_segments->data);
+        free(shm_segments);
+        shm_segments = next;
+    }
+
+    // 清理内存链表
+    while (memory != NULL) {
+        MemoryBlock *temp = memory;
+        memory = memory->next;
+        node_free(temp);
+    }
+
+    // 清理文件系统
+    if (root_directory != NULL) {
+        delete_file(root_directory);
+        root_directory = NULL;
+        current_directory = NULL;
+    }
+    free(inode_table);
+
+    free(mem_free_size_count);
+    free(k);
+    kernel = NULL;
+}
+
+// 设置调度算法
+void set_schedule_algorithm(ScheduleAlgorithm algorithm) {
+    // 先按原算法取出所有进程（保持原有出队顺序）
+    PCB* temp_head = NULL;
+    PCB* temp_tail = NULL;
+    PCB* proc;
+    while ((proc = remove_from_ready_queue()) != NULL) {
+        if (temp_tail == NULL) {
+            temp_head = proc;
+        } else {
+            temp_tail->next = proc;
+        }
+        temp_tail = proc;
+    }
+
+    current_algorithm = algorithm;
+    klog("调度算法已设置为: %s\n", get_algorithm_name(algorithm));
+
+    // 重建采用批量装载，避免逐个有序插入的O(n^2)
+    // 切换到多级反馈队列时，所有进程从最高级开始
+    if (algorithm == MLFQ) {
+        for (proc = temp_head; proc != NULL; proc = proc->next) {
+            proc->mlfq_level = 0;
+            proc->quantum_left = mlfq_quantum[0];
+        }
+        if (running_process != NULL) {
+            running_process->mlfq_level = 0;
+            running_process->quantum_left = mlfq_quantum[0];
+        }
+        mlfq_last_boost = time_counter;
+    }
+    if (algorithm == RR && running_process != NULL) {
+        running_process->quantum_left = RR_QUANTUM;
+    }
+
+    // 再按照新算法重新装载
+    load_ready_queue(temp_head);
+}
+
+// 按当前算法批量装载就绪队列：列表O(n)，优先级归并排序O(n log n)，堆O(n)建堆
+void load_ready_queue(PCB *list) {
+    switch (current_algorithm) {
+        case MLFQ:
+            while (list != NULL) {
+                PCB *proc = list;
+                list = list->next;
+                mlfq_enqueue(proc);
+            }
+            break;
+
+        case SJF:
+        case SRTF:
+            while (list != NULL) {
+                PCB *proc = list;
+                list = list->next;
+                proc->next = NULL;
+                heap_reserve(&sjf_heap, sjf_heap.size + 1);
+                proc->heap_index = sjf_heap.size;
+                sjf_heap.items[sjf_heap.size++] = proc;
+            }
+            heap_build(&sjf_heap);
+            break;
+
+        case CFS:
+            while (list != NULL) {
+                PCB *proc = list;
+                list = list->next;
+                cfs_enqueue(proc);
+            }
+            break;
+
+        case PRIORITY:
+            list = sort_by_priority(list);
+            // fall through
+        case FCFS:
+        case RR:
+        default:
+            ready_queue = list;
+            ready_tail = list;
+            ready_list_count = list != NULL ? 1 : 0;
+            while (ready_tail != NULL && ready_tail->next != NULL) {
+                ready_tail = ready_tail->next;
+                ready_list_count++;
+            }
+            break;
+    }
+}
+
+// 按优先级稳定归并排序链表
+PCB* sort_by_priority(PCB *list) {
+    if (list == NULL || list->next == NULL) {
+        return list;
+    }
+
+    // 快慢指针二分
+    PCB *slow = list;
+    PCB *fast = list->next;
+    while (fast != NULL && fast->next != NULL) {
+        slow = slow->next;
+        fast = fast->next->next;
+    }
+    PCB *right = slow->next;
+    slow->next = NULL;
+
+    PCB *a = sort_by_priority(list);
+    PCB *b = sort_by_priority(right);
+
+    // 合并，优先级相同时保持原顺序
+    PCB head;
+    PCB *tail = &head;
+    while (a != NULL && b != NULL) {
+        if (b->priority < a->priority) {
+            tail->next = b;
+            b = b->next;
+        } else {
+            tail->next = a;
+            a = a->next;
+        }
+        tail = tail->next;
+    }
+    tail->next = (a != NULL) ? a : b;
+    return head.next;
+}
+
+// 获取调度算法名称
+const char* get_algorithm_name(ScheduleAlgorithm algorithm) {
+    switch (algorithm) {
+        case FCFS: return "先来先服务 (FCFS)";
+        case PRIORITY: return "优先级调度 (Priority)";
+        case RR: return "时间片轮转 (Round Robin)";
+        case MLFQ: return "多级反馈队列 (MLFQ)";
+        case SJF: return "短作业优先 (SJF)";
+        case SRTF: return "最短剩余时间优先 (SRTF)";
+        case CFS: return "完全公平调度 (CFS)";
+        default: return "未知算法";
+    }
+}
+
+// 添加进程到就绪队列（按优先级排序）
+void add_to_ready_queue(PCB *proc) {
+    if (proc == NULL) return;
+    proc->next = NULL;
+
+    // 实时进程进入EDF堆，不受普通调度算法影响
+    if (is_rt(proc)) {
+        heap_push(&edf_heap, proc);
+        return;
+    }
+
+    // 多级反馈队列使用独立的分级队列
+    if (current_algorithm == MLFQ) {
+        mlfq_enqueue(proc);
+        return;
+    }
+
+    // SJF/SRTF使用按预测CPU区间排序的堆
+    if (current_algorithm == SJF || current_algorithm == SRTF) {
+        heap_push(&sjf_heap, proc);
+        return;
+    }
+
+    // CFS使用按vruntime排序的红黑树
+    if (current_algorithm == CFS) {
+        cfs_enqueue(proc);
+        return;
+    }
+    
+    ready_list_count++;
+
+    // 如果就绪队列为空
+    if (ready_queue == NULL) {
+        ready_queue = proc;
+        ready_tail = proc;
+        return;
+    }
+    
+    switch (current_algorithm) {
+        case PRIORITY: {
+            // 优先级调度：根据优先级插入（优先级低的数字大）
+            if (proc->priority < ready_queue->priority) {
+                // 如果新进程优先级高于队首
+                proc->next = ready_queue;
+                ready_queue = proc;
+            } else if (proc->priority >= ready_tail->priority) {
+                // 不高于队尾，直接追加
+                ready_tail->next = proc;
+                ready_tail = proc;
+            } else {
+                // 找到合适的位置插入
+                PCB *current = ready_queue;
+                PCB *prev = NULL;
+                
+                while (current != NULL && proc->priority >= current->priority) {
+                    prev = current;
+                    current = current->next;
+                }
+                
+                proc->next = current;
+                if (prev != NULL) {
+                    prev->next = proc;
+                }
+            }
+            break;
+        }
+            
+        case FCFS:
+        case RR:
+        default: {
+            // 先来先服务/时间片轮转：添加到队列尾部
+            ready_tail->next = proc;
+            ready_tail = proc;
+            break;
+        }
+    }
+}
+
+// 从就绪队列中移除并返回进程 - 根据调度算法调整
+PCB* remove_from_ready_queue() {
+    if (current_algorithm == MLFQ) {
+        return mlfq_dequeue();
+    }
+    if (current_algorithm == SJF || current_algorithm == SRTF) {
+        return heap_pop(&sjf_heap);
+    }
+    if (current_algorithm == CFS) {
+        PCB *proc = cfs_leftmost;
+        if (proc != NULL) {
+            cfs_dequeue(proc);
+        }
+        return proc;
+    }
+
+    if (ready_queue == NULL) {
+        return NULL;
+    }
+    
+    // 不管哪种调度算法，都是从队首取出进程
+    // 因为在add_to_ready_queue已经按照各自算法排序好了
+    PCB *proc = ready_queue;
+    ready_queue = ready_queue->next;
+    if (ready_queue == NULL) {
+        ready_tail = NULL;
+    }
+    ready_list_count--;
+    proc->next = NULL;
+    return proc;
+}
+
+// 从就绪队列中移除指定PID的进程
+PCB* remove_pid_from_ready_queue(int pid) {
+    // 实时进程：就绪堆或等待下一周期的释放堆
+    PCBHeap *rt_heaps[2] = {&edf_heap, &edf_release_heap};
+    for (int h = 0; h < 2; h++) {
+        for (int i = 0; i < rt_heaps[h]->size; i++) {
+            if (rt_heaps[h]->items[i]->pid == pid) {
+                PCB *proc = rt_heaps[h]->items[i];
+                heap_remove(rt_heaps[h], proc);
+                return proc;
+            }
+        }
+    }
+
+    if (current_algorithm == MLFQ) {
+        // 在各级队列中查找
+        for (int level = 0; level < MLFQ_LEVELS; level++) {
+            PCB *prev = NULL;
+            for (PCB *p = mlfq_head[level]; p != NULL; prev = p, p = p->next) {
+                if (p->pid != pid) continue;
+
+                if (prev == NULL) {
+                    mlfq_head[level] = p->next;
+                } else {
+                    prev->next = p->next;
+                }
+                if (mlfq_tail[level] == p) {
+                    mlfq_tail[level] = prev;
+                }
+                if (--mlfq_depth[level] == 0) {
+                    mlfq_bitmap &= ~(1u << level);
+                }
+                p->next = NULL;
+                return p;
+            }
+        }
+        return NULL;
+    }
+
+    if (current_algorithm == SJF || current_algorithm == SRTF) {
+        for (int i = 0; i < sjf_heap.size; i++) {
+            if (sjf_heap.items[i]->pid == pid) {
+                PCB *proc = sjf_heap.items[i];
+                heap_remove(&sjf_heap, proc);
+                return proc;
+            }
+        }
+        return NULL;
+    }
+
+    if (current_algorithm == CFS) {
+        for (PCB *p = cfs_leftmost; p != NULL; p = cfs_next(p)) {
+            if (p->pid == pid) {
+                cfs_dequeue(p);
+                return p;
+            }
+        }
+        return NULL;
+    }
+
+    PCB *prev = NULL;
+    PCB *current = ready_queue;
+    while (current != NULL && current->pid != pid) {
+        prev = current;
+        current = current->next;
+    }
+    if (current == NULL) {
+        return NULL;
+    }
+
+    if (prev == NULL) {
+        ready_queue = current->next; // 当前是头节点
+    } else {
+        prev->next = current->next; // 更新链表
+    }
+    if (ready_tail == current) {
+        ready_tail = prev;
+    }
+    current->next = NULL;
+    ready_list_count--;
+    return current;
+}
+
+// 多级反馈队列：加入所在级别队尾
+void mlfq_enqueue(PCB *proc) {
+    int level = proc->mlfq_level;
+    proc->next = NULL;
+    if (mlfq_tail[level] == NULL) {
+        mlfq_head[level] = proc;
+    } else {
+        mlfq_tail[level]->next = proc;
+    }
+    mlfq_tail[level] = proc;
+    mlfq_depth[level]++;
+    mlfq_bitmap |= 1u << level;
+}
+
+// 多级反馈队列：由位图O(1)找到最高非空级别并取出队首
+PCB* mlfq_dequeue() {
+    if (mlfq_bitmap == 0) {
+        return NULL;
+    }
+
+    int level = std::countr_zero(mlfq_bitmap);
+    PCB *proc = mlfq_head[level];
+    mlfq_head[level] = proc->next;
+    if (mlfq_head[level] == NULL) {
+        mlfq_tail[level] = NULL;
+    }
+    if (--mlfq_depth[level] == 0) {
+        mlfq_bitmap &= ~(1u << level);
+    }
+    proc->next = NULL;
+    return proc;
+}
+
+// 多级反馈队列：周期性提升（老化），所有进程回到最高级，防止低级进程饿死
+void mlfq_boost() {
+    int boosted = 0;
+    for (int level = 1; level < MLFQ_LEVELS; level++) {
+        for (PCB *p = mlfq_head[level]; p != NULL; p = p->next) {
+            p->mlfq_level = 0;
+            p->quantum_left = mlfq_quantum[0];
+        }
+        boosted += mlfq_depth[level];
+        if (mlfq_head[level] == NULL) continue;
+
+        // 整条队列拼接到第0级队尾
+        if (mlfq_tail[0] == NULL) {
+            mlfq_head[0] = mlfq_head[level];
+        } else {
+            mlfq_tail[0]->next = mlfq_head[level];
+        }
+        mlfq_tail[0] = mlfq_tail[level];
+        mlfq_depth[0] += mlfq_depth[level];
+        mlfq_head[level] = NULL;
+        mlfq_tail[level] = NULL;
+        mlfq_depth[level] = 0;
+    }
+    if (mlfq_depth[0] > 0) {
+        mlfq_bitmap = 1u;
+    }
+
+    for (PCB *p = blocked_queue; p != NULL; p = p->next) {
+        boosted += (p->mlfq_level > 0);
+        p->mlfq_level = 0;
+        p->quantum_left = mlfq_quantum[0];
+    }
+    if (running_process != NULL) {
+        boosted += (running_process->mlfq_level > 0);
+        running_process->mlfq_level = 0;
+        running_process->quantum_left = mlfq_quantum[0];
+    }
+    if (interrupted_process != NULL) {
+        boosted += (interrupted_process->mlfq_level > 0);
+        interrupted_process->mlfq_level = 0;
+        interrupted_process->quantum_left = mlfq_quantum[0];
+    }
+
+    mlfq_last_boost = time_counter;
+    if (boosted > 0) {
+        klog("MLFQ优先级提升: %d个进程回到第0级\n", boosted);
+    }
+}
+
+// 多级反馈队列：I/O唤醒的进程提升一级（交互型进程优先）
+void mlfq_promote(PCB *proc) {
+    if (current_algorithm != MLFQ || proc == NULL) return;
+
+    if (proc->mlfq_level > 0) {
+        proc->mlfq_level--;
+    }
+    proc->quantum_left = mlfq_quantum[proc->mlfq_level];
+}
+
+// 进程的预测剩余CPU区间
+double predicted_remaining(const PCB *proc) {
+    double remaining = proc->burst_estimate - proc->burst_time;
+    return remaining > 0 ? remaining : 0;
+}
+
+// SJF按预测区间排序，SRTF按预测剩余时间排序，相同时PID小者优先
+bool sjf_before(const PCB *a, const PCB *b) {
+    double ka = (current_algorithm == SRTF) ? predicted_remaining(a) : a->burst_estimate;
+    double kb = (current_algorithm == SRTF) ? predicted_remaining(b) : b->burst_estimate;
+    if (ka != kb) {
+        return ka < kb;
+    }
+    return a->pid < b->pid;
+}
+
+// CPU区间结束（进程阻塞）时用指数平均更新预测：tau = a*t + (1-a)*tau
+void update_burst_estimate(PCB *proc) {
+    if (proc->burst_time > 0) {
+        proc->burst_estimate = BURST_ALPHA * proc->burst_time +
+                               (1 - BURST_ALPHA) * proc->burst_estimate;
+    }
+    proc->burst_time = 0;
+}
+
+// 堆内交换两个位置并维护下标
+static void heap_swap(PCBHeap *heap, int i, int j) {
+    PCB *tmp = heap->items[i];
+    heap->items[i] = heap->items[j];
+    heap->items[j] = tmp;
+    heap->items[i]->heap_index = i;
+    heap->items[j]->heap_index = j;
+}
+
+static void heap_sift_up(PCBHeap *heap, int i) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!heap->before(heap->items[i], heap->items[parent])) break;
+        heap_swap(heap, i, parent);
+        i = parent;
+    }
+}
+
+static void heap_sift_down(PCBHeap *heap, int i) {
+    while (true) {
+        int left = 2 * i + 1;
+        int right = left + 1;
+        int best = i;
+        if (left < heap->size && heap->before(heap->items[left], heap->items[best])) best = left;
+        if (right < heap->size && heap->before(heap->items[right], heap->items[best])) best = right;
+        if (best == i) break;
+        heap_swap(heap, i, best);
+        i = best;
+    }
+}
+
+// 保证堆数组至少能容纳count个元素（容量倍增）
+void heap_reserve(PCBHeap *heap, int count) {
+    if (count <= heap->capacity) return;
+    while (heap->capacity < count) {
+        heap->capacity = heap->capacity ? heap->capacity * 2 : 16;
+    }
+    heap->items = (PCB**)realloc(heap->items, heap->capacity * sizeof(PCB*));
+}
+
+// 入堆 O(log n)
+void heap_push(PCBHeap *heap, PCB *proc) {
+    heap_reserve(heap, heap->size + 1);
+    proc->next = NULL;
+    proc->heap_index = heap->size;
+    heap->items[heap->size++] = proc;
+    heap_sift_up(heap, proc->heap_index);
+}
+
+// 取出堆顶 O(log n)
+PCB* heap_pop(PCBHeap *heap) {
+    if (heap->size == 0) {
+        return NULL;
+    }
+    PCB *top = heap->items[0];
+    heap_remove(heap, top);
+    return top;
+}
+
+// 按下标删除任意元素 O(log n)
+void heap_remove(PCBHeap *heap, PCB *proc) {
+    int i = proc->heap_index;
+    if (i < 0 || i >= heap->size || heap->items[i] != proc) return;
+
+    heap->size--;
+    if (i != heap->size) {
+        heap->items[i] = heap->items[heap->size];
+        heap->items[i]->heap_index = i;
+        heap_sift_down(heap, i);
+        heap_sift_up(heap, i);
+    }
+    proc->heap_index = -1;
+}
+
+// 自底向上建堆 O(n)
+void heap_build(PCBHeap *heap) {
+    for (int i = heap->size / 2 - 1; i >= 0; i--) {
+        heap_sift_down(heap, i);
+    }
+}
+
+// 由优先级（视为nice值，截断到-20..19）得到权重
+int cfs_weight(const PCB *proc) {
+    int nice = proc->priority;
+    if (nice < -20) nice = -20;
+    if (nice > 19) nice = 19;
+    return cfs_prio_to_weight[nice + 20];
+}
+
+// 动态时间片：目标延迟按权重占比分给每个可运行进程，不低于最小粒度
+int cfs_timeslice(const PCB *proc) {
+    long long total_weight = cfs_ready_weight + cfs_weight(proc);
+    int nr_running = cfs_nr_ready + 1;
+    long long latency = CFS_TARGET_LATENCY;
+    // 进程过多时延长周期，保证每个进程至少获得最小粒度
+    if (nr_running * CFS_MIN_GRANULARITY > latency) {
+        latency = (long long)nr_running * CFS_MIN_GRANULARITY;
+    }
+    int slice = (int)(latency * cfs_weight(proc) / total_weight);
+    return slice < CFS_MIN_GRANULARITY ? CFS_MIN_GRANULARITY : slice;
+}
+
+// 更新单调递增的最小vruntime
+void cfs_update_min_vruntime() {
+    long long vmin = cfs_min_vruntime;
+    bool found = false;
+    if (running_process != NULL) {
+        vmin = running_process->vruntime;
+        found = true;
+    }
+    if (cfs_leftmost != NULL && (!found || cfs_leftmost->vruntime < vmin)) {
+        vmin = cfs_leftmost->vruntime;
+        found = true;
+    }
+    if (found && vmin > cfs_min_vruntime) {
+        cfs_min_vruntime = vmin;
+    }
+}
+
+// 红黑树键比较：vruntime小者在左，相同时PID小者在左
+static bool cfs_less(const PCB *a, const PCB *b) {
+    if (a->vruntime != b->vruntime) {
+        return a->vruntime < b->vruntime;
+    }
+    return a->pid < b->pid;
+}
+
+static void cfs_rotate_left(PCB *x) {
+    PCB *y = x->rb_right;
+    x->rb_right = y->rb_left;
+    if (y->rb_left != NULL) y->rb_left->rb_parent = x;
+    y->rb_parent = x->rb_parent;
+    if (x->rb_parent == NULL) {
+        cfs_root = y;
+    } else if (x == x->rb_parent->rb_left) {
+        x->rb_parent->rb_left = y;
+    } else {
+        x->rb_parent->rb_right = y;
+    }
+    y->rb_left = x;
+    x->rb_parent = y;
+}
+
+static void cfs_rotate_right(PCB *x) {
+    PCB *y = x->rb_left;
+    x->rb_left = y->rb_right;
+    if (y->rb_right != NULL) y->rb_right->rb_parent = x;
+    y->rb_parent = x->rb_parent;
+    if (x->rb_parent == NULL) {
+        cfs_root = y;
+    } else if (x == x->rb_parent->rb_right) {
+        x->rb_parent->rb_right = y;
+    } else {
+        x->rb_parent->rb_left = y;
+    }
+    y->rb_right = x;
+    x->rb_parent = y;
+}
+
+// 插入红黑树 O(log n)，并维护最左节点缓存
+void cfs_enqueue(PCB *proc) {
+    // 长时间睡眠的进程最多补偿半个目标延迟，防止唤醒后长期独占CPU
+    long long floor_vruntime = cfs_min_vruntime - (long long)CFS_TARGET_LATENCY * CFS_VRUNTIME_SCALE / 2;
+    if (proc->vruntime < floor_vruntime) {
+        proc->vruntime = floor_vruntime;
+    }
+
+    PCB *parent = NULL;
+    PCB **link = &cfs_root;
+    bool leftmost = true;
+    while (*link != NULL) {
+        parent = *link;
+        if (cfs_less(proc, parent)) {
+            link = &parent->rb_left;
+        } else {
+            link = &parent->rb_right;
+            leftmost = false;
+        }
+    }
+
+    proc->next = NULL;
+    proc->rb_parent = parent;
+    proc->rb_left = proc->rb_right = NULL;
+    proc->rb_red = true;
+    *link = proc;
+    if (leftmost) {
+        cfs_leftmost = proc;
+    }
+
+    // 插入修复
+    PCB *x = proc;
+    while (x != cfs_root && x->rb_parent->rb_red) {
+        PCB *p = x->rb_parent;
+        PCB *g = p->rb_parent;
+        if (p == g->rb_left) {
+            PCB *uncle = g->rb_right;
+            if (uncle != NULL && uncle->rb_red) {
+                p->rb_red = false;
+                uncle->rb_red = false;
+                g->rb_red = true;
+                x = g;
+            } else {
+                if (x == p->rb_right) {
+                    x = p;
+                    cfs_rotate_left(x);
+                    p = x->rb_parent;
+                }
+                p->rb_red = false;
+                g->rb_red = true;
+                cfs_rotate_right(g);
+            }
+        } else {
+            PCB *uncle = g->rb_left;
+            if (uncle != NULL && uncle->rb_red) {
+                p->rb_red = false;
+                uncle->rb_red = false;
+                g->rb_red = true;
+                x = g;
+            } else {
+                if (x == p->rb_left) {
+                    x = p;
+                    cfs_rotate_right(x);
+                    p = x->rb_parent;
+                }
+                p->rb_red = false;
+                g->rb_red = true;
+                cfs_rotate_left(g);
+            }
+        }
+    }
+    cfs_root->rb_red = false;
+
+    cfs_nr_ready++;
+    cfs_ready_weight += cfs_weight(proc);
+}
+
+// 中序后继
+PCB* cfs_next(PCB *node) {
+    if (node->rb_right != NULL) {
+        node = node->rb_right;
+        while (node->rb_left != NULL) node = node->rb_left;
+        return node;
+    }
+    PCB *parent = node->rb_parent;
+    while (parent != NULL && node == parent->rb_right) {
+        node = parent;
+        parent = parent->rb_parent;
+    }
+    return parent;
+}
+
+// 用v替换以u为根的子树
+static void cfs_transplant(PCB *u, PCB *v) {
+    if (u->rb_parent == NULL) {
+        cfs_root = v;
+    } else if (u == u->rb_parent->rb_left) {
+        u->rb_parent->rb_left = v;
+    } else {
+        u->rb_parent->rb_right = v;
+    }
+    if (v != NULL) v->rb_parent = u->rb_parent;
+}
+
+// 从红黑树删除 O(log n)，并维护最左节点缓存
+void cfs_dequeue(PCB *proc) {
+    if (cfs_leftmost == proc) {
+        cfs_leftmost = cfs_next(proc);
+    }
+
+    PCB *x;               // 顶替被删位置的节点（可能为NULL）
+    PCB *x_parent;        // x的父节点（x为NULL时用于修复）
+    bool removed_red = proc->rb_red;
+
+    if (proc->rb_left == NULL) {
+        x = proc->rb_right;
+        x_parent = proc->rb_parent;
+        cfs_transplant(proc, proc->rb_right);
+    } else if (proc->rb_right == NULL) {
+        x = proc->rb_left;
+        x_parent = proc->rb_parent;
+        cfs_transplant(proc, proc->rb_left);
+    } else {
+        PCB *y = proc->rb_right;
+        while (y->rb_left != NULL) y = y->rb_left;
+        removed_red = y->rb_red;
+        x = y->rb_right;
+        if (y->rb_parent == proc) {
+            x_parent = y;
+        } else {
+            x_parent = y->rb_parent;
+            cfs_transplant(y, y->rb_right);
+            y->rb_right = proc->rb_right;
+            y->rb_right->rb_parent = y;
+        }
+        cfs_transplant(proc, y);
+        y->rb_left = proc->rb_left;
+        y->rb_left->rb_parent = y;
+        y->rb_red = proc->rb_red;
+    }
+
+    // 删除了黑色节点时修复
+    if (!removed_red) {
+        while (x != cfs_root && (x == NULL || !x->rb_red)) {
+            if (x == x_parent->rb_left) {
+                PCB *w = x_parent->rb_right;
+                if (w->rb_red) {
+                    w->rb_red = false;
+                    x_parent->rb_red = true;
+                    cfs_rotate_left(x_parent);
+                    w = x_parent->rb_right;
+                }
+                if ((w->rb_left == NULL || !w->rb_left->rb_red) &&
+                    (w->rb_right == NULL || !w->rb_right->rb_red)) {
+                    w->rb_red = true;
+                    x = x_parent;
+                    x_parent = x->rb_parent;
+                } else {
+                    if (w->rb_right == NULL || !w->rb_right->rb_red) {
+                        w->rb_left->rb_red = false;
+                        w->rb_red = true;
+                        cfs_rotate_right(w);
+                        w = x_parent->rb_right;
+                    }
+                    w->rb_red = x_parent->rb_red;
+                    x_parent->rb_red = false;
+                    if (w->rb_right != NULL) w->rb_right->rb_red = false;
+                    cfs_rotate_left(x_parent);
+                    x = cfs_root;
+                }
+            } else {
+                PCB *w = x_parent->rb_left;
+                if (w->rb_red) {
+                    w->rb_red = false;
+                    x_parent->rb_red = true;
+                    cfs_rotate_right(x_parent);
+                    w = x_parent->rb_left;
+                }
+                if ((w->rb_left == NULL || !w->rb_left->rb_red) &&
+                    (w->rb_right == NULL || !w->rb_right->rb_red)) {
+                    w->rb_red = true;
+                    x = x_parent;
+                    x_parent = x->rb_parent;
+                } else {
+                    if (w->rb_left == NULL || !w->rb_left->rb_red) {
+                        w->rb_right->rb_red = false;
+                        w->rb_red = true;
+                        cfs_rotate_left(w);
+                        w = x_parent->rb_left;
+                    }
+                    w->rb_red = x_parent->rb_red;
+                    x_parent->rb_red = false;
+                    if (w->rb_left != NULL) w->rb_left->rb_red = false;
+                    cfs_rotate_right(x_parent);
+                    x = cfs_root;
+                }
+            }
+        }
+        if (x != NULL) x->rb_red = false;
+    }
+
+    proc->rb_left = proc->rb_right = proc->rb_parent = NULL;
+    proc->rb_red = false;
+    cfs_nr_ready--;
+    cfs_ready_weight -= cfs_weight(proc);
+}
+
+// 是否为实时进程
+bool is_rt(const PCB *proc) {
+    return proc->rt_period > 0;
+}
+
+// EDF：绝对截止期早者优先，相同时PID小者优先
+bool edf_before(const PCB *a, const PCB *b) {
+    if (a->rt_abs_deadline != b->rt_abs_deadline) {
+        return a->rt_abs_deadline < b->rt_abs_deadline;
+    }
+    return a->pid < b->pid;
+}
+
+// 释放堆：下一周期释放时间早者优先
+bool release_before(const PCB *a, const PCB *b) {
+    if (a->rt_next_release != b->rt_next_release) {
+        return a->rt_next_release < b->rt_next_release;
+    }
+    return a->pid < b->pid;
+}
+
+// 实时作业用完本周期预算：统计是否错过截止期，然后等待下一周期或立即开始已到期的下一作业
+void edf_complete_job(PCB *proc) {
+    rt_jobs_completed++;
+    if (time_counter > proc->rt_abs_deadline) {
+        proc->rt_misses++;
+        rt_deadline_misses++;
+        klog("实时进程 %s (PID=%d) 错过截止期 %d（完成于 %d）\n",
+               proc->name, proc->pid, proc->rt_abs_deadline, time_counter);
+    }
+
+    proc->state = READY;
+    if (proc->rt_next_release <= time_counter) {
+        // 已超出本周期，下一作业已释放
+        proc->rt_budget = proc->rt_runtime;
+        proc->rt_abs_deadline = proc->rt_next_release + proc->rt_deadline;
+        proc->rt_next_release += proc->rt_period;
+        heap_push(&edf_heap, proc);
+    } else {
+        klog("实时进程 %s (PID=%d) 本周期预算用完，等待到 %d 释放下一作业\n",
+               proc->name, proc->pid, proc->rt_next_release);
+        heap_push(&edf_release_heap, proc);
+    }
+}
+
+// 释放到期的周期作业：补充预算、设置新截止期并进入EDF就绪堆
+void edf_release_jobs() {
+    while (edf_release_heap.size > 0 && edf_release_heap.items[0]->rt_next_release <= time_counter) {
+        PCB *proc = heap_pop(&edf_release_heap);
+        proc->rt_budget = proc->rt_runtime;
+        proc->rt_abs_deadline = proc->rt_next_release + proc->rt_deadline;
+        proc->rt_next_release += proc->rt_period;
+        heap_push(&edf_heap, proc);
+    }
+}
+
+// 实时进程退出时归还其准入利用率
+void rt_release_utilization(PCB *proc) {
+    if (proc == NULL || !is_rt(proc)) return;
+    rt_utilization -= (double)proc->rt_runtime / proc->rt_deadline;
+    if (rt_utilization < 0) rt_utilization = 0;
+    rt_admitted--;
+}
+
+// 各调度结构中就绪进程的总数，由入队/出队维护的计数得出
+static long long metric_ready_depth() {
+    long long depth = ready_list_count + sjf_heap.size + cfs_nr_ready + edf_heap.size;
+    for (int level = 0; level < MLFQ_LEVELS; level++) depth += mlfq_depth[level];
+    return depth;
+}
+
+// 显示系统统计信息
+void display_stats() {
+    int ready_count = (int)metric_ready_depth();
+
+    klog("\n===== 系统统计 =====\n");
+    klog("当前时间: %d\n", time_counter);
+    klog("调度算法: %s\n", get_algorithm_name(current_algorithm));
+    klog("就绪进程数: %d, 阻塞进程数: %d, 运行中: %s\n",
+           ready_count, blocked_count, running_process != NULL ? running_process->name : "无");
+    klog("运行完成的进程: %lld, 平均周转时间: %.2f, 最长周转时间: %d, 因内存不足创建失败: %lld\n",
+           processes_finished, processes_finished > 0 ? (double)turnaround_total / processes_finished : 0.0,
+           turnaround_max, creates_failed);
+    klog("\n实时调度类 (EDF):\n");
+    klog("已准入实时进程: %d, 总利用率: %.3f / %.2f\n", rt_admitted, rt_utilization, RT_UTIL_BOUND);
+    klog("准入拒绝次数: %d\n", rt_rejected);
+    klog("完成作业数: %d, 错过截止期: %d", rt_jobs_completed, rt_deadline_misses);
+    if (rt_jobs_completed > 0) {
+        klog(" (%.2f%%)", 100.0 * rt_deadline_misses / rt_jobs_completed);
+    }
+    klog("\n等待下一周期的实时进程: %d\n", edf_release_heap.size);
+    klog("\n事件驱动时钟:\n");
+    klog("已处理事件: %lld, 待处理事件: %d\n", events_processed, event_count);
+    klog("时钟跳跃次数: %lld, CPU空闲时钟: %lld\n", clock_jumps, idle_ticks);
+    klog("====================\n\n");
+}
+
+// 添加进程到阻塞队列
+void add_to_blocked_queue(PCB *proc) {
+    if (proc == NULL) return;
+
+    proc->prev = NULL;
+    proc->next = blocked_queue;
+    if (blocked_queue != NULL) {
+        blocked_queue->prev = proc;
+    }
+    blocked_queue = proc;
+    blocked_count++;
+}
+
+// 从阻塞队列中移除并返回指定PID的进程：PID索引定位 + 双向链表摘除，O(1)
+PCB* remove_from_blocked_queue(int pid) {
+    PCB *proc = lookup_process(pid);
+    if (proc == NULL || proc->state != BLOCKED) {
+        return NULL; // 未找到
+    }
+
+    if (proc->prev != NULL) {
+        proc->prev->next = proc->next;
+    } else {
+        blocked_queue = proc->next;
+    }
+    if (proc->next != NULL) {
+        proc->next->prev = proc->prev;
+    }
+    proc->next = NULL;
+    proc->prev = NULL;
+    blocked_count--;
+    return proc;
+}
+
+// 登记到PID索引
+void register_process(PCB *proc) {
+    if (proc->pid >= pid_table_size) {
+        int new_size = pid_table_size ? pid_table_size : 64;
+        while (new_size <= proc->pid) new_size *= 2;
+        pid_table = (PCB**)realloc(pid_table, new_size * sizeof(PCB*));
+        memset(pid_table + pid_table_size, 0, (new_size - pid_table_size) * sizeof(PCB*));
+        pid_table_size = new_size;
+    }
+    pid_table[proc->pid] = proc;
+}
+
+// 按PID查找进程 O(1)
+PCB* lookup_process(int pid) {
+    if (pid <= 0 || pid >= pid_table_size) {
+        return NULL;
+    }
+    return pid_table[pid];
+}
+
+// 释放已从各队列摘除的进程的全部资源
+void release_process(PCB *proc) {
+    TRACE(TRACE_EXIT, proc->pid, proc->time_slice, 0);
+    rt_release_utilization(proc);
+    cancel_io_request(proc);
+    shm_release_process(proc->pid);
+    sync_release_process(proc);
+    resource_release_process(proc);
+    if (proc->page_table != NULL) {
+        vm_release(proc);
+    } else {
+        free_memory(proc->pid);
+    }
+    if (proc->pid < pid_table_size) {
+        pid_table[proc->pid] = NULL;
+    }
+    node_free(proc);
+}
+
+// 按名称查找设备
+int find_device(const char *name) {
+    for (int d = 0; d < NUM_DEVICES; d++) {
+        if (strcmp(devices[d].name, name) == 0) {
+            return d;
+        }
+    }
+    return -1;
+}
+
+// 加入设备请求队列，设备空闲则立即开始服务
+static void enqueue_io_request(PCB *proc, int device, int block, bool is_write) {
+    IODevice *dev = &devices[device];
+    IORequest *req = (IORequest*)malloc(sizeof(IORequest));
+    req->proc = proc;
+    req->device = device;
+    req->block = block;
+    req->is_write = is_write;
+    req->submit_time = time_counter;
+    req->start_time = -1;
+    req->next = NULL;
+    if (proc != NULL) {
+        proc->io_request = req;
+    }
+
+    if (dev->queue_tail == NULL) {
+        dev->queue_head = req;
+    } else {
+        dev->queue_tail->next = req;
+    }
+    dev->queue_tail = req;
+    dev->queue_length++;
+
+    if (dev->current == NULL) {
+        start_device(device);
+    }
+}
+
+// 提交I/O请求；进程对磁盘的请求访问一个随机块
+void submit_io_request(PCB *proc, int device) {
+    int block = devices[device].type == DEVICE_DISK ? kernel_rand() % DISK_BLOCKS : -1;
+    enqueue_io_request(proc, device, block, false);
+}
+
+// 提交磁盘块读写请求
+void submit_block_request(PCB *proc, int block, bool is_write) {
+    enqueue_io_request(proc, find_device("disk"), block, is_write);
+}
+
+// 文件层：按块链依次提交整个文件的块请求（异步，不阻塞进程）
+void submit_block_chain(int first_block, bool is_write) {
+    for (int b = first_block; b >= 0 && b < DISK_BLOCKS; b = disk[b].next_block) {
+        submit_block_request(NULL, b, is_write);
+    }
+}
+
+// 设备开始服务下一个请求并安排完成事件：磁盘由电梯算法选择请求并按磁头模型计时，其他设备FIFO
+void start_device(int device) {
+    IODevice *dev = &devices[device];
+    if (dev->current != NULL || dev->queue_head == NULL) {
+        return;
+    }
+
+    IORequest *req;
+    int service;
+    if (dev->type == DEVICE_DISK) {
+        IORequest *prev;
+        int extra_travel;
+        req = elevator_pick(dev->queue_head, disk_policy, &disk_head, &extra_travel, &prev);
+        if (prev == NULL) {
+            dev->queue_head = req->next;
+        } else {
+            prev->next = req->next;
+        }
+        if (dev->queue_tail == req) {
+            dev->queue_tail = prev;
+        }
+
+        DiskAccess access;
+        disk_access(&disk_head, req->block, extra_travel, (long long)time_counter * DISK_US_PER_TICK, &access);
+        int total_us = access.seek_us + access.rotation_us + access.transfer_us;
+        service = (total_us + DISK_US_PER_TICK - 1) / DISK_US_PER_TICK;
+
+        DiskPolicyStats *stats = &disk_stats[disk_policy];
+        stats->requests++;
+        stats->seek_distance += access.seek_distance;
+        stats->seek_us += access.seek_us;
+        stats->rotation_us += access.rotation_us;
+        stats->transfer_us += access.transfer_us;
+        stats->wait_ticks += time_counter - req->submit_time;
+    } else {
+        req = dev->queue_head;
+        dev->queue_head = req->next;
+        if (dev->queue_head == NULL) {
+            dev->queue_tail = NULL;
+        }
+        service = dev->base_service + kernel_rand() % (dev->service_jitter + 1);
+    }
+    dev->queue_length--;
+    req->next = NULL;
+
+    req->start_time = time_counter;
+    dev->current = req;
+    dev->total_wait += req->start_time - req->submit_time;
+    dev->total_service += service;
+    schedule_event(time_counter + service, EVENT_IO_COMPLETE, -1, device, NULL);
+}
+
+// I/O完成中断：唤醒发起请求的进程（请求直接指向PCB，O(1)），然后服务下一个请求
+void handle_io_interrupt(int device) {
+    IODevice *dev = &devices[device];
+    IORequest *req = dev->current;
+    if (req == NULL) {
+        return;
+    }
+    dev->current = NULL;
+    dev->completed++;
+
+    PCB *proc = req->proc;
+    if (proc != NULL) {
+        proc->io_request = NULL;
+        remove_from_blocked_queue(proc->pid);
+        TRACE(TRACE_IO_DONE, proc->pid, device, 0);
+        KLOG("I/O中断: 设备 %s 完成进程 %s (PID=%d) 的请求（排队%d，服务%d），进程被唤醒\n",
+               dev->name, proc->name, proc->pid,
+               req->start_time - req->submit_time, time_counter - req->start_time);
+        proc->state = READY;
+        mlfq_promote(proc);
+        add_to_ready_queue(proc);
+    }
+    node_free(req);
+
+    start_device(device);
+}
+
+// 取消进程未完成的I/O请求：排队中的直接摘除，服务中的只断开与进程的关联
+void cancel_io_request(PCB *proc) {
+    IORequest *req = proc->io_request;
+    if (req == NULL) {
+        return;
+    }
+    proc->io_request = NULL;
+
+    IODevice *dev = &devices[req->device];
+    if (dev->current == req) {
+        req->proc = NULL;
+        return;
+    }
+
+    IORequest *prev = NULL;
+    for (IORequest *r = dev->queue_head; r != NULL; prev = r, r = r->next) {
+        if (r != req) continue;
+        if (prev == NULL) {
+            dev->queue_head = r->next;
+        } else {
+            prev->next = r->next;
+        }
+        if (dev->queue_tail == r) {
+            dev->queue_tail = prev;
+        }
+        dev->queue_length--;
+        node_free(r);
+        return;
+    }
+}
+
+// ======= 磁盘调度 =======
+
+int find_disk_policy(const char *name) {
+    for (int p = 0; p < NUM_DISK_POLICIES; p++) {
+        if (strcmp(disk_policy_names[p], name) == 0) {
+            return p;
+        }
+    }
+    return -1;
+}
+
+static int block_cylinder(int block) {
+    return block / DISK_SECTORS_PER_TRACK;
+}
+
+// 在方向dir上（含当前柱面）距离磁头最近的请求，无则返回NULL
+static IORequest* nearest_in_direction(IORequest *queue, int cylinder, int dir, IORequest **prev_out) {
+    IORequest *best = NULL, *prev = NULL;
+    int best_distance = INT_MAX;
+    for (IORequest *r = queue; r != NULL; prev = r, r = r->next) {
+        int distance = (block_cylinder(r->block) - cylinder) * dir;
+        if (distance >= 0 && distance < best_distance) {
+            best = r;
+            best_distance = distance;
+            *prev_out = prev;
+        }
+    }
+    return best;
+}
+
+// 电梯算法：从请求队列中选出下一个服务的请求（不摘除），prev_out返回其前驱。
+// SCAN到达端点反向时，磁头先移动到端点，行程通过extra_travel返回
+IORequest* elevator_pick(IORequest *queue, DiskPolicy policy, DiskHead *head,
+                         int *extra_travel, IORequest **prev_out) {
+    IORequest *best = NULL, *prev = NULL;
+    *extra_travel = 0;
+    *prev_out = NULL;
+
+    switch (policy) {
+        case DISK_FCFS:
+            best = queue;
+            break;
+        case DISK_SSTF: {
+            int best_distance = INT_MAX;
+            for (IORequest *r = queue; r != NULL; prev = r, r = r->next) {
+                int distance = abs(block_cylinder(r->block) - head->cylinder);
+                if (distance < best_distance) {
+                    best = r;
+                    best_distance = distance;
+                    *prev_out = prev;
+                }
+            }
+            break;
+        }
+        case DISK_SCAN:
+            best = nearest_in_direction(queue, head->cylinder, head->direction, prev_out);
+            if (best == NULL) {
+                int edge = head->direction > 0 ? DISK_CYLINDERS - 1 : 0;
+                *extra_travel = abs(edge - head->cylinder);
+                head->cylinder = edge;
+                head->direction = -head->direction;
+                best = nearest_in_direction(queue, head->cylinder, head->direction, prev_out);
+            }
+            break;
+        case DISK_CLOOK:
+            head->direction = 1;
+            best = nearest_in_direction(queue, head->cylinder, 1, prev_out);
+            if (best == NULL) {
+                // 跳回柱面号最小的请求
+                int lowest = INT_MAX;
+                for (IORequest *r = queue; r != NULL; prev = r, r = r->next) {
+                    if (block_cylinder(r->block) < lowest) {
+                        best = r;
+                        lowest = block_cylinder(r->block);
+                        *prev_out = prev;
+                    }
+                }
+            }
+            break;
+        default:
+            best = queue;
+            break;
+    }
+    return best;
+}
+
+// 计算从start_us开始访问block的寻道、旋转等待和传输时间，并移动磁头
+void disk_access(DiskHead *head, int block, int extra_travel, long long start_us, DiskAccess *out) {
+    const int sector_us = DISK_ROTATION_US / DISK_SECTORS_PER_TRACK;
+    int cylinder = block_cylinder(block);
+    int distance = abs(cylinder - head->cylinder);
+
+    out->seek_distance = extra_travel + distance;
+    out->seek_us = out->seek_distance > 0 ?
+                   DISK_SEEK_SETTLE_US + out->seek_distance * DISK_SEEK_PER_CYL_US : 0;
+    if (cylinder != head->cylinder) {
+        head->direction = cylinder > head->cylinder ? 1 : -1;
+    }
+    head->cylinder = cylinder;
+
+    // 寻道结束时盘片转到的角度决定旋转等待
+    long long angle = (start_us + out->seek_us) % DISK_ROTATION_US;
+    long long target = (long long)(block % DISK_SECTORS_PER_TRACK) * sector_us;
+    out->rotation_us = (int)((target - angle + DISK_ROTATION_US) % DISK_ROTATION_US);
+    out->transfer_us = sector_us;
+}
+
+// 收集所有文件的块链：顺序扫描inode表，有多个硬链接的文件只收集一次
+static void collect_file_blocks(int *blocks, int *count) {
+    for (int ino = 0; ino < inode_slots; ino++) {
+        const Inode *node = &inode_table[ino];
+        if (node->links == 0 || node->type != FILE_TYPE) continue;
+        for (int b = node->first_block; b >= 0 && b < DISK_BLOCKS && *count < DISK_BLOCKS;
+             b = disk[b].next_block) {
+            blocks[(*count)++] = b;
+        }
+    }
+}
+
+// 磁盘调度对比：把所有文件的块作为一批同时到达的读请求，
+// 从当前磁头位置出发分别用四种算法服务，比较寻道距离和服务时间
+void disk_benchmark() {
+    int *blocks = (int*)malloc(DISK_BLOCKS * sizeof(int));
+    int count = 0;
+    collect_file_blocks(blocks, &count);
+    if (count == 0) {
+        klog("文件系统中没有文件块，请先用 touch 创建文件\n");
+        free(blocks);
+        return;
+    }
+
+    IORequest *requests = (IORequest*)calloc(count, sizeof(IORequest));
+    klog("\n===== 磁盘调度对比 (%d 个块请求, 磁头起始柱面 %d) =====\n", count, disk_head.cylinder);
+    klog("算法\t总寻道距离\t平均寻道(us)\t平均旋转(us)\t平均服务(us)\t完成时间(us)\n");
+    for (int p = 0; p < NUM_DISK_POLICIES; p++) {
+        for (int i = 0; i < count; i++) {
+            requests[i].block = blocks[i];
+            requests[i].next = (i + 1 < count) ? &requests[i + 1] : NULL;
+        }
+        IORequest *queue = &requests[0];
+        DiskHead head = disk_head;
+        long long now = (long long)time_counter * DISK_US_PER_TICK;
+        long long start = now;
+        long long seek_distance = 0, seek_us = 0, rotation_us = 0;
+
+        while (queue != NULL) {
+            IORequest *prev;
+            int extra_travel;
+            IORequest *req = elevator_pick(queue, (DiskPolicy)p, &head, &extra_travel, &prev);
+            if (prev == NULL) {
+                queue = req->next;
+            } else {
+                prev->next = req->next;
+            }
+            DiskAccess access;
+            disk_access(&head, req->block, extra_travel, now, &access);
+            seek_distance += access.seek_distance;
+            seek_us += access.seek_us;
+            rotation_us += access.rotation_us;
+            now += access.seek_us + access.rotation_us + access.transfer_us;
+        }
+        klog("%s\t%lld\t\t%.1f\t\t%.1f\t\t%.1f\t\t%lld\n",
+               disk_policy_names[p], seek_distance,
+               (double)seek_us / count, (double)rotation_us / count,
+               (double)(now - start) / count, now - start);
+    }
+    klog("==============================================\n\n");
+    free(requests);
+    free(blocks);
+}
+
+// 读取文件：向磁盘提交文件所有块的读请求
+OsStatus read_file_command(const char* name) {
+    FCB* file = resolve_path(name, true);
+    if (file == NULL) return OS_ERR_NOT_FOUND;
+    if (file->type != FILE_TYPE) {
+        klog("错误: '%s' 不是文件\n", name);
+        return OS_ERR_WRONG_TYPE;
+    }
+    submit_block_chain(file_inode(file)->first_block, false);
+    klog("已提交文件 '%s' 的 %d 个块读请求\n", name, file_inode(file)->block_count);
+    return OS_OK;
+}
+
+// 显示I/O设备状态
+void display_devices() {
+    klog("\n===== I/O设备状态 =====\n");
+    klog("设备\t状态\t队列\t完成数\t平均排队\t平均服务\t利用率\n");
+    klog("------------------------------------------------------------\n");
+    for (int d = 0; d < NUM_DEVICES; d++) {
+        IODevice *dev = &devices[d];
+        long long started = dev->completed + (dev->current != NULL ? 1 : 0);
+        klog("%s\t%s\t%d\t%lld\t%.2f\t\t%.2f\t\t%.2f%%\n",
+               dev->name,
+               dev->current != NULL ? "忙" : "空闲",
+               dev->queue_length,
+               dev->completed,
+               started > 0 ? (double)dev->total_wait / started : 0.0,
+               started > 0 ? (double)dev->total_service / started : 0.0,
+               time_counter > 0 ? 100.0 * dev->total_service / time_counter : 0.0);
+    }
+    klog("=======================\n\n");
+}
+
+// 添加缺失的函数实现 - 显示进程
+void display_processes() {
+    klog("\n===== 进程列表 =====\n");
+    klog("当前调度算法: %s\n", get_algorithm_name(current_algorithm));
+    
+    if (system_interrupt_flag) {
+        klog("系统处于中断状态\n");
+    }
+
+    // 显示正在运行的进程
+    if (running_process != NULL) {
+        klog("\n运行中: PID=%d, 名称=%s, 优先级=%d, 时间片=%d, 内存=%d-%d\n",
+               running_process->pid,
+               running_process->name,
+               running_process->priority,
+               running_process->time_slice,
+               running_process->memory_start,
+               running_process->memory_start + running_process->memory_size - 1);
+    } else {
+        klog("\n运行中: 无\n");
+    }
+    
+    // 显示被中断的进程
+    if (interrupted_process != NULL) {
+        klog("\n被中断: PID=%d, 名称=%s, 优先级=%d, 时间片=%d, 内存=%d-%d\n",
+               interrupted_process->pid,
+               interrupted_process->name,
+               interrupted_process->priority,
+               interrupted_process->time_slice,
+               interrupted_process->memory_start,
+               interrupted_process->memory_start + interrupted_process->memory_size - 1);
+    }
+
+    // 显示就绪队列
+    klog("\n就绪队列:\n");
+    PCB *current = ready_queue;
+    if (current_algorithm == MLFQ) {
+        klog("各级队列深度:");
+        for (int level = 0; level < MLFQ_LEVELS; level++) {
+            klog(" L%d=%d", level, mlfq_depth[level]);
+        }
+        klog(" (位图=0x%X)\n", mlfq_bitmap);
+        if (mlfq_bitmap == 0) {
+            klog("空\n");
+        }
+        for (int level = 0; level < MLFQ_LEVELS; level++) {
+            for (current = mlfq_head[level]; current != NULL; current = current->next) {
+                klog("L%d: PID=%d, 名称=%s, 优先级=%d, 时间片=%d, 剩余量子=%d, 内存=%d-%d\n",
+                       level,
+                       current->pid,
+                       current->name,
+                       current->priority,
+                       current->time_slice,
+                       current->quantum_left,
+                       current->memory_start,
+                       current->memory_start + current->memory_size - 1);
+            }
+        }
+    } else if (current_algorithm == SJF || current_algorithm == SRTF) {
+        if (sjf_heap.size == 0) {
+            klog("空\n");
+        }
+        // 按堆数组顺序显示，堆顶为下一个被调度的进程
+        for (int i = 0; i < sjf_heap.size; i++) {
+            current = sjf_heap.items[i];
+            klog("PID=%d, 名称=%s, 优先级=%d, 时间片=%d, 预测区间=%.2f, 预测剩余=%.2f, 内存=%d-%d\n",
+                   current->pid,
+                   current->name,
+                   current->priority,
+                   current->time_slice,
+                   current->burst_estimate,
+                   predicted_remaining(current),
+                   current->memory_start,
+                   current->memory_start + current->memory_size - 1);
+        }
+        current = NULL;
+    } else if (current_algorithm == CFS) {
+        klog("可运行进程数=%d, 总权重=%lld, min_vruntime=%.2f\n",
+               cfs_nr_ready + (running_process != NULL ? 1 : 0),
+               cfs_ready_weight + (running_process != NULL ? cfs_weight(running_process) : 0),
+               (double)cfs_min_vruntime / CFS_VRUNTIME_SCALE);
+        if (cfs_leftmost == NULL) {
+            klog("空\n");
+        }
+        // 按vruntime从小到大显示
+        for (current = cfs_leftmost; current != NULL; current = cfs_next(current)) {
+            klog("PID=%d, 名称=%s, 优先级=%d, 时间片=%d, 权重=%d, vruntime=%.2f, 内存=%d-%d\n",
+                   current->pid,
+                   current->name,
+                   current->priority,
+                   current->time_slice,
+                   cfs_weight(current),
+                   (double)current->vruntime / CFS_VRUNTIME_SCALE,
+                   current->memory_start,
+                   current->memory_start + current->memory_size - 1);
+        }
+        current = NULL;
+    } else if (current == NULL) {
+        klog("空\n");
+    }
+    while (current != NULL) {
+        klog("PID=%d, 名称=%s, 优先级=%d, 时间片=%d, 内存=%d-%d\n",
+               current->pid,
+               current->name,
+               current->priority,
+               current->time_slice,
+               current->memory_start,
+               current->memory_start + current->memory_size - 1);
+        current = current->next;
+    }
+
+    // 显示实时进程（就绪作业按堆数组顺序，堆顶截止期最早）
+    if (edf_heap.size > 0 || edf_release_heap.size > 0) {
+        klog("\n实时进程 (EDF):\n");
+        for (int i = 0; i < edf_heap.size; i++) {
+            current = edf_heap.items[i];
+            klog("就绪 PID=%d, 名称=%s, 预算=%d/%d, 周期=%d, 截止期=%d, 错过=%d\n",
+                   current->pid, current->name, current->rt_budget, current->rt_runtime,
+                   current->rt_period, current->rt_abs_deadline, current->rt_misses);
+        }
+        for (int i = 0; i < edf_release_heap.size; i++) {
+            current = edf_release_heap.items[i];
+            klog("等待 PID=%d, 名称=%s, 下次释放=%d, 周期=%d, 错过=%d\n",
+                   current->pid, current->name, current->rt_next_release,
+                   current->rt_period, current->rt_misses);
+        }
+        current = NULL;
+    }
+
+    // 显示阻塞队列
+    klog("\n阻塞队列:\n");
+    current = blocked_queue;
+    if (current == NULL) {
+        klog("空\n");
+    }
+    while (current != NULL) {
+        klog("PID=%d, 名称=%s, 优先级=%d, 时间片=%d, 内存=%d-%d, 等待=%s\n",
+               current->pid,
+               current->name,
+               current->priority,
+               current->time_slice,
+               current->memory_start,
+               current->memory_start + current->memory_size - 1,
+               current->io_request != NULL ? devices[current->io_request->device].name :
+               current->sync_wait != NULL ? current->sync_wait->name :
+               current->res_wait >= 0 ? resources[current->res_wait].name : "-");
+        current = current->next;
+    }
+
+    klog("===================\n\n");
+}
+
+// 添加缺失的函数实现 - 显示内存状态
+// 空闲内存总量
+int total_free_memory() {
+    return mem_free_space.total;
+}
+
+// 是否存在位于已分配块之前的空闲块（即紧缩还有事可做）
+bool memory_fragmented() {
+    for (MemoryBlock *b = memory; b != NULL && b->next != NULL; b = b->next) {
+        if (!b->is_allocated && b->next->is_allocated) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 开始一次增量紧缩；预算为0时立即完成
+void start_compaction() {
+    if (compaction_active) {
+        return;
+    }
+    compaction_active = true;
+    compaction_started = time_counter;
+    compaction_run_bytes = 0;
+    klog("[内存紧缩] 开始，每时钟预算 %d 字节%s\n", compaction_budget,
+           compaction_budget == 0 ? "（不限，一次完成）" : "");
+    if (compaction_budget == 0) {
+        compaction_tick();
+    }
+}
+
+// 把空闲块后面的已分配块下移，通过PID索引更新进程的memory_start；
+// 每次至少移动一块以保证进展，之后不超过预算
+static long long compact_step(int budget) {
+    long long moved = 0;
+    MemoryBlock *prev = NULL;
+    MemoryBlock *cur = memory;
+    while (cur != NULL && cur->next != NULL) {
+        if (cur->is_allocated || !cur->next->is_allocated) {
+            prev = cur;
+            cur = cur->next;
+            continue;
+        }
+
+        MemoryBlock *hole = cur;
+        MemoryBlock *block = cur->next;
+        if (budget > 0 && moved > 0 && moved + block->size > budget) {
+            break;
+        }
+
+        // 交换空闲块与已分配块的位置
+        block->start_address = hole->start_address;
+        hole->start_address = block->start_address + block->size;
+        hole->next = block->next;
+        block->next = hole;
+        if (prev == NULL) {
+            memory = block;
+        } else {
+            prev->next = block;
+        }
+        PCB *owner = lookup_process(block->pid);
+        if (owner != NULL) {
+            owner->memory_start = block->start_address;
+        } else if (block->pid <= SHM_PID_BASE) {
+            ShmSegment *seg = find_shm_by_tag(block->pid);
+            if (seg != NULL) seg->start = block->start_address;
+        }
+        moved += block->size;
+        compaction_stats.blocks_moved++;
+
+        // 空闲块与后面的空闲块合并
+        while (hole->next != NULL && !hole->next->is_allocated) {
+            MemoryBlock *next_block = hole->next;
+            free_space_remove(&mem_free_space, hole->size);
+            free_space_remove(&mem_free_space, next_block->size);
+            hole->size += next_block->size;
+            free_space_add(&mem_free_space, hole->size);
+            hole->next = next_block->next;
+            node_free(next_block);
+        }
+        prev = block;
+        cur = hole;
+    }
+    return moved;
+}
+
+// 每个时钟执行一段紧缩；完成后创建等待中的进程
+void compaction_tick() {
+    if (!compaction_active) {
+        return;
+    }
+    long long start = now_ns();
+    long long moved = compact_step(compaction_budget);
+    compaction_stats.total_ns += now_ns() - start;
+    compaction_stats.bytes_moved += moved;
+    compaction_stats.ticks++;
+    compaction_run_bytes += moved;
+
+    if (memory_fragmented()) {
+        klog("[内存紧缩] 时间 %d: 本时钟移动 %lld 字节\n", time_counter, moved);
+        return;
+    }
+
+    compaction_active = false;
+    compaction_stats.runs++;
+    klog("[内存紧缩] 完成: 移动 %lld 字节，用时 %d 个时钟，连续空闲 %d\n",
+           compaction_run_bytes, time_counter - compaction_started + 1, total_free_memory());
+
+    PendingCreate *pending = pending_creates;
+    pending_creates = pending_creates_tail = NULL;
+    while (pending != NULL) {
+        PendingCreate *next = pending->next;
+        PCB *proc = create_process(pending->name, pending->memory_size, pending->priority,
+                                   pending->time_slice, pending->has_rt ? &pending->rt : NULL, NULL);
+        if (proc) {
+            klog("进程创建成功，PID: %d\n", proc->pid);
+        }
+        free(pending);
+        pending = next;
+    }
+}
+
+void display_memory() {
+    if (memory_mode == MEM_PAGING) {
+        display_paging();
+        return;
+    }
+    klog("\n===== 内存使用情况 =====\n");
+    MemoryBlock *current = memory;
+    int free_blocks = 0;
+    int used_blocks = 0;
+    int free_memory = 0;
+    int used_memory = 0;
+
+    klog("起始地址\t大小\t状态\tPID\n");
+    klog("--------------------------------\n");
+
+    while (current != NULL) {
+        ShmSegment *seg = current->is_allocated && current->pid <= SHM_PID_BASE ?
+                          find_shm_by_tag(current->pid) : NULL;
+        if (seg != NULL) {
+            klog("%d\t\t%d\t%s\t共享段 %s\n",
+                   current->start_address, current->size, "已分配", seg->name);
+        } else {
+            klog("%d\t\t%d\t%s\t%d\n",
+                   current->start_address,
+                   current->size,
+                   current->is_allocated ? "已分配" : "空闲",
+                   current->pid);
+        }
+
+        if (current->is_allocated) {
+            used_blocks++;
+            used_memory += current->size;
+        } else {
+            free_blocks++;
+            free_memory += current->size;
+        }
+
+        current = current->next;
+    }
+
+    klog("\n总内存: %d\n", memory_total);
+    klog("已使用: %d (%.2f%%)\n", used_memory, (float)used_memory / memory_total * 100);
+    klog("空闲: %d (%.2f%%)\n", free_memory, (float)free_memory / memory_total * 100);
+    klog("内存块数: %d (已用: %d, 空闲: %d)\n", free_blocks + used_blocks, used_blocks, free_blocks);
+    klog("最大空闲块: %d, 外部碎片指数: %.3f\n",
+           mem_free_space.largest, fragmentation_permille(&mem_free_space) / 1000.0);
+    klog("fork(完整复制): %lld 次, 复制 %lld 字节\n", cow_stats.copy_forks, cow_stats.bytes_copied);
+    klog("内存紧缩: %s, 每时钟预算 %d 字节, 完成 %lld 次, 移动 %lld 块/%lld 字节, 跨越 %lld 个时钟, 耗时 %.1f us\n",
+           compaction_active ? "进行中" : "空闲", compaction_budget,
+           compaction_stats.runs, compaction_stats.blocks_moved, compaction_stats.bytes_moved,
+           compaction_stats.ticks, compaction_stats.total_ns / 1000.0);
+    klog("=======================\n\n");
+}
+
+// 空闲区大小分布
+static void print_free_classes(const FreeSpaceStats *fs, const char *unit) {
+    for (int k = 0; k < FRAG_SIZE_CLASSES; k++) {
+        if (fs->classes[k] == 0) continue;
+        klog("  [%d-%d]%s\t%d\n", 1 << k, (1 << (k + 1)) - 1, unit, fs->classes[k]);
+    }
+}
+
+// 列出块链不连续的文件
+static void print_fragmented_files(FCB *dir, const char *prefix) {
+    for (FCB *f = dir->child; f != NULL; f = f->sibling) {
+        char path[FILE_MAX_PATH + 1];   // 多留一位给目录前缀末尾的'/'
+        int len = snprintf(path, FILE_MAX_PATH, "%s%s", prefix, f->name);
+        bool truncated = len >= FILE_MAX_PATH;
+        if (f->type == DIRECTORY_TYPE) {
+            if (truncated) {
+                klog("  %s...\t路径过长，其下的文件未列出\n", path);
+                continue;
+            }
+            path[len] = '/';
+            path[len + 1] = '\0';
+            print_fragmented_files(f, path);
+        } else if (file_inode(f)->block_runs > 1) {
+            klog("  %s%s\t%d 块\t%d 段\n", path, truncated ? "..." : "",
+                   file_inode(f)->block_count, file_inode(f)->block_runs);
+        }
+    }
+}
+
+// 内存与磁盘碎片报告：汇总值均由分配器增量维护
+void display_fragmentation() {
+    int mem_frag = fragmentation_permille(&mem_free_space);
+    int disk_frag = fragmentation_permille(&disk_free_space);
+
+    klog("\n===== 碎片统计 =====\n");
+    klog("内存: 空闲 %d 字节, %d 个空闲块, 最大空闲块 %d, 外部碎片指数 %.3f\n",
+           mem_free_space.total, mem_free_space.regions, mem_free_space.largest, mem_frag / 1000.0);
+    print_free_classes(&mem_free_space, "字节");
+    if (mem_frag >= FRAG_ADVISE_PERMILLE) {
+        klog("  内存碎片较高，建议执行 compact\n");
+    }
+
+    klog("磁盘: 空闲 %d 块, %d 个空闲段, 最大连续空闲段 %d, 外部碎片指数 %.3f\n",
+           disk_free_space.total, disk_free_space.regions, disk_free_space.largest, disk_frag / 1000.0);
+    print_free_classes(&disk_free_space, "块");
+    if (disk_frag >= FRAG_ADVISE_PERMILLE) {
+        klog("  磁盘空闲空间碎片较高，建议执行 defrag\n");
+    }
+
+    klog("文件: %lld 个, %lld 块, %lld 段", file_frag.files, file_frag.blocks, file_frag.runs);
+    if (file_frag.blocks > file_frag.files) {
+        // 顺序链接比例：块链中下一块紧接上一块的链接所占比例
+        klog(", 顺序链接 %.1f%%", 100.0 * (file_frag.blocks - file_frag.runs) /
+                                    (file_frag.blocks - file_frag.files));
+    }
+    klog(", 不连续文件 %lld 个\n", file_frag.fragmented);
+    if (file_frag.fragmented > 0) {
+        klog("文件名\t块数\t段数\n");
+        print_fragmented_files(root_directory, "/");
+    }
+    klog("====================\n\n");
+}
+
+// ======= 磁盘整理 =======
+// 游标之前的文件已排列为连续段；每一步只依据磁盘当前状态决定动作，
+// 两个时钟之间的文件创建/删除（命令循环持有kernel_lock）只需在释放正在排列的文件时置零defrag_inode
+
+// 把文件块迁到空闲块dest：读旧块、写新块，并改写前驱的链接
+static void defrag_relocate(int block, int dest) {
+    int ino = disk_owner[block];
+    Inode *owner = &inode_table[ino];
+    file_frag_account(owner, -1);
+    disk_mark_allocated(dest);
+    disk[dest].next_block = disk[block].next_block;
+    if (owner->first_block == block) {
+        owner->first_block = dest;
+    } else {
+        int prev = owner->first_block;
+        while (disk[prev].next_block != block) {
+            prev = disk[prev].next_block;
+        }
+        disk[prev].next_block = dest;
+    }
+    disk[block].next_block = -1;
+    disk_mark_free(block);
+    disk_owner[dest] = ino;
+    disk_owner[block] = 0;
+    owner->block_runs = chain_runs(owner->first_block);
+    file_frag_account(owner, 1);
+
+    submit_block_request(NULL, block, false);
+    submit_block_request(NULL, dest, true);
+    defrag_stats.blocks_moved++;
+    defrag_run_blocks++;
+}
+
+// 目标窗口[start, start+len)之外的空闲块，优先取窗口之后的
+static int defrag_free_outside(int start, int len) {
+    for (int i = start + len; i < DISK_SIZE/BLOCK_SIZE; i++) {
+        if (!disk[i].is_allocated) return i;
+    }
+    for (int i = 0; i < start; i++) {
+        if (!disk[i].is_allocated) return i;
+    }
+    return -1;
+}
+
+// 整理一步，最多迁移allowance块：返回迁移的块数，-1表示本次整理结束
+static int defrag_step(int allowance) {
+    if (defrag_inode == 0) {
+        // 游标处及之后的第一个文件块决定下一个要排列的文件
+        int p = defrag_cursor;
+        while (p < DISK_SIZE/BLOCK_SIZE && disk_owner[p] == 0) {
+            p++;
+        }
+        if (p == DISK_SIZE/BLOCK_SIZE) return -1;
+        defrag_inode = disk_owner[p];
+    }
+
+    const Inode *file = &inode_table[defrag_inode];
+    int start = defrag_cursor;
+    if (start + file->block_count > DISK_SIZE/BLOCK_SIZE) return -1;
+
+    // 窗口中有不可迁移的块（如交换区）时，从它之后重新开始排列该文件
+    for (int q = start; q < start + file->block_count; q++) {
+        if (disk[q].is_allocated && disk_owner[q] == 0) {
+            defrag_cursor = q + 1;
+            return 0;
+        }
+    }
+
+    // 跳过已在目标位置的前缀
+    int k = 0;
+    int block = file->first_block;
+    while (block != -1 && block == start + k) {
+        block = disk[block].next_block;
+        k++;
+    }
+    if (block == -1) {
+        defrag_cursor = start + file->block_count;
+        defrag_inode = 0;
+        defrag_stats.files_packed++;
+        defrag_run_files++;
+        return 0;
+    }
+
+    // 目标位置被其他块占用时先迁出窗口
+    int target = start + k;
+    int moved = 0;
+    if (disk[target].is_allocated) {
+        int dest = defrag_free_outside(start, file->block_count);
+        if (dest < 0) return -1;
+        defrag_relocate(target, dest);
+        if (allowance < 2) return 1;
+        moved++;
+    }
+    defrag_relocate(block, target);
+    return moved + 1;
+}
+
+// 文件块中已排列到位的比例：游标之前的文件块加上当前文件已到位的前缀
+static int defrag_progress() {
+    if (file_frag.blocks == 0) return 100;
+    int packed = 0;
+    for (int i = 0; i < defrag_cursor; i++) {
+        if (disk_owner[i] != 0) packed++;
+    }
+    if (defrag_inode != 0) {
+        int k = 0;
+        for (int b = inode_table[defrag_inode].first_block; b != -1 && b == defrag_cursor + k; b = disk[b].next_block) {
+            k++;
+        }
+        packed += k;
+    }
+    return (int)(packed * 100 / file_frag.blocks);
+}
+
+// 开始一次磁盘整理；预算为0时立即完成
+void start_defrag() {
+    if (defrag_active) {
+        return;
+    }
+    defrag_active = true;
+    defrag_cursor = 0;
+    defrag_inode = 0;
+    defrag_started = time_counter;
+    defrag_run_blocks = 0;
+    defrag_run_files = 0;
+    klog("[磁盘整理] 开始，每时钟预算 %d 块%s\n", defrag_budget,
+           defrag_budget == 0 ? "（不限，一次完成）" : "");
+    if (defrag_budget == 0) {
+        defrag_tick();
+    }
+}
+
+// 每个时钟迁移不超过预算的块
+void defrag_tick() {
+    if (!defrag_active) {
+        return;
+    }
+    int moved = 0;
+    int result = 0;
+    while (defrag_budget == 0 || moved < defrag_budget) {
+        result = defrag_step(defrag_budget == 0 ? 2 : defrag_budget - moved);
+        if (result < 0) break;
+        moved += result;
+    }
+    defrag_stats.ticks++;
+
+    if (result >= 0) {
+        klog("[磁盘整理] 时间 %d: 本时钟迁移 %d 块，进度 %d%%\n",
+               time_counter, moved, defrag_progress());
+        return;
+    }
+
+    defrag_active = false;
+    defrag_inode = 0;
+    defrag_stats.runs++;
+    klog("[磁盘整理] 完成: 迁移 %lld 块，排列 %lld 个文件，用时 %d 个时钟，不连续文件 %lld 个，最大连续空闲段 %d 块\n",
+           defrag_run_blocks, defrag_run_files, time_counter - defrag_started + 1,
+           file_frag.fragmented, disk_free_space.largest);
+}
+
+// 放弃进行中的整理：已迁移的块保持在新位置，文件内容不受影响
+void stop_defrag() {
+    defrag_active = false;
+    defrag_inode = 0;
+}
+
+void defrag_info(OsDefragInfo *info) {
+    info->active = defrag_active;
+    info->budget = defrag_budget;
+    info->cursor = defrag_cursor;
+    info->progress = defrag_active ? defrag_progress() : 0;
+    info->run_blocks = defrag_run_blocks;
+    info->run_files = defrag_run_files;
+    info->runs = defrag_stats.runs;
+    info->blocks_moved = defrag_stats.blocks_moved;
+    info->files_packed = defrag_stats.files_packed;
+    info->ticks = defrag_stats.ticks;
+}
+
+// ======= 分页虚拟内存 =======
+
+// 初始化页框：全部空闲，按页框号从小到大分配
+void vm_init() {
+    free_frame_count = 0;
+    for (int f = NUM_FRAMES - 1; f >= 0; f--) {
+        frames[f].owner = NULL;
+        frames[f].page = -1;
+        frames[f].refs = 0;
+        frames[f].shared = NULL;
+        free_frames[free_frame_count++] = f;
+    }
+    memset(swap_refs, 0, sizeof(swap_refs));
+    swap_pages_used = 0;
+    memset(tlb, 0, sizeof(tlb));
+    memset(&vm_stats, 0, sizeof(vm_stats));
+    memset(repl_stats, 0, sizeof(repl_stats));
+    clock_hand = 0;
+}
+
+// 选择页面置换算法，可随时切换
+OsStatus set_replacement_policy(const char *name) {
+    for (int p = 0; p < NUM_REPL_POLICIES; p++) {
+        if (strcmp(repl_names[p], name) == 0) {
+            repl_policy = (ReplacementPolicy)p;
+            klog("页面置换算法已设置为: %s\n", repl_names[p]);
+            return OS_OK;
+        }
+    }
+    return OS_ERR_INVALID;
+}
+
+// 切换内存管理模式，只能在没有进程时进行
+OsStatus set_memory_mode(const char *name) {
+    MemoryMode mode;
+    if (strcmp(name, "contiguous") == 0) {
+        mode = MEM_CONTIGUOUS;
+    } else if (strcmp(name, "paging") == 0) {
+        mode = MEM_PAGING;
+    } else {
+        return OS_ERR_INVALID;
+    }
+    for (int pid = 0; pid < pid_table_size; pid++) {
+        if (pid_table[pid] != NULL) {
+            klog("错误: 存在进程时不能切换内存管理模式\n");
+            return OS_ERR_BAD_STATE;
+        }
+    }
+    memory_mode = mode;
+    vm_init();
+    klog("内存管理模式已设置为: %s\n", mode == MEM_PAGING ? "分页（请求调页）" : "连续分配");
+    return OS_OK;
+}
+
+// 建立进程页表，所有页初始不在内存
+void vm_setup_process(PCB *proc) {
+    proc->page_count = (proc->memory_size + PAGE_SIZE - 1) / PAGE_SIZE;
+    proc->page_table = (PageTableEntry*)malloc(proc->page_count * sizeof(PageTableEntry));
+    for (int p = 0; p < proc->page_count; p++) {
+        proc->page_table[p].frame = -1;
+        proc->page_table[p].present = false;
+        proc->page_table[p].referenced = false;
+        proc->page_table[p].dirty = false;
+        proc->page_table[p].cow = false;
+        proc->page_table[p].swap_block = -1;
+    }
+}
+
+// 使快表中pid的page页（page为-1时为该进程全部页）失效
+static void tlb_invalidate(int pid, int page) {
+    for (int i = 0; i < TLB_ENTRIES; i++) {
+        if (tlb[i].valid && tlb[i].pid == pid && (page < 0 || tlb[i].page == page)) {
+            tlb[i].valid = false;
+        }
+    }
+}
+
+// 交换块引用计数：fork后父子进程可共享同一交换块，计数归零才释放
+static void swap_ref(int block) {
+    swap_refs[block]++;
+}
+
+static void swap_unref(int block) {
+    if (--swap_refs[block] == 0) {
+        free_disk_block(block);
+        swap_pages_used--;
+    }
+}
+
+// 为页面分配新的交换块（一页大小的块链），交换区满时返回-1
+static int swap_alloc() {
+    if (swap_pages_used >= SWAP_MAX_PAGES) {
+        return -1;
+    }
+    int block = allocate_disk_block(PAGE_SIZE / BLOCK_SIZE);
+    if (block != -1) {
+        swap_pages_used++;
+    }
+    return block;
+}
+
+static PageTableEntry* frame_pte(int f) {
+    return &frames[f].owner->page_table[frames[f].page];
+}
+
+// 建立页框映射：第一个映射为主映射，fork共享的其余映射挂在shared链表上（反向映射）
+static void frame_add_mapping(int f, PCB *proc, int page) {
+    Frame *frame = &frames[f];
+    if (frame->refs == 0) {
+        frame->owner = proc;
+        frame->page = page;
+    } else {
+        FrameMapping *mapping = (FrameMapping*)malloc(sizeof(FrameMapping));
+        mapping->proc = proc;
+        mapping->page = page;
+        mapping->next = frame->shared;
+        frame->shared = mapping;
+    }
+    frame->refs++;
+}
+
+// 解除proc的page页对页框f的映射，最后一个映射解除时页框回到空闲栈
+static void frame_remove_mapping(int f, PCB *proc, int page) {
+    Frame *frame = &frames[f];
+    if (frame->owner == proc && frame->page == page) {
+        FrameMapping *first = frame->shared;
+        if (first != NULL) {
+            frame->owner = first->proc;
+            frame->page = first->page;
+            frame->shared = first->next;
+            free(first);
+        } else {
+            frame->owner = NULL;
+            frame->page = -1;
+        }
+    } else {
+        FrameMapping **link = &frame->shared;
+        while (*link != NULL && !((*link)->proc == proc && (*link)->page == page)) {
+            link = &(*link)->next;
+        }
+        if (*link != NULL) {
+            FrameMapping *found = *link;
+            *link = found->next;
+            free(found);
+        }
+    }
+    if (--frame->refs == 0) {
+        free_frames[free_frame_count++] = f;
+    }
+}
+
+// 页框的访问位（任一映射被访问即算），读取后清零
+static bool frame_test_and_clear_referenced(int f) {
+    PageTableEntry *pte = frame_pte(f);
+    bool referenced = pte->referenced;
+    pte->referenced = false;
+    for (FrameMapping *m = frames[f].shared; m != NULL; m = m->next) {
+        pte = &m->proc->page_table[m->page];
+        referenced |= pte->referenced;
+        pte->referenced = false;
+    }
+    return referenced;
+}
+
+static bool frame_dirty(int f) {
+    if (frame_pte(f)->dirty) return true;
+    for (FrameMapping *m = frames[f].shared; m != NULL; m = m->next) {
+        if (m->proc->page_table[m->page].dirty) return true;
+    }
+    return false;
+}
+
+// 设置页框所有映射的交换块与修改位
+static void frame_set_swap(int f, int block, bool dirty) {
+    PageTableEntry *pte = frame_pte(f);
+    pte->swap_block = block;
+    pte->dirty = dirty;
+    for (FrameMapping *m = frames[f].shared; m != NULL; m = m->next) {
+        pte = &m->proc->page_table[m->page];
+        pte->swap_block = block;
+        pte->dirty = dirty;
+    }
+}
+
+// 把脏页框写回交换区，写请求经磁盘调度队列。交换块只被本页框的映射引用时原地覆盖，
+// 否则（首次换出或与其他页共享）换用新块。交换区满时丢弃页面内容（计数），按干净页处理
+static void swap_out_frame(int f) {
+    int block = frame_pte(f)->swap_block;
+    if (block == -1 || swap_refs[block] != frames[f].refs) {
+        if (block != -1) {
+            for (int i = 0; i < frames[f].refs; i++) {
+                swap_unref(block);
+            }
+        }
+        block = swap_alloc();
+        if (block == -1) {
+            frame_set_swap(f, -1, false);
+            vm_stats.swap_failures++;
+            repl_stats[repl_policy].swap_failures++;
+            return;
+        }
+        for (int i = 0; i < frames[f].refs; i++) {
+            swap_ref(block);
+        }
+    }
+    frame_set_swap(f, block, false);
+    submit_block_chain(block, true);
+    vm_stats.swap_outs++;
+    repl_stats[repl_policy].swap_outs++;
+}
+
+// 释放进程占用的页框、交换区和页表；共享页框只减少引用
+void vm_release(PCB *proc) {
+    int resident = proc->resident_pages;
+    for (int p = 0; p < proc->page_count; p++) {
+        PageTableEntry *pte = &proc->page_table[p];
+        if (pte->present) {
+            frame_remove_mapping(pte->frame, proc, p);
+        }
+        if (pte->swap_block != -1) {
+            swap_unref(pte->swap_block);
+        }
+    }
+    tlb_invalidate(proc->pid, -1);
+    klog("释放进程 PID=%d 的 %d 个页框映射\n", proc->pid, resident);
+    free(proc->page_table);
+    proc->page_table = NULL;
+    proc->resident_pages = 0;
+}
+
+// 换出页框f：脏页先写回，再解除所有映射
+static void evict_frame(int f) {
+    if (frame_dirty(f)) {
+        swap_out_frame(f);
+    }
+    while (frames[f].refs > 0) {
+        PCB *proc = frames[f].owner;
+        int page = frames[f].page;
+        PageTableEntry *pte = &proc->page_table[page];
+        pte->present = false;
+        pte->frame = -1;
+        pte->cow = false;
+        proc->resident_pages--;
+        tlb_invalidate(proc->pid, page);
+        frame_remove_mapping(f, proc, page);
+    }
+    free_frame_count--;     // 页框直接交给调用者，不经空闲栈
+    vm_stats.evictions++;
+    repl_stats[repl_policy].evictions++;
+}
+
+// 工作集时钟：有访问位的清除并记录访问时刻；不在工作集（超过WSCLOCK_TAU未访问）的干净页直接置换，
+// 脏页先安排写回再继续扫描；扫描两圈仍无合适页时退化为置换第一个干净页或指针处的页
+static int wsclock_victim() {
+    int first_clean = -1;
+    for (int step = 0; step < 2 * NUM_FRAMES; step++) {
+        int f = clock_hand;
+        clock_hand = (clock_hand + 1) % NUM_FRAMES;
+        if (frame_test_and_clear_referenced(f)) {
+            frames[f].last_use = vm_stats.references;
+            continue;
+        }
+        if (vm_stats.references - frames[f].last_use <= WSCLOCK_TAU) {
+            if (!frame_dirty(f) && first_clean < 0) first_clean = f;
+            continue;
+        }
+        if (!frame_dirty(f)) {
+            return f;
+        }
+        swap_out_frame(f);
+        if (first_clean < 0) first_clean = f;
+    }
+    return first_clean >= 0 ? first_clean : clock_hand;
+}
+
+// 按当前置换算法选择牺牲页框
+static int select_victim_frame() {
+    int victim = 0;
+    switch (repl_policy) {
+        case REPL_FIFO:
+            for (int f = 1; f < NUM_FRAMES; f++) {
+                if (frames[f].load_seq < frames[victim].load_seq) victim = f;
+            }
+            break;
+        case REPL_LRU:
+            for (int f = 1; f < NUM_FRAMES; f++) {
+                if (frames[f].last_use < frames[victim].last_use) victim = f;
+            }
+            break;
+        case REPL_CLOCK:
+            // 第二次机会：访问位为1的清零后跳过，最多两圈必然找到
+            while (true) {
+                int f = clock_hand;
+                clock_hand = (clock_hand + 1) % NUM_FRAMES;
+                if (!frame_test_and_clear_referenced(f)) {
+                    victim = f;
+                    break;
+                }
+            }
+            break;
+        case REPL_WSCLOCK:
+            victim = wsclock_victim();
+            break;
+        default:
+            break;
+    }
+    return victim;
+}
+
+// 取得一个空闲页框，无空闲时按置换算法换出一页
+static int vm_alloc_frame() {
+    if (free_frame_count > 0) {
+        return free_frames[--free_frame_count];
+    }
+    int victim = select_victim_frame();
+    evict_frame(victim);
+    return victim;
+}
+
+// 把页框f装给proc的page页
+static void map_new_frame(int f, PCB *proc, int page) {
+    frame_add_mapping(f, proc, page);
+    frames[f].load_seq = frame_load_seq++;
+    frames[f].last_use = vm_stats.references;
+
+    PageTableEntry *pte = &proc->page_table[page];
+    pte->frame = f;
+    pte->present = true;
+    proc->resident_pages++;
+}
+
+// 缺页处理：调入页面并建立映射，曾换出的页从交换区读回
+static void handle_page_fault(PCB *proc, int page) {
+    TRACE(TRACE_PAGE_FAULT, proc->pid, page, 0);
+    int f = vm_alloc_frame();
+    PageTableEntry *pte = &proc->page_table[page];
+    if (pte->swap_block != -1) {
+        submit_block_chain(pte->swap_block, false);
+        vm_stats.swap_ins++;
+        repl_stats[repl_policy].swap_ins++;
+    }
+    map_new_frame(f, proc, page);
+    pte->dirty = false;
+    proc->page_faults++;
+    vm_stats.page_faults++;
+    repl_stats[repl_policy].page_faults++;
+}
+
+// 写时复制：对共享页的写入复制出私有页框；已无其他共享者时直接取得写权限
+static void handle_cow_fault(PCB *proc, int page) {
+    PageTableEntry *pte = &proc->page_table[page];
+    int old = pte->frame;
+    if (frames[old].refs == 1) {
+        pte->cow = false;
+        cow_stats.reused++;
+        return;
+    }
+
+    // 分配新页框可能换出正被共享的页，此时先从交换区读回内容再复制
+    int f = vm_alloc_frame();
+    if (pte->present) {
+        frame_remove_mapping(old, proc, page);
+        proc->resident_pages--;
+    } else if (pte->swap_block != -1) {
+        submit_block_chain(pte->swap_block, false);
+        vm_stats.swap_ins++;
+        repl_stats[repl_policy].swap_ins++;
+    }
+    if (pte->swap_block != -1) {
+        swap_unref(pte->swap_block);   // 私有副本不再与共享者共用交换块
+        pte->swap_block = -1;
+    }
+    map_new_frame(f, proc, page);
+    pte->cow = false;
+    tlb_invalidate(proc->pid, page);
+    cow_stats.copied++;
+}
+
+// 地址转换：先查快表，未命中查页表，页不在内存则缺页调入；写共享页触发写时复制。返回物理地址
+int vm_translate(PCB *proc, int vaddr, bool write) {
+    int page = vaddr / PAGE_SIZE;
+    int offset = vaddr % PAGE_SIZE;
+    PageTableEntry *pte = &proc->page_table[page];
+    vm_stats.references++;
+    repl_stats[repl_policy].references++;
+    tlb_clock++;
+
+    for (int i = 0; i < TLB_ENTRIES; i++) {
+        if (tlb[i].valid && tlb[i].pid == proc->pid && tlb[i].page == page &&
+            !(write && pte->cow)) {
+            vm_stats.tlb_hits++;
+            tlb[i].last_use = tlb_clock;
+            pte->referenced = true;
+            pte->dirty |= write;
+            frames[tlb[i].frame].last_use = vm_stats.references;
+            return tlb[i].frame * PAGE_SIZE + offset;
+        }
+    }
+
+    vm_stats.tlb_misses++;
+    if (!pte->present) {
+        handle_page_fault(proc, page);
+    }
+    if (write && pte->cow) {
+        handle_cow_fault(proc, page);
+    }
+    pte->referenced = true;
+    pte->dirty |= write;
+    frames[pte->frame].last_use = vm_stats.references;
+
+    // 装入快表：优先空项，否则替换最久未使用项
+    int slot = 0;
+    for (int i = 0; i < TLB_ENTRIES; i++) {
+        if (!tlb[i].valid) {
+            slot = i;
+            break;
+        }
+        if (tlb[i].last_use < tlb[slot].last_use) {
+            slot = i;
+        }
+    }
+    tlb[slot].valid = true;
+    tlb[slot].pid = proc->pid;
+    tlb[slot].page = page;
+    tlb[slot].frame = pte->frame;
+    tlb[slot].last_use = tlb_clock;
+    return pte->frame * PAGE_SIZE + offset;
+}
+
+// fork时复制页表：驻留页共享页框，双方标记为写时复制；交换区中的页共享交换块
+void vm_fork(PCB *parent, PCB *child) {
+    vm_setup_process(child);
+    for (int p = 0; p < parent->page_count; p++) {
+        PageTableEntry *pte = &parent->page_table[p];
+        PageTableEntry *copy = &child->page_table[p];
+        *copy = *pte;
+        copy->referenced = false;
+        if (pte->swap_block != -1) {
+            swap_ref(pte->swap_block);
+        }
+        if (pte->present) {
+            pte->cow = true;
+            copy->cow = true;
+            frame_add_mapping(pte->frame, child, p);
+            child->resident_pages++;
+            cow_stats.pages_shared++;
+        }
+    }
+    // 父进程快表中的可写映射失效，之后的写入经写时复制检查
+    tlb_invalidate(parent->pid, -1);
+}
+
+// 模拟运行进程ticks个时钟的访存：大部分访问落在局部性窗口内，窗口周期性迁移
+void vm_run_references(PCB *proc, int ticks) {
+    for (int i = 0; i < ticks * PAGE_REFS_PER_TICK; i++) {
+        if (proc->vm_refs++ % VM_PHASE_REFS == 0) {
+            proc->vm_locality = kernel_rand() % proc->page_count;
+        }
+        int page;
+        if (kernel_rand() % 100 < 90) {
+            page = (proc->vm_locality + kernel_rand() % VM_LOCALITY_PAGES) % proc->page_count;
+        } else {
+            page = kernel_rand() % proc->page_count;
+        }
+        int vaddr = page * PAGE_SIZE + kernel_rand() % PAGE_SIZE;
+        if (vaddr >= proc->memory_size) {
+            vaddr = proc->memory_size - 1;
+        }
+        vm_translate(proc, vaddr, kernel_rand() % 100 < 30);
+    }
+}
+
+// 显示分页内存状态
+void display_paging() {
+    klog("\n===== 内存使用情况（分页） =====\n");
+    klog("页大小: %d, 页框数: %d, 空闲页框: %d\n", PAGE_SIZE, NUM_FRAMES, free_frame_count);
+    klog("\n页框\tPID\t页号\t共享\n");
+    int shared_refs = 0;
+    for (int f = 0; f < NUM_FRAMES; f++) {
+        if (frames[f].owner != NULL) {
+            klog("%d\t%d\t%d\t%d\n", f, frames[f].owner->pid, frames[f].page, frames[f].refs);
+            shared_refs += frames[f].refs - 1;
+        }
+    }
+
+    klog("\nPID\t名称\t虚拟大小\t页数\t驻留\t缺页\n");
+    for (int pid = 0; pid < pid_table_size; pid++) {
+        PCB *proc = pid_table[pid];
+        if (proc == NULL || proc->page_table == NULL) continue;
+        klog("%d\t%s\t%d\t\t%d\t%d\t%lld\n", proc->pid, proc->name, proc->memory_size,
+               proc->page_count, proc->resident_pages, proc->page_faults);
+    }
+
+    long long lookups = vm_stats.tlb_hits + vm_stats.tlb_misses;
+    klog("\n访存: %lld, 快表命中: %lld, 未命中: %lld, 命中率: %.2f%%\n",
+           vm_stats.references, vm_stats.tlb_hits, vm_stats.tlb_misses,
+           lookups > 0 ? 100.0 * vm_stats.tlb_hits / lookups : 0.0);
+    klog("缺页: %lld (缺页率 %.2f%%), 页面置换: %lld\n",
+           vm_stats.page_faults,
+           vm_stats.references > 0 ? 100.0 * vm_stats.page_faults / vm_stats.references : 0.0,
+           vm_stats.evictions);
+
+    klog("交换区(disk[]): 占用 %d/%d 页 (%d 块), 换出 %lld, 换入 %lld, 交换区满丢弃 %lld\n",
+           swap_pages_used, SWAP_MAX_PAGES, swap_pages_used * (PAGE_SIZE / BLOCK_SIZE),
+           vm_stats.swap_outs, vm_stats.swap_ins, vm_stats.swap_failures);
+
+    klog("fork(写时复制): %lld 次, 共享 %lld 页, 写时实际复制 %lld 页, 无需复制 %lld 页; "
+           "当前共享节省 %d 个页框 (%d 字节)\n",
+           cow_stats.cow_forks, cow_stats.pages_shared, cow_stats.copied, cow_stats.reused,
+           shared_refs, shared_refs * PAGE_SIZE);
+
+    klog("\n当前置换算法: %s\n", repl_names[repl_policy]);
+    klog("算法\t访存\t缺页\t缺页率\t置换\t换出\t换入\n");
+    for (int p = 0; p < NUM_REPL_POLICIES; p++) {
+        VMStats *stats = &repl_stats[p];
+        if (stats->references == 0) continue;
+        klog("%s\t%lld\t%lld\t%.2f%%\t%lld\t%lld\t%lld\n",
+               repl_names[p], stats->references, stats->page_faults,
+               100.0 * stats->page_faults / stats->references,
+               stats->evictions, stats->swap_outs, stats->swap_ins);
+    }
+    klog("================================\n\n");
+}
+
+// ======= 共享内存与进程间通信 =======
+
+static int shm_tag(const ShmSegment *seg) {
+    return SHM_PID_BASE - seg->id;
+}
+
+ShmSegment* find_shm(const char *name) {
+    for (ShmSegment *seg = shm_segments; seg != NULL; seg = seg->next) {
+        if (!seg->removed && strcmp(seg->name, name) == 0) {
+            return seg;
+        }
+    }
+    return NULL;
+}
+
+// 按内存块标记查找共享段（紧缩移动共享段时更新起始地址）
+ShmSegment* find_shm_by_tag(int tag) {
+    for (ShmSegment *seg = shm_segments; seg != NULL; seg = seg->next) {
+        if (shm_tag(seg) == tag) {
+            return seg;
+        }
+    }
+    return NULL;
+}
+
+// 创建命名共享段：从内存链表中分配，内存块以负的段标记代替PID
+ShmSegment* shm_create(const char *name, int size, OsStatus *status) {
+    OsStatus ignored;
+    if (status == NULL) status = &ignored;
+    if (memory_mode != MEM_CONTIGUOUS) {
+        klog("错误: 共享内存段只在连续分配模式下从内存区分配\n");
+        *status = OS_ERR_UNSUPPORTED;
+        return NULL;
+    }
+    if (size <= 0 || size > memory_total) {
+        klog("错误: 共享段大小无效\n");
+        *status = OS_ERR_INVALID;
+        return NULL;
+    }
+    if (find_shm(name) != NULL) {
+        klog("错误: 共享段 '%s' 已存在\n", name);
+        *status = OS_ERR_EXISTS;
+        return NULL;
+    }
+
+    ShmSegment *seg = (ShmSegment*)calloc(1, sizeof(ShmSegment));
+    seg->id = next_shm_id++;
+    seg->start = allocate_memory(size, shm_tag(seg));
+    if (seg->start == -1) {
+        klog("错误: 无足够连续内存创建共享段\n");
+        free(seg);
+        *status = OS_ERR_NO_MEMORY;
+        return NULL;
+    }
+    strncpy(seg->name, name, sizeof(seg->name) - 1);
+    seg->size = size;
+    seg->data = (char*)calloc(size, 1);
+    seg->next = shm_segments;
+    shm_segments = seg;
+    klog("共享段 '%s' 已创建: 地址=%d, 大小=%d\n", name, seg->start, size);
+    *status = OS_OK;
+    return seg;
+}
+
+// 释放已删除且无进程连接的共享段
+static void shm_destroy_if_unused(ShmSegment *seg) {
+    if (!seg->removed || seg->refs > 0) {
+        return;
+    }
+    ShmSegment **link = &shm_segments;
+    while (*link != seg) {
+        link = &(*link)->next;
+    }
+    *link = seg->next;
+    free_memory(shm_tag(seg));
+    klog("共享段 '%s' 已释放\n", seg->name);
+    free(seg->channel);
+    free(seg->data);
+    free(seg);
+}
+
+static int shm_attach_index(ShmSegment *seg, int pid) {
+    for (int i = 0; i < seg->refs; i++) {
+        if (seg->attached[i] == pid) return i;
+    }
+    return -1;
+}
+
+OsStatus shm_attach(int pid, const char *name) {
+    ShmSegment *seg = find_shm(name);
+    if (lookup_process(pid) == NULL || seg == NULL) {
+        klog("错误: 进程 PID=%d 或共享段 '%s' 不存在\n", pid, name);
+        return OS_ERR_NOT_FOUND;
+    }
+    if (shm_attach_index(seg, pid) >= 0) {
+        klog("进程 PID=%d 已连接共享段 '%s'\n", pid, name);
+        return OS_OK;
+    }
+    if (seg->refs == MAX_SHM_ATTACH) {
+        klog("错误: 共享段 '%s' 连接数已达上限 %d\n", name, MAX_SHM_ATTACH);
+        return OS_ERR_REJECTED;
+    }
+    seg->attached[seg->refs++] = pid;
+    klog("进程 PID=%d 已连接共享段 '%s'（地址 %d-%d，引用数 %d）\n",
+           pid, name, seg->start, seg->start + seg->size - 1, seg->refs);
+    return OS_OK;
+}
+
+// 断开连接；该进程若是通道的生产者/消费者则让出角色
+static void shm_detach_segment(ShmSegment *seg, int pid) {
+    int i = shm_attach_index(seg, pid);
+    if (i < 0) return;
+    seg->attached[i] = seg->attached[--seg->refs];
+    Channel *chan = seg->channel;
+    if (chan != NULL) {
+        if (chan->producer == pid) chan->producer = -1;
+        if (chan->consumer == pid) chan->consumer = -1;
+        if (chan->waiting_sender == pid) chan->waiting_sender = -1;
+        if (chan->waiting_receiver == pid) chan->waiting_receiver = -1;
+    }
+    shm_destroy_if_unused(seg);
+}
+
+OsStatus shm_detach(int pid, const char *name) {
+    ShmSegment *seg = find_shm(name);
+    if (seg == NULL || shm_attach_index(seg, pid) < 0) {
+        klog("错误: 进程 PID=%d 未连接共享段 '%s'\n", pid, name);
+        return OS_ERR_NOT_FOUND;
+    }
+    klog("进程 PID=%d 已断开共享段 '%s'\n", pid, name);
+    shm_detach_segment(seg, pid);
+    return OS_OK;
+}
+
+// 删除共享段名字；仍有进程连接时等到最后一个断开再释放
+OsStatus shm_remove(const char *name) {
+    ShmSegment *seg = find_shm(name);
+    if (seg == NULL) {
+        klog("错误: 共享段 '%s' 不存在\n", name);
+        return OS_ERR_NOT_FOUND;
+    }
+    seg->removed = true;
+    if (seg->refs > 0) {
+        klog("共享段 '%s' 已标记删除，仍有 %d 个进程连接\n", name, seg->refs);
+    }
+    shm_destroy_if_unused(seg);
+    return OS_OK;
+}
+
+// 进程退出时断开全部共享段
+void shm_release_process(int pid) {
+    ShmSegment *seg = shm_segments;
+    while (seg != NULL) {
+        ShmSegment *next = seg->next;
+        shm_detach_segment(seg, pid);
+        seg = next;
+    }
+}
+
+// 进程不再等待通道（被手动唤醒等），等待中的发送内容作废
+void ipc_cancel_wait(int pid) {
+    for (ShmSegment *seg = shm_segments; seg != NULL; seg = seg->next) {
+        Channel *chan = seg->channel;
+        if (chan == NULL) continue;
+        if (chan->waiting_sender == pid) chan->waiting_sender = -1;
+        if (chan->waiting_receiver == pid) chan->waiting_receiver = -1;
+    }
+}
+
+// 在共享段上建立单生产者单消费者环形通道，消息直接写入/读出段内存，不经内核缓冲复制
+Channel* channel_create(const char *name, int slots, OsStatus *status) {
+    OsStatus ignored;
+    if (status == NULL) status = &ignored;
+    if (slots <= 0) {
+        klog("错误: 通道容量必须大于0\n");
+        *status = OS_ERR_INVALID;
+        return NULL;
+    }
+    ShmSegment *seg = shm_create(name, slots * IPC_MSG_SIZE, status);
+    if (seg == NULL) {
+        return NULL;
+    }
+    Channel *chan = (Channel*)calloc(1, sizeof(Channel));
+    chan->segment = seg;
+    chan->capacity = slots;
+    chan->producer = chan->consumer = -1;
+    chan->waiting_sender = chan->waiting_receiver = -1;
+    chan->created_time = time_counter;
+    seg->channel = chan;
+    klog("通道 '%s' 已创建: %d 个消息槽，每槽 %d 字节\n", name, slots, IPC_MSG_SIZE);
+    *status = OS_OK;
+    return chan;
+}
+
+static void channel_put(Channel *chan, const char *msg) {
+    char *slot = chan->segment->data + (chan->tail % chan->capacity) * IPC_MSG_SIZE;
+    strncpy(slot, msg, IPC_MSG_SIZE - 1);
+    slot[IPC_MSG_SIZE - 1] = '\0';
+    chan->tail++;
+    chan->messages++;
+    chan->bytes += strlen(slot) + 1;
+}
+
+static const char* channel_peek(Channel *chan) {
+    return chan->segment->data + (chan->head % chan->capacity) * IPC_MSG_SIZE;
+}
+
+// 检查进程可以以指定角色使用通道：必须已连接，SPSC通道的两端各只能有一个进程；
+// 角色在第一次成功发送/接收（或阻塞）时才绑定
+static Channel* channel_for(int pid, const char *name, bool producer, OsStatus *status) {
+    ShmSegment *seg = find_shm(name);
+    if (seg == NULL || seg->channel == NULL) {
+        klog("错误: 通道 '%s' 不存在\n", name);
+        *status = OS_ERR_NOT_FOUND;
+        return NULL;
+    }
+    if (shm_attach_index(seg, pid) < 0) {
+        klog("错误: 进程 PID=%d 未连接通道 '%s'，请先 shmattach\n", pid, name);
+        *status = OS_ERR_REJECTED;
+        return NULL;
+    }
+    Channel *chan = seg->channel;
+    int role = producer ? chan->producer : chan->consumer;
+    if (role != -1 && role != pid) {
+        klog("错误: 通道 '%s' 的%s已是 PID=%d（单生产者单消费者）\n",
+               name, producer ? "生产者" : "消费者", role);
+        *status = OS_ERR_REJECTED;
+        return NULL;
+    }
+    *status = OS_OK;
+    return chan;
+}
+
+// 发送：有空槽直接写入；满时阻塞当前运行的发送者，消费者取走消息后唤醒并写入
+OsStatus ipc_send(int pid, const char *name, const char *msg) {
+    OsStatus status;
+    Channel *chan = channel_for(pid, name, true, &status);
+    if (chan == NULL) return status;
+    long long start = now_ns();
+
+    if (chan->tail - chan->head == chan->capacity) {
+        PCB *proc = lookup_process(pid);
+        if (running_process == proc) {
+            chan->producer = pid;
+            strncpy(chan->pending, msg, IPC_MSG_SIZE - 1);
+            chan->pending[IPC_MSG_SIZE - 1] = '\0';
+            chan->waiting_sender = pid;
+            chan->send_blocks++;
+            klog("通道 '%s' 已满\n", name);
+            block_process(pid, WAIT_IPC);
+        } else {
+            klog("通道 '%s' 已满，发送失败\n", name);
+            status = OS_ERR_BAD_STATE;
+        }
+        chan->ns += now_ns() - start;
+        return status;
+    }
+
+    chan->producer = pid;
+    channel_put(chan, msg);
+    klog("进程 PID=%d 向通道 '%s' 发送: %s\n", pid, name, msg);
+
+    // 唤醒等待中的接收者并完成它的接收
+    if (chan->waiting_receiver != -1) {
+        int receiver = chan->waiting_receiver;
+        chan->waiting_receiver = -1;
+        klog("进程 PID=%d 从通道 '%s' 收到: %s\n", receiver, name, channel_peek(chan));
+        chan->head++;
+        wakeup_process(receiver);
+    }
+    chan->ns += now_ns() - start;
+    return OS_OK;
+}
+
+// 接收：有消息直接读出；空时阻塞当前运行的接收者，发送者写入后唤醒
+OsStatus ipc_recv(int pid, const char *name) {
+    OsStatus status;
+    Channel *chan = channel_for(pid, name, false, &status);
+    if (chan == NULL) return status;
+    long long start = now_ns();
+
+    if (chan->tail == chan->head) {
+        PCB *proc = lookup_process(pid);
+        if (running_process == proc) {
+            chan->consumer = pid;
+            chan->waiting_receiver = pid;
+            chan->recv_blocks++;
+            klog("通道 '%s' 为空\n", name);
+            block_process(pid, WAIT_IPC);
+        } else {
+            klog("通道 '%s' 为空，没有可接收的消息\n", name);
+            status = OS_ERR_BAD_STATE;
+        }
+        chan->ns += now_ns() - start;
+        return status;
+    }
+
+    chan->consumer = pid;
+    klog("进程 PID=%d 从通道 '%s' 收到: %s\n", pid, name, channel_peek(chan));
+    chan->head++;
+
+    // 腾出空槽：写入等待中的发送者的消息并唤醒它
+    if (chan->waiting_sender != -1) {
+        int sender = chan->waiting_sender;
+        chan->waiting_sender = -1;
+        channel_put(chan, chan->pending);
+        klog("进程 PID=%d 向通道 '%s' 发送: %s\n", sender, name, chan->pending);
+        wakeup_process(sender);
+    }
+    chan->ns += now_ns() - start;
+    return OS_OK;
+}
+
+// 显示共享段和通道状态
+void display_ipc() {
+    klog("\n===== 共享内存与通道 =====\n");
+    klog("名称\t地址\t大小\t引用\t连接的进程\n");
+    for (ShmSegment *seg = shm_segments; seg != NULL; seg = seg->next) {
+        klog("%s%s\t%d\t%d\t%d\t", seg->name, seg->removed ? "(已删除)" : "",
+               seg->start, seg->size, seg->refs);
+        for (int i = 0; i < seg->refs; i++) {
+            klog("%d ", seg->attached[i]);
+        }
+        klog("\n");
+    }
+
+    klog("\n通道\t容量\t待取\t生产者\t消费者\t消息数\t字节数\t阻塞(发/收)\t吞吐(条/时钟)\t平均耗时(ns)\n");
+    for (ShmSegment *seg = shm_segments; seg != NULL; seg = seg->next) {
+        Channel *chan = seg->channel;
+        if (chan == NULL) continue;
+        int elapsed = time_counter - chan->created_time;
+        long long ops = chan->messages + chan->head;
+        klog("%s\t%d\t%lld\t%d\t%d\t%lld\t%lld\t%lld/%lld\t\t%.2f\t\t%.0f\n",
+               seg->name, chan->capacity, chan->tail - chan->head,
+               chan->producer, chan->consumer, chan->messages, chan->bytes,
+               chan->send_blocks, chan->recv_blocks,
+               elapsed > 0 ? (double)chan->messages / elapsed : (double)chan->messages,
+               ops > 0 ? (double)chan->ns / ops : 0.0);
+    }
+    klog("==========================\n\n");
+}
+
+// ======= 中断控制器 =======
+
+static void timer_vector(const Interrupt *) {
+    timer_interrupt_pending = false;
+    handle_timer_interrupt();
+}
+
+static void io_vector(const Interrupt *irq) {
+    handle_io_interrupt(irq->source);
+}
+
+static void syscall_vector(const Interrupt *irq) {
+    handle_system_call(irq);
+}
+
+// 初始化中断向量表
+void init_interrupt_controller() {
+    interrupt_vector[TIMER_INTERRUPT] = timer_vector;
+    interrupt_vector[IO_INTERRUPT] = io_vector;
+    interrupt_vector[SYSTEM_CALL] = syscall_vector;
+    memset(interrupt_stats, 0, sizeof(interrupt_stats));
+}
+
+// 按名称查找中断类型
+int find_interrupt_type(const char *name) {
+    for (int t = 0; t < NUM_INTERRUPT_TYPES; t++) {
+        if (strcmp(interrupt_names[t], name) == 0) {
+            return t;
+        }
+    }
+    return -1;
+}
+
+// 待处理中断比较：优先级数值小者优先，同优先级先产生者优先
+static bool interrupt_before(const Interrupt *a, const Interrupt *b) {
+    if (a->priority != b->priority) {
+        return a->priority < b->priority;
+    }
+    return a->seq < b->seq;
+}
+
+static void pending_sift_up(InterruptHeap *heap, int i) {
+    Interrupt irq = heap->items[i];
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!interrupt_before(&irq, &heap->items[parent])) break;
+        heap->items[i] = heap->items[parent];
+        i = parent;
+    }
+    heap->items[i] = irq;
+}
+
+static void pending_sift_down(InterruptHeap *heap, int i) {
+    Interrupt irq = heap->items[i];
+    while (true) {
+        int child = 2 * i + 1;
+        if (child >= heap->count) break;
+        if (child + 1 < heap->count &&
+            interrupt_before(&heap->items[child + 1], &heap->items[child])) {
+            child++;
+        }
+        if (!interrupt_before(&heap->items[child], &irq)) break;
+        heap->items[i] = heap->items[child];
+        i = child;
+    }
+    heap->items[i] = irq;
+}
+
+static void pending_push(const Interrupt *irq) {
+    InterruptHeap *heap = &pending_heaps[irq->type];
+    if (heap->count == heap->capacity) {
+        heap->capacity = heap->capacity ? heap->capacity * 2 : 16;
+        heap->items = (Interrupt*)realloc(heap->items, heap->capacity * sizeof(Interrupt));
+    }
+    heap->items[heap->count++] = *irq;
+    pending_sift_up(heap, heap->count - 1);
+    pending_count++;
+}
+
+// 取出可投递的最高优先级中断：未被屏蔽且优先级高于正在处理的中断。
+// 每类中断一个堆，只需比较未屏蔽类型的堆顶，被屏蔽的中断不会拖慢投递
+static bool take_deliverable_interrupt(Interrupt *out) {
+    InterruptHeap *best = NULL;
+    for (int t = 0; t < NUM_INTERRUPT_TYPES; t++) {
+        InterruptHeap *heap = &pending_heaps[t];
+        if (heap->count == 0 || (interrupt_mask & (1u << t)) != 0) continue;
+        if (best == NULL || interrupt_before(&heap->items[0], &best->items[0])) {
+            best = heap;
+        }
+    }
+
+    if (best == NULL || best->items[0].priority >= in_service_priority) {
+        return false;
+    }
+    *out = best->items[0];
+    best->count--;
+    pending_count--;
+    if (best->count > 0) {
+        best->items[0] = best->items[best->count];
+        pending_sift_down(best, 0);
+    }
+    return true;
+}
+
+// 值落入的2的幂直方图桶
+static int latency_bucket(long long value) {
+    int bucket = 0;
+    while (value > 0 && bucket < LATENCY_BUCKETS - 1) {
+        value >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+// 高精度计时（纳秒）
+long long now_ns() {
+    static LARGE_INTEGER frequency = {0};
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+    return (long long)((double)counter.QuadPart * 1e9 / frequency.QuadPart);
+}
+
+// 产生中断：进入待处理队列，可投递时立即处理（可能嵌套在当前处理程序中）
+void raise_interrupt(InterruptType type, int source, int code, int param) {
+    if (type == TIMER_INTERRUPT) {
+        if (timer_interrupt_pending) return;
+        timer_interrupt_pending = true;
+    }
+
+    Interrupt irq;
+    irq.type = type;
+    irq.source = source;
+    irq.priority = interrupt_priority[type];
+    irq.code = code;
+    irq.param = param;
+    irq.raise_time = time_counter;
+    irq.seq = interrupt_seq++;
+
+    InterruptStats *stats = &interrupt_stats[type];
+    stats->raised++;
+    if ((interrupt_mask & (1u << type)) != 0 || irq.priority >= in_service_priority ||
+        interrupt_nesting >= MAX_INTERRUPT_NESTING) {
+        stats->deferred++;
+    }
+
+    pending_push(&irq);
+    dispatch_interrupts();
+}
+
+// 按优先级依次调用向量表中的处理程序
+void dispatch_interrupts() {
+    Interrupt irq;
+    while (interrupt_nesting < MAX_INTERRUPT_NESTING && take_deliverable_interrupt(&irq)) {
+        InterruptStats *stats = &interrupt_stats[irq.type];
+        if (interrupt_nesting > 0) {
+            stats->nested++;
+        }
+        stats->latency_hist[latency_bucket(time_counter - irq.raise_time)]++;
+
+        // 进入处理程序：提升正在处理的优先级，只允许更高优先级的中断嵌套
+        int saved_priority = in_service_priority;
+        in_service_priority = irq.priority;
+        interrupt_nesting++;
+        if (interrupt_nesting > max_interrupt_nesting) {
+            max_interrupt_nesting = interrupt_nesting;
+        }
+
+        TRACE(TRACE_IRQ, irq.source, irq.type, irq.code);
+        long long start = now_ns();
+        interrupt_vector[irq.type](&irq);
+        long long elapsed = now_ns() - start;
+
+        interrupt_nesting--;
+        in_service_priority = saved_priority;
+
+        stats->handled++;
+        stats->total_handler_ns += elapsed;
+        stats->handler_ns_hist[latency_bucket(elapsed)]++;
+    }
+}
+
+// 系统调用处理
+void handle_system_call(const Interrupt *irq) {
+    switch (irq->code) {
+        case SYS_IO_REQUEST:
+            block_process(irq->source, irq->param);
+            break;
+        case SYS_FORK:
+            fork_process(irq->source);
+            break;
+        case SYS_MUTEX_LOCK:
+        case SYS_MUTEX_UNLOCK:
+        case SYS_SEM_WAIT:
+        case SYS_SEM_POST:
+        case SYS_COND_WAIT:
+        case SYS_COND_SIGNAL:
+        case SYS_COND_BROADCAST:
+            sync_syscall(irq->source, irq->code, irq->param);
+            break;
+        default:
+            klog("未知系统调用 %d (PID=%d)\n", irq->code, irq->source);
+            break;
+    }
+}
+
+// 打印一个2的幂直方图
+static void print_histogram(const char *title, const long long *hist, const char *unit) {
+    long long total = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) total += hist[b];
+    if (total == 0) return;
+
+    klog("  %s:\n", title);
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        if (hist[b] == 0) continue;
+        long long low = (b == 0) ? 0 : (1LL << (b - 1));
+        long long high = (b == 0) ? 0 : (1LL << b) - 1;
+        int bar = (int)(40 * hist[b] / total);
+        char bars[41];
+        memset(bars, '#', bar);
+        bars[bar] = '\0';
+        klog("    [%lld-%lld]%s\t%lld\t%s\n", low, high, unit, hist[b], bars);
+    }
+}
+
+// 显示中断控制器统计
+void display_interrupt_stats() {
+    klog("待处理中断: %d, 当前嵌套深度: %d, 最大嵌套深度: %d\n",
+           pending_count, interrupt_nesting, max_interrupt_nesting);
+    klog("\n类型\t优先级\t屏蔽\t产生\t处理\t延后\t嵌套\t平均处理耗时(ns)\n");
+    for (int t = 0; t < NUM_INTERRUPT_TYPES; t++) {
+        InterruptStats *stats = &interrupt_stats[t];
+        klog("%s\t%d\t%s\t%lld\t%lld\t%lld\t%lld\t%.0f\n",
+               interrupt_names[t], interrupt_priority[t],
+               (interrupt_mask & (1u << t)) ? "是" : "否",
+               stats->raised, stats->handled, stats->deferred, stats->nested,
+               stats->handled > 0 ? (double)stats->total_handler_ns / stats->handled : 0.0);
+    }
+    for (int t = 0; t < NUM_INTERRUPT_TYPES; t++) {
+        InterruptStats *stats = &interrupt_stats[t];
+        if (stats->handled == 0) continue;
+        klog("\n%s 中断:\n", interrupt_names[t]);
+        print_histogram("响应延迟", stats->latency_hist, "时钟");
+        print_histogram("处理耗时", stats->handler_ns_hist, "ns");
+    }
+
+    InjectRing *ring = &injection_ring;
+    klog("\n注入队列: 容量 %ld, 已取出 %lld, 丢弃 %ld, 待取出 %ld, 入队延迟 平均%.0fns 最大%lldns\n",
+           ring->mask + 1, ring->drained, ring->dropped, ring->tail - ring->head,
+           ring->drained > 0 ? (double)ring->total_latency_ns / ring->drained : 0.0,
+           ring->max_latency_ns);
+    print_histogram("入队延迟", ring->latency_hist, "ns");
+}
+
+// ======= 同步原语 =======
+
+SyncObject* find_sync(const char *name) {
+    for (SyncObject *obj = sync_objects; obj != NULL; obj = obj->next) {
+        if (strcmp(obj->name, name) == 0) {
+            return obj;
+        }
+    }
+    return NULL;
+}
+
+SyncObject* find_sync_by_id(int id) {
+    for (SyncObject *obj = sync_objects; obj != NULL; obj = obj->next) {
+        if (obj->id == id) {
+            return obj;
+        }
+    }
+    return NULL;
+}
+
+// 创建互斥锁/信号量/条件变量；条件变量绑定一个互斥锁（管程式用法）
+SyncObject* sync_create(SyncType type, const char *name, int value, SyncObject *mutex,
+                        OsStatus *status) {
+    OsStatus ignored;
+    if (status == NULL) status = &ignored;
+    if (find_sync(name) != NULL) {
+        klog("错误: 同步对象 '%s' 已存在\n", name);
+        *status = OS_ERR_EXISTS;
+        return NULL;
+    }
+    if (type == SYNC_SEMAPHORE && value < 0) {
+        klog("错误: 信号量初值不能为负\n");
+        *status = OS_ERR_INVALID;
+        return NULL;
+    }
+    if (type == SYNC_CONDVAR && (mutex == NULL || mutex->type != SYNC_MUTEX)) {
+        klog("错误: 条件变量必须绑定一个已存在的互斥锁\n");
+        *status = OS_ERR_NOT_FOUND;
+        return NULL;
+    }
+
+    SyncObject *obj = (SyncObject*)calloc(1, sizeof(SyncObject));
+    obj->id = next_sync_id++;
+    obj->type = type;
+    strncpy(obj->name, name, sizeof(obj->name) - 1);
+    obj->value = value;
+    obj->owner = -1;
+    obj->mutex = mutex;
+    obj->next = sync_objects;
+    sync_objects = obj;
+    klog("%s '%s' 已创建 (ID=%d)\n", sync_type_names[type], name, obj->id);
+    *status = OS_OK;
+    return obj;
+}
+
+// 等待队列：头出尾进，唤醒O(1)
+static void sync_enqueue(SyncObject *obj, PCB *proc) {
+    proc->sync_wait = obj;
+    proc->sync_next = NULL;
+    if (obj->wait_tail != NULL) {
+        obj->wait_tail->sync_next = proc;
+    } else {
+        obj->wait_head = proc;
+    }
+    obj->wait_tail = proc;
+    obj->waiting++;
+    if (obj->waiting > obj->max_waiting) {
+        obj->max_waiting = obj->waiting;
+    }
+}
+
+static PCB* sync_dequeue(SyncObject *obj) {
+    PCB *proc = obj->wait_head;
+    if (proc == NULL) return NULL;
+    obj->wait_head = proc->sync_next;
+    if (obj->wait_head == NULL) {
+        obj->wait_tail = NULL;
+    }
+    obj->waiting--;
+    proc->sync_next = NULL;
+    proc->sync_wait = NULL;
+    return proc;
+}
+
+// 记录一次等待结束的时长
+static void sync_account_wait(SyncObject *obj, PCB *proc) {
+    int waited = time_counter - proc->sync_wait_start;
+    obj->total_wait += waited;
+    if (waited > obj->max_wait) {
+        obj->max_wait = waited;
+    }
+    obj->wait_hist[latency_bucket(waited)]++;
+}
+
+// 修改优先级；就绪进程需重新入队以保持就绪结构有序
+static void sync_set_priority(PCB *proc, int priority) {
+    if (proc->priority == priority) return;
+    if (proc->state == READY && remove_pid_from_ready_queue(proc->pid) != NULL) {
+        proc->priority = priority;
+        add_to_ready_queue(proc);
+    } else {
+        proc->priority = priority;
+    }
+}
+
+// 优先级继承：等待者优先级高于锁持有者时提升持有者，沿“持有者也在等锁”的链传递
+static void sync_inherit_priority(SyncObject *mutex, int priority) {
+    for (int depth = 0; mutex != NULL && depth < SYNC_PI_MAX_DEPTH; depth++) {
+        PCB *owner = lookup_process(mutex->owner);
+        if (owner == NULL || is_rt(owner) || owner->priority <= priority) {
+            return;
+        }
+        klog("优先级继承: 进程 %s (PID=%d) 优先级 %d -> %d\n",
+               owner->name, owner->pid, owner->priority, priority);
+        sync_set_priority(owner, priority);
+        sync_pi_boosts++;
+        mutex = (owner->sync_wait != NULL && owner->sync_wait->type == SYNC_MUTEX) ?
+                owner->sync_wait : NULL;
+    }
+}
+
+// 释放锁后重新计算继承的优先级：基础优先级与仍持有的锁上等待者的最高优先级
+static void sync_restore_priority(PCB *proc) {
+    int priority = proc->base_priority;
+    if (priority_inheritance) {
+        for (SyncObject *obj = sync_objects; obj != NULL; obj = obj->next) {
+            if (obj->type != SYNC_MUTEX || obj->owner != proc->pid) continue;
+            for (PCB *w = obj->wait_head; w != NULL; w = w->sync_next) {
+                if (w->priority < priority) priority = w->priority;
+            }
+        }
+    }
+    sync_set_priority(proc, priority);
+}
+
+// 阻塞当前运行的进程到对象的等待队列
+static bool sync_block(SyncObject *obj, PCB *proc) {
+    if (running_process != proc) {
+        klog("只能阻塞当前运行的进程，PID=%d不是当前运行的进程\n", proc->pid);
+        return false;
+    }
+    obj->contended++;
+    proc->sync_wait_start = time_counter;
+    sync_enqueue(obj, proc);
+    if (obj->type == SYNC_MUTEX && priority_inheritance && current_algorithm == PRIORITY) {
+        sync_inherit_priority(obj, proc->priority);
+    }
+    block_process(proc->pid, WAIT_SYNC);
+    if (obj->type == SYNC_MUTEX) {
+        deadlock_check(proc);
+    }
+    return true;
+}
+
+// 把互斥锁交给进程：空闲则立即获得并唤醒，否则排队继续阻塞（条件变量唤醒后重新获取锁）
+static void mutex_grant(SyncObject *mutex, PCB *proc) {
+    if (mutex->owner == -1) {
+        mutex->owner = proc->pid;
+        mutex->acquires++;
+        klog("进程 PID=%d 获得互斥锁 '%s'\n", proc->pid, mutex->name);
+        wakeup_process(proc->pid);
+    } else {
+        mutex->contended++;
+        proc->sync_wait_start = time_counter;
+        sync_enqueue(mutex, proc);
+        if (priority_inheritance && current_algorithm == PRIORITY) {
+            sync_inherit_priority(mutex, proc->priority);
+        }
+    }
+}
+
+bool mutex_lock(SyncObject *mutex, PCB *proc) {
+    if (mutex->owner == proc->pid) {
+        klog("错误: 进程 PID=%d 已持有互斥锁 '%s'\n", proc->pid, mutex->name);
+        return false;
+    }
+    if (mutex->owner == -1) {
+        mutex->owner = proc->pid;
+        mutex->acquires++;
+        klog("进程 PID=%d 获得互斥锁 '%s'\n", proc->pid, mutex->name);
+        return true;
+    }
+    klog("互斥锁 '%s' 被 PID=%d 持有\n", mutex->name, mutex->owner);
+    return sync_block(mutex, proc);
+}
+
+// 解锁：有等待者则按FIFO直接移交所有权
+bool mutex_unlock(SyncObject *mutex, PCB *proc) {
+    if (mutex->owner != proc->pid) {
+        klog("错误: 进程 PID=%d 未持有互斥锁 '%s'\n", proc->pid, mutex->name);
+        return false;
+    }
+    mutex->owner = -1;
+    klog("进程 PID=%d 释放互斥锁 '%s'\n", proc->pid, mutex->name);
+    PCB *next = sync_dequeue(mutex);
+    if (next != NULL) {
+        sync_account_wait(mutex, next);
+        mutex->handoffs++;
+        mutex_grant(mutex, next);
+    }
+    if (proc->priority != proc->base_priority) {
+        sync_restore_priority(proc);
+    }
+    return true;
+}
+
+bool sem_wait(SyncObject *sem, PCB *proc) {
+    if (sem->value > 0) {
+        sem->value--;
+        sem->acquires++;
+        klog("进程 PID=%d 通过信号量 '%s'（剩余 %d）\n", proc->pid, sem->name, sem->value);
+        return true;
+    }
+    klog("信号量 '%s' 为0\n", sem->name);
+    return sync_block(sem, proc);
+}
+
+// V操作：有等待者时把计数直接交给队首进程
+void sem_post(SyncObject *sem, PCB *proc) {
+    PCB *next = sync_dequeue(sem);
+    if (next == NULL) {
+        sem->value++;
+        klog("进程 PID=%d 释放信号量 '%s'（当前 %d）\n", proc->pid, sem->name, sem->value);
+        return;
+    }
+    sync_account_wait(sem, next);
+    sem->acquires++;
+    sem->handoffs++;
+    klog("进程 PID=%d 释放信号量 '%s'，进程 PID=%d 通过\n", proc->pid, sem->name, next->pid);
+    wakeup_process(next->pid);
+}
+
+// 等待条件：必须持有绑定的互斥锁，释放锁并阻塞，被唤醒前重新获得锁
+bool cond_wait(SyncObject *cond, PCB *proc) {
+    if (cond->mutex->owner != proc->pid) {
+        klog("错误: 进程 PID=%d 须先持有互斥锁 '%s'\n", proc->pid, cond->mutex->name);
+        return false;
+    }
+    if (running_process != proc) {
+        klog("只能阻塞当前运行的进程，PID=%d不是当前运行的进程\n", proc->pid);
+        return false;
+    }
+    // 先入条件队列再解锁，解锁引起的重新调度不会错过本进程
+    cond->contended++;
+    proc->sync_wait_start = time_counter;
+    sync_enqueue(cond, proc);
+    mutex_unlock(cond->mutex, proc);
+    block_process(proc->pid, WAIT_SYNC);
+    return true;
+}
+
+// 唤醒一个（或全部）等待者，它们转去竞争绑定的互斥锁
+int cond_signal(SyncObject *cond, bool broadcast) {
+    int woken = 0;
+    PCB *proc;
+    while ((proc = sync_dequeue(cond)) != NULL) {
+        sync_account_wait(cond, proc);
+        cond->acquires++;
+        woken++;
+        mutex_grant(cond->mutex, proc);
+        if (!broadcast) break;
+    }
+    klog("条件变量 '%s' 唤醒 %d 个进程\n", cond->name, woken);
+    return woken;
+}
+
+// 手动唤醒等：进程离开等待队列（单向链表，需从头查找）
+void sync_cancel_wait(PCB *proc) {
+    SyncObject *obj = proc->sync_wait;
+    if (obj == NULL) return;
+    PCB **link = &obj->wait_head;
+    PCB *prev = NULL;
+    while (*link != NULL && *link != proc) {
+        prev = *link;
+        link = &(*link)->sync_next;
+    }
+    if (*link == proc) {
+        *link = proc->sync_next;
+        if (obj->wait_tail == proc) {
+            obj->wait_tail = prev;
+        }
+        obj->waiting--;
+    }
+    proc->sync_next = NULL;
+    proc->sync_wait = NULL;
+}
+
+// 进程退出：离开等待队列并释放持有的互斥锁
+void sync_release_process(PCB *proc) {
+    sync_cancel_wait(proc);
+    for (SyncObject *obj = sync_objects; obj != NULL; obj = obj->next) {
+        if (obj->type == SYNC_MUTEX && obj->owner == proc->pid) {
+            mutex_unlock(obj, proc);
+        }
+    }
+}
+
+// 同步操作的系统调用入口，参数为对象ID
+void sync_syscall(int pid, int code, int id) {
+    PCB *proc = lookup_process(pid);
+    SyncObject *obj = find_sync_by_id(id);
+    if (proc == NULL || obj == NULL) {
+        klog("错误: 进程 PID=%d 或同步对象 %d 不存在\n", pid, id);
+        return;
+    }
+    SyncType expected = (code == SYS_MUTEX_LOCK || code == SYS_MUTEX_UNLOCK) ? SYNC_MUTEX :
+                        (code == SYS_SEM_WAIT || code == SYS_SEM_POST) ? SYNC_SEMAPHORE : SYNC_CONDVAR;
+    if (obj->type != expected) {
+        klog("错误: '%s' 是%s，不是%s\n", obj->name, sync_type_names[obj->type],
+               sync_type_names[expected]);
+        return;
+    }
+
+    switch (code) {
+        case SYS_MUTEX_LOCK:     mutex_lock(obj, proc); break;
+        case SYS_MUTEX_UNLOCK:   mutex_unlock(obj, proc); break;
+        case SYS_SEM_WAIT:       sem_wait(obj, proc); break;
+        case SYS_SEM_POST:       sem_post(obj, proc); break;
+        case SYS_COND_WAIT:      cond_wait(obj, proc); break;
+        case SYS_COND_SIGNAL:    cond_signal(obj, false); break;
+        case SYS_COND_BROADCAST: cond_signal(obj, true); break;
+        default: break;
+    }
+}
+
+// 显示同步对象的状态、竞争与等待时间统计
+void display_sync() {
+    klog("\n===== 同步对象 =====\n");
+    klog("优先级继承: %s（仅优先级调度生效），已提升 %lld 次\n",
+           priority_inheritance ? "开启" : "关闭", sync_pi_boosts);
+    klog("名称\t类型\t状态\t\t等待\t最多等待\t获得\t竞争\t竞争率\t移交\t平均等待\t最长等待\n");
+    for (SyncObject *obj = sync_objects; obj != NULL; obj = obj->next) {
+        char state[24];
+        if (obj->type == SYNC_MUTEX) {
+            if (obj->owner == -1) snprintf(state, sizeof(state), "空闲");
+            else snprintf(state, sizeof(state), "持有者%d", obj->owner);
+        } else if (obj->type == SYNC_SEMAPHORE) {
+            snprintf(state, sizeof(state), "值=%d", obj->value);
+        } else {
+            snprintf(state, sizeof(state), "锁=%s", obj->mutex->name);
+        }
+        long long waits = 0;
+        for (int b = 0; b < LATENCY_BUCKETS; b++) waits += obj->wait_hist[b];
+        long long attempts = obj->acquires + obj->waiting;
+        klog("%s\t%s\t%s\t\t%d\t%d\t\t%lld\t%lld\t%.1f%%\t%lld\t%.2f\t\t%d\n",
+               obj->name, sync_type_names[obj->type], state, obj->waiting, obj->max_waiting,
+               obj->acquires, obj->contended,
+               attempts > 0 ? 100.0 * obj->contended / attempts : 0.0,
+               obj->handoffs, waits > 0 ? (double)obj->total_wait / waits : 0.0, obj->max_wait);
+        if (obj->waiting > 0) {
+            klog("  等待队列:");
+            for (PCB *w = obj->wait_head; w != NULL; w = w->sync_next) {
+                klog(" %d", w->pid);
+            }
+            klog("\n");
+        }
+        print_histogram("等待时间分布", obj->wait_hist, "时钟");
+    }
+    klog("====================\n\n");
+}
+
+// ======= 资源管理与死锁检测 =======
+
+int find_resource(const char *name) {
+    for (int r = 0; r < num_resources; r++) {
+        if (strcmp(resources[r].name, name) == 0) {
+            return r;
+        }
+    }
+    return -1;
+}
+
+// 创建资源类型：units为总单位数，claim为新进程默认声明的最大需求
+OsStatus resource_create(const char *name, int units, int claim) {
+    if (find_resource(name) >= 0) {
+        klog("错误: 资源 '%s' 已存在\n", name);
+        return OS_ERR_EXISTS;
+    }
+    if (num_resources == MAX_RESOURCE_TYPES) {
+        klog("错误: 资源类型已达上限 %d\n", MAX_RESOURCE_TYPES);
+        return OS_ERR_REJECTED;
+    }
+    if (units <= 0 || claim < 0) {
+        klog("错误: 资源单位数必须大于0，声明不能为负\n");
+        return OS_ERR_INVALID;
+    }
+    Resource *res = &resources[num_resources];
+    memset(res, 0, sizeof(Resource));
+    strncpy(res->name, name, sizeof(res->name) - 1);
+    res->total = res->available = units;
+    res->default_claim = claim;
+    // 已存在的进程按默认声明补齐
+    for (int pid = 0; pid < pid_table_size; pid++) {
+        if (pid_table[pid] != NULL) {
+            pid_table[pid]->res_claim[num_resources] = claim;
+        }
+    }
+    klog("资源 '%s' 已创建: %d 个单位，默认最大需求 %d\n", name, units, claim);
+    num_resources++;
+    return OS_OK;
+}
+
+static void holder_add(Resource *res, int pid) {
+    if (res->holder_count == res->holder_capacity) {
+        res->holder_capacity = res->holder_capacity ? res->holder_capacity * 2 : 4;
+        res->holders = (int*)realloc(res->holders, res->holder_capacity * sizeof(int));
+    }
+    res->holders[res->holder_count++] = pid;
+}
+
+static void holder_remove(Resource *res, int pid) {
+    for (int i = 0; i < res->holder_count; i++) {
+        if (res->holders[i] == pid) {
+            res->holders[i] = res->holders[--res->holder_count];
+            return;
+        }
+    }
+}
+
+// 银行家算法安全性检查：假设extra进程再分配request[]后，是否存在所有进程都能完成的序列
+bool banker_safe(PCB *extra, const int *request) {
+    int work[MAX_RESOURCE_TYPES];
+    for (int r = 0; r < num_resources; r++) {
+        work[r] = resources[r].available - (extra != NULL ? request[r] : 0);
+        if (work[r] < 0) return false;
+    }
+
+    // 收集持有或声明资源的进程，逐轮找出需求可被满足的进程并回收其资源
+    int count = 0;
+    PCB **procs = (PCB**)malloc((pid_table_size + 1) * sizeof(PCB*));
+    for (int pid = 0; pid < pid_table_size; pid++) {
+        if (pid_table[pid] != NULL) procs[count++] = pid_table[pid];
+    }
+    bool progress = true;
+    int finished = 0;
+    while (progress && finished < count) {
+        progress = false;
+        for (int i = finished; i < count; i++) {
+            PCB *p = procs[i];
+            bool can_finish = true;
+            for (int r = 0; r < num_resources && can_finish; r++) {
+                int held = p->res_alloc[r] + (p == extra ? request[r] : 0);
+                if (p->res_claim[r] - held > work[r]) can_finish = false;
+            }
+            if (!can_finish) continue;
+            for (int r = 0; r < num_resources; r++) {
+                work[r] += p->res_alloc[r] + (p == extra ? request[r] : 0);
+            }
+            procs[i] = procs[finished];
+            procs[finished++] = p;
+            progress = true;
+        }
+    }
+    free(procs);
+    banker_checks++;
+    return finished == count;
+}
+
+// 新进程准入：声明的最大需求不能超过资源总量，加入后状态仍须安全
+bool banker_admit(const char *name) {
+    if (!banker_enabled) return true;
+    for (int r = 0; r < num_resources; r++) {
+        if (resources[r].default_claim > resources[r].total) {
+            klog("错误: 银行家算法拒绝创建进程 %s: 对资源 '%s' 的最大需求 %d 超过总量 %d\n",
+                   name, resources[r].name, resources[r].default_claim, resources[r].total);
+            banker_rejections++;
+            return false;
+        }
+    }
+    if (!banker_safe(NULL, NULL)) {
+        klog("错误: 银行家算法拒绝创建进程 %s: 当前状态不安全\n", name);
+        banker_rejections++;
+        return false;
+    }
+    return true;
+}
+
+// 尝试把count个单位分配给进程；银行家模式下分配后不安全则不分配
+static bool resource_try_grant(PCB *proc, int r, int count) {
+    Resource *res = &resources[r];
+    if (res->available < count) return false;
+    if (banker_enabled) {
+        int request[MAX_RESOURCE_TYPES] = {0};
+        request[r] = count;
+        if (!banker_safe(proc, request)) {
+            res->unsafe_denials++;
+            return false;
+        }
+    }
+    if (proc->res_alloc[r] == 0) {
+        holder_add(res, proc->pid);
+    }
+    res->available -= count;
+    proc->res_alloc[r] += count;
+    res->grants++;
+    return true;
+}
+
+static PCB* resource_dequeue(Resource *res) {
+    PCB *proc = res->wait_head;
+    res->wait_head = proc->res_next;
+    if (res->wait_head == NULL) res->wait_tail = NULL;
+    proc->res_next = NULL;
+    res->waiting--;
+    return proc;
+}
+
+// 释放后按FIFO满足各资源等待队列的队首进程（银行家模式下释放可能使其他资源的请求变得安全）
+static void resource_grant_waiters() {
+    bool granted = true;
+    while (granted) {
+        granted = false;
+        for (int r = 0; r < num_resources; r++) {
+            Resource *res = &resources[r];
+            while (res->wait_head != NULL &&
+                   resource_try_grant(res->wait_head, r, res->wait_head->res_wait_count)) {
+                PCB *proc = resource_dequeue(res);
+                res->total_wait += time_counter - proc->res_wait_start;
+                klog("进程 PID=%d 获得资源 '%s' %d 个单位\n", proc->pid, res->name,
+                       proc->res_wait_count);
+                proc->res_wait = -1;
+                proc->res_wait_count = 0;
+                wakeup_process(proc->pid);
+                granted = true;
+            }
+        }
+    }
+}
+
+// 以进程为起点沿等待图搜索回到自身的环：只遍历从新阻塞进程可达的边
+static bool find_wait_cycle(PCB *start) {
+    wfg_epoch++;
+    int capacity = 16, top = 0;
+    PCB **stack = (PCB**)malloc(capacity * sizeof(PCB*));
+    start->wfg_stamp = wfg_epoch;
+    start->wfg_from = NULL;
+    stack[top++] = start;
+    bool found = false;
+    long long edges = 0;
+
+    while (top > 0 && !found) {
+        PCB *p = stack[--top];
+        // p等待的对象的持有者即p的出边
+        int owners_single[1];
+        const int *owners = NULL;
+        int owner_count = 0;
+        if (p->res_wait >= 0) {
+            owners = resources[p->res_wait].holders;
+            owner_count = resources[p->res_wait].holder_count;
+        } else if (p->sync_wait != NULL && p->sync_wait->type == SYNC_MUTEX &&
+                   p->sync_wait->owner != -1) {
+            owners_single[0] = p->sync_wait->owner;
+            owners = owners_single;
+            owner_count = 1;
+        }
+        for (int i = 0; i < owner_count; i++) {
+            edges++;
+            PCB *q = lookup_process(owners[i]);
+            if (q == NULL) continue;
+            if (q == start) {
+                start->wfg_from = p;
+                found = true;
+                break;
+            }
+            if (q->wfg_stamp == wfg_epoch) continue;
+            q->wfg_stamp = wfg_epoch;
+            q->wfg_from = p;
+            if (top == capacity) {
+                capacity *= 2;
+                stack = (PCB**)realloc(stack, capacity * sizeof(PCB*));
+            }
+            stack[top++] = q;
+        }
+    }
+    free(stack);
+    deadlock_stats.checks++;
+    deadlock_stats.edges_scanned += edges;
+    return found;
+}
+
+// 归约检测：反复回收“等待请求可满足或未在等待”的进程，剩下的即死锁进程（多单位资源上的环不一定是死锁）
+static int detect_deadlocked(bool *deadlocked) {
+    int work[MAX_RESOURCE_TYPES];
+    for (int r = 0; r < num_resources; r++) work[r] = resources[r].available;
+    for (int pid = 0; pid < pid_table_size; pid++) {
+        deadlocked[pid] = pid_table[pid] != NULL && pid_table[pid]->state == BLOCKED &&
+                          (pid_table[pid]->res_wait >= 0 || pid_table[pid]->sync_wait != NULL);
+    }
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        for (int pid = 0; pid < pid_table_size; pid++) {
+            if (!deadlocked[pid]) continue;
+            PCB *p = pid_table[pid];
+            bool can_proceed;
+            if (p->res_wait >= 0) {
+                can_proceed = p->res_wait_count <= work[p->res_wait];
+            } else if (p->sync_wait->type == SYNC_MUTEX) {
+                int owner = p->sync_wait->owner;
+                can_proceed = owner == -1 || owner >= pid_table_size || !deadlocked[owner];
+            } else {
+                can_proceed = true;  // 信号量/条件变量没有持有者，由其他进程释放
+            }
+            if (!can_proceed) continue;
+            deadlocked[pid] = false;
+            for (int r = 0; r < num_resources; r++) work[r] += p->res_alloc[r];
+            progress = true;
+        }
+    }
+    int count = 0;
+    for (int pid = 0; pid < pid_table_size; pid++) {
+        if (deadlocked[pid]) count++;
+    }
+    return count;
+}
+
+// 进程阻塞后调用：发现等待环时用归约算法确认并报告死锁进程
+void deadlock_check(PCB *proc) {
+    if (!find_wait_cycle(proc)) return;
+    deadlock_stats.cycles++;
+
+    klog("[死锁检测] 发现等待环（A <- B 表示B等待A）:");
+    int guard = 0;
+    for (PCB *p = proc; p != NULL && guard <= pid_table_size; p = p->wfg_from, guard++) {
+        klog(" %d <-", p->pid);
+        if (p->wfg_from == proc) break;
+    }
+    klog(" %d\n", proc->pid);
+
+    bool *deadlocked = (bool*)malloc(pid_table_size * sizeof(bool));
+    int count = detect_deadlocked(deadlocked);
+    if (count > 0) {
+        deadlock_stats.deadlocks++;
+        klog("[死锁检测] 死锁进程(%d):", count);
+        for (int pid = 0; pid < pid_table_size; pid++) {
+            if (deadlocked[pid]) klog(" %d", pid);
+        }
+        klog("，可用 kill 终止其中的进程解除\n");
+    } else {
+        klog("[死锁检测] 环上的多单位资源仍可满足，暂不构成死锁\n");
+    }
+    free(deadlocked);
+}
+
+// 申请资源：可满足则立即分配，否则阻塞正在运行的进程
+OsStatus resource_request(int pid, const char *name, int count) {
+    PCB *proc = lookup_process(pid);
+    int r = find_resource(name);
+    if (proc == NULL || r < 0 || count <= 0) {
+        klog("错误: 进程 PID=%d 或资源 '%s' 不存在，或数量无效\n", pid, name);
+        return count <= 0 ? OS_ERR_INVALID : OS_ERR_NOT_FOUND;
+    }
+    Resource *res = &resources[r];
+    if (proc->res_alloc[r] + count > (banker_enabled ? proc->res_claim[r] : res->total)) {
+        klog("错误: 申请超过%s（已持有 %d，申请 %d，上限 %d）\n",
+               banker_enabled ? "声明的最大需求" : "资源总量", proc->res_alloc[r], count,
+               banker_enabled ? proc->res_claim[r] : res->total);
+        return OS_ERR_REJECTED;
+    }
+    res->requests++;
+    // 有进程在排队时不插队，保证FIFO
+    if (res->wait_head == NULL && resource_try_grant(proc, r, count)) {
+        klog("进程 PID=%d 获得资源 '%s' %d 个单位（剩余 %d）\n", pid, name, count, res->available);
+        return OS_OK;
+    }
+    if (running_process != proc) {
+        klog("资源 '%s' 暂不能分配，只能阻塞当前运行的进程，PID=%d不是当前运行的进程\n", name, pid);
+        return OS_ERR_BAD_STATE;
+    }
+
+    klog("资源 '%s' 暂不能分配%s\n", name,
+           res->available >= count ? "（分配后状态不安全）" : "");
+    res->blocks++;
+    proc->res_wait = r;
+    proc->res_wait_count = count;
+    proc->res_wait_start = time_counter;
+    proc->res_next = NULL;
+    if (res->wait_tail != NULL) res->wait_tail->res_next = proc;
+    else res->wait_head = proc;
+    res->wait_tail = proc;
+    res->waiting++;
+    block_process(pid, WAIT_RESOURCE);
+    deadlock_check(proc);
+    return OS_OK;
+}
+
+OsStatus resource_release(int pid, const char *name, int count) {
+    PCB *proc = lookup_process(pid);
+    int r = find_resource(name);
+    if (proc == NULL || r < 0 || count <= 0 || count > proc->res_alloc[r]) {
+        klog("错误: 进程 PID=%d 未持有资源 '%s' 的 %d 个单位\n", pid, name, count);
+        return proc == NULL || r < 0 ? OS_ERR_NOT_FOUND : OS_ERR_INVALID;
+    }
+    Resource *res = &resources[r];
+    proc->res_alloc[r] -= count;
+    if (proc->res_alloc[r] == 0) holder_remove(res, pid);
+    res->available += count;
+    klog("进程 PID=%d 释放资源 '%s' %d 个单位（剩余 %d）\n", pid, name, count, res->available);
+    resource_grant_waiters();
+    return OS_OK;
+}
+
+// 修改进程声明的最大需求（银行家模式下须保持安全）
+OsStatus resource_claim(int pid, const char *name, int claim) {
+    PCB *proc = lookup_process(pid);
+    int r = find_resource(name);
+    if (proc == NULL || r < 0) {
+        klog("错误: 进程 PID=%d 或资源 '%s' 不存在\n", pid, name);
+        return OS_ERR_NOT_FOUND;
+    }
+    if (claim < proc->res_alloc[r] || claim > resources[r].total) {
+        klog("错误: 最大需求须在已持有量 %d 与总量 %d 之间\n", proc->res_alloc[r], resources[r].total);
+        return OS_ERR_INVALID;
+    }
+    int old = proc->res_claim[r];
+    proc->res_claim[r] = claim;
+    if (banker_enabled && !banker_safe(NULL, NULL)) {
+        proc->res_claim[r] = old;
+        klog("错误: 新的最大需求会使状态不安全\n");
+        return OS_ERR_REJECTED;
+    }
+    klog("进程 PID=%d 对资源 '%s' 的最大需求设为 %d\n", pid, name, claim);
+    return OS_OK;
+}
+
+// 手动唤醒：离开资源等待队列
+void resource_cancel_wait(PCB *proc) {
+    if (proc->res_wait < 0) return;
+    Resource *res = &resources[proc->res_wait];
+    PCB *prev = NULL;
+    for (PCB *p = res->wait_head; p != NULL; prev = p, p = p->res_next) {
+        if (p != proc) continue;
+        if (prev != NULL) prev->res_next = p->res_next;
+        else res->wait_head = p->res_next;
+        if (res->wait_tail == p) res->wait_tail = prev;
+        res->waiting--;
+        break;
+    }
+    proc->res_next = NULL;
+    proc->res_wait = -1;
+    proc->res_wait_count = 0;
+}
+
+// 进程退出：离开等待队列，归还全部资源
+void resource_release_process(PCB *proc) {
+    resource_cancel_wait(proc);
+    bool released = false;
+    for (int r = 0; r < num_resources; r++) {
+        proc->res_claim[r] = 0;  // 退出的进程不再参与安全性检查
+        if (proc->res_alloc[r] == 0) continue;
+        resources[r].available += proc->res_alloc[r];
+        holder_remove(&resources[r], proc->pid);
+        proc->res_alloc[r] = 0;
+        released = true;
+    }
+    if (released) {
+        resource_grant_waiters();
+    }
+}
+
+// 手动运行一次全局死锁检测，返回死锁的进程数
+int deadlock_scan() {
+    bool *deadlocked = (bool*)malloc((pid_table_size + 1) * sizeof(bool));
+    int count = detect_deadlocked(deadlocked);
+    if (count == 0) {
+        klog("未发现死锁\n");
+    } else {
+        klog("死锁进程(%d):", count);
+        for (int pid = 0; pid < pid_table_size; pid++) {
+            if (deadlocked[pid]) klog(" %d", pid);
+        }
+        klog("\n");
+    }
+    free(deadlocked);
+    return count;
+}
+
+// 显示资源状态、分配矩阵与死锁统计
+void display_resources() {
+    klog("\n===== 资源管理 =====\n");
+    klog("银行家算法: %s，安全性检查 %lld 次，拒绝创建 %lld 次\n",
+           banker_enabled ? "开启" : "关闭", banker_checks, banker_rejections);
+    klog("死锁检测: 检查 %lld 次，扫描边 %lld 条（平均 %.1f），发现环 %lld 次，确认死锁 %lld 次\n",
+           deadlock_stats.checks, deadlock_stats.edges_scanned,
+           deadlock_stats.checks > 0 ? (double)deadlock_stats.edges_scanned / deadlock_stats.checks : 0.0,
+           deadlock_stats.cycles, deadlock_stats.deadlocks);
+    if (num_resources == 0) {
+        klog("没有资源\n====================\n\n");
+        return;
+    }
+
+    klog("\n资源\t总量\t可用\t默认声明\t申请\t分配\t阻塞\t不安全拒绝\t平均等待\t等待队列\n");
+    for (int r = 0; r < num_resources; r++) {
+        Resource *res = &resources[r];
+        klog("%s\t%d\t%d\t%d\t\t%lld\t%lld\t%lld\t%lld\t\t%.2f\t\t",
+               res->name, res->total, res->available, res->default_claim, res->requests,
+               res->grants, res->blocks, res->unsafe_denials,
+               res->grants > 0 ? (double)res->total_wait / res->grants : 0.0);
+        for (PCB *p = res->wait_head; p != NULL; p = p->res_next) {
+            klog("%d(%d) ", p->pid, p->res_wait_count);
+        }
+        klog("\n");
+    }
+
+    klog("\nPID\t");
+    for (int r = 0; r < num_resources; r++) klog("%s(持有/声明)\t", resources[r].name);
+    klog("等待\n");
+    for (int pid = 0; pid < pid_table_size; pid++) {
+        PCB *p = pid_table[pid];
+        if (p == NULL) continue;
+        klog("%d\t", pid);
+        for (int r = 0; r < num_resources; r++) klog("%d/%d\t\t", p->res_alloc[r], p->res_claim[r]);
+        if (p->res_wait >= 0) klog("%s x%d", resources[p->res_wait].name, p->res_wait_count);
+        else if (p->sync_wait != NULL) klog("%s", p->sync_wait->name);
+        else klog("-");
+        klog("\n");
+    }
+    klog("====================\n\n");
+}
+
+// ======= 无锁中断注入队列 =======
+
+bool inject_ring_init(InjectRing *ring, int capacity) {
+    memset(ring, 0, sizeof(*ring));
+    ring->slots = (InjectSlot*)malloc(capacity * sizeof(InjectSlot));
+    if (ring->slots == NULL) {
+        return false;
+    }
+    ring->mask = capacity - 1;
+    for (int i = 0; i < capacity; i++) {
+        ring->slots[i].seq = i;
+    }
+    return true;
+}
+
+void inject_ring_free(InjectRing *ring) {
+    free(ring->slots);
+    ring->slots = NULL;
+}
+
+// 生产者入队（任意线程，无锁）：CAS抢占tail位置后写入槽位，再发布序号；队列满则丢弃
+bool inject_ring_push(InjectRing *ring, InterruptType type, int source, int code, int param) {
+    LONG pos = ring->tail;
+    InjectSlot *slot;
+    while (true) {
+        slot = &ring->slots[pos & ring->mask];
+        LONG diff = (LONG)((DWORD)slot->seq - (DWORD)pos);
+        if (diff == 0) {
+            LONG seen = InterlockedCompareExchange(&ring->tail, pos + 1, pos);
+            if (seen == pos) break;
+            pos = seen;
+        } else if (diff < 0) {
+            InterlockedIncrement(&ring->dropped);
+            return false;
+        } else {
+            pos = ring->tail;
+        }
+    }
+
+    slot->irq.type = type;
+    slot->irq.source = source;
+    slot->irq.code = code;
+    slot->irq.param = param;
+    slot->enqueue_ns = now_ns();
+    InterlockedExchange(&slot->seq, pos + 1);
+    return true;
+}
+
+// 消费者出队（仅内核线程）：取出head处已发布的记录并统计入队延迟
+bool inject_ring_pop(InjectRing *ring, Interrupt *out) {
+    InjectSlot *slot = &ring->slots[ring->head & ring->mask];
+    if (slot->seq != ring->head + 1) {   // volatile读：与生产者的InterlockedExchange配对
+        return false;
+    }
+    *out = slot->irq;
+    long long latency = now_ns() - slot->enqueue_ns;
+    InterlockedExchange(&slot->seq, ring->head + ring->mask + 1);
+    ring->head++;
+
+    ring->drained++;
+    ring->total_latency_ns += latency;
+    if (latency > ring->max_latency_ns) {
+        ring->max_latency_ns = latency;
+    }
+    ring->latency_hist[latency_bucket(latency)]++;
+    return true;
+}
+
+// 主机线程注入中断
+bool inject_interrupt(InterruptType type, int source, int code, int param) {
+    return inject_ring_push(&injection_ring, type, source, code, param);
+}
+
+// 在时钟边界取出注入的记录：时钟记录累计待运行时钟数，其余交给中断控制器
+int drain_injected_interrupts() {
+    Interrupt irq;
+    int count = 0;
+    // 主机注入只面向命令行的主内核；参数扫描等其他内核不取用
+    if (kernel != main_kernel) {
+        return 0;
+    }
+    while (inject_ring_pop(&injection_ring, &irq)) {
+        count++;
+        if (irq.type == TIMER_INTERRUPT && irq.code == INJECT_CLOCK_TICK) {
+            host_clock_ticks += irq.param;
+        } else if (irq.type == IO_INTERRUPT && irq.source >= 0 && irq.source < NUM_DEVICES) {
+            raise_interrupt(IO_INTERRUPT, irq.source, irq.code, irq.param);
+        } else if (irq.type == SYSTEM_CALL) {
+            raise_interrupt(SYSTEM_CALL, irq.source, irq.code, irq.param);
+        }
+    }
+    return count;
+}
+
+// 内核主循环的一步（持有kernel_lock调用）：取出注入记录并运行积累的时钟
+void kernel_poll() {
+    drain_injected_interrupts();
+    int ticks = host_clock_ticks;
+    host_clock_ticks = 0;
+    if (ticks > 0) {
+        run_simulation(ticks);
+    }
+}
+
+// 压力测试的生产者线程参数
+typedef struct {
+    InjectRing *ring;
+    int id;
+    int events;
+    volatile LONG *start;
+    long long pushed;
+    long long dropped;
+} InjectProducer;
+
+static unsigned __stdcall inject_producer_func(void *arg) {
+    InjectProducer *producer = (InjectProducer*)arg;
+    while (*producer->start == 0) {
+        YieldProcessor();
+    }
+    for (int i = 0; i < producer->events; i++) {
+        if (inject_ring_push(producer->ring, IO_INTERRUPT, producer->id, 0, i)) {
+            producer->pushed++;
+        } else {
+            producer->dropped++;
+        }
+    }
+    return 0;
+}
+
+// 注入队列压力测试：多个生产者线程并发注入，当前线程作为唯一消费者，
+// 校验无丢失、无重复且每个生产者内部保持FIFO
+OsStatus injection_benchmark(int producers, int events) {
+    InjectRing ring;
+    if (!inject_ring_init(&ring, INJECT_RING_SIZE)) {
+        klog("错误: 无法分配注入队列\n");
+        return OS_ERR_NO_MEMORY;
+    }
+    InjectProducer *args = (InjectProducer*)calloc(producers, sizeof(InjectProducer));
+    HANDLE *threads = (HANDLE*)calloc(producers, sizeof(HANDLE));
+    int *last_seen = (int*)malloc(producers * sizeof(int));
+    volatile LONG start = 0;
+
+    now_ns();   // 初始化计时频率，避免生产者线程并发初始化
+    int started = 0;
+    for (int i = 0; i < producers; i++) {
+        args[i].ring = &ring;
+        args[i].id = i;
+        args[i].events = events;
+        args[i].start = &start;
+        last_seen[i] = -1;
+        threads[i] = (HANDLE)_beginthreadex(NULL, 0, inject_producer_func, &args[i], 0, NULL);
+        if (threads[i] == NULL) {
+            klog("启动生产者线程失败\n");
+            break;
+        }
+        started++;
+    }
+
+    long long received = 0;
+    long long order_errors = 0;
+    long long begin = now_ns();
+    InterlockedExchange(&start, 1);
+
+    // 消费直到所有生产者结束且队列为空
+    Interrupt irq;
+    int finished = 0;
+    while (true) {
+        bool got = false;
+        while (inject_ring_pop(&ring, &irq)) {
+            got = true;
+            received++;
+            if (irq.source < 0 || irq.source >= started || irq.param <= last_seen[irq.source]) {
+                order_errors++;
+            } else {
+                last_seen[irq.source] = irq.param;
+            }
+        }
+        if (finished == started) {
+            break;  // 生产者全部结束后又完整清空了一次队列
+        }
+        if (!got) {
+            while (finished < started && WaitForSingleObject(threads[finished], 0) == WAIT_OBJECT_0) {
+                finished++;
+            }
+        }
+    }
+    long long elapsed = now_ns() - begin;
+
+    long long pushed = 0, dropped = 0;
+    for (int i = 0; i < started; i++) {
+        CloseHandle(threads[i]);
+        pushed += args[i].pushed;
+        dropped += args[i].dropped;
+    }
+
+    klog("\n===== 注入队列压力测试 =====\n");
+    klog("生产者: %d, 每个生产者 %d 条, 队列容量 %d\n", started, events, INJECT_RING_SIZE);
+    klog("入队成功: %lld, 丢弃(队列满): %lld, 取出: %lld\n", pushed, dropped, received);
+    klog("耗时 %.3f ms, 注入 %.2f 百万条/秒, 送达 %.2f 百万条/秒\n", elapsed / 1e6,
+           elapsed > 0 ? (pushed + dropped) * 1e3 / elapsed : 0.0,
+           elapsed > 0 ? received * 1e3 / elapsed : 0.0);
+    klog("入队延迟: 平均 %.0f ns, 最大 %lld ns\n",
+           received > 0 ? (double)ring.total_latency_ns / received : 0.0, ring.max_latency_ns);
+    print_histogram("入队延迟", ring.latency_hist, "ns");
+    klog("校验: %s（丢失 %lld，乱序/重复 %lld）\n",
+           (received == pushed && order_errors == 0) ? "通过" : "失败",
+           pushed - received, order_errors);
+    klog("===========================\n\n");
+
+    free(last_seen);
+    free(threads);
+    free(args);
+    inject_ring_free(&ring);
+    return OS_OK;
+}
+
+// 运行进程的量子/预算/生命期到期时的时钟中断处理
+void handle_timer_interrupt() {
+    if (running_process == NULL) {
+        return;
+    }
+
+    // 如果时间片用完，进程结束
+    if (running_process->time_slice <= 0) {
+        KLOG("进程 %s (PID=%d) 已完成运行，自动终止\n",
+               running_process->name, running_process->pid);
+        int turnaround = time_counter - running_process->arrival_time;
+        processes_finished++;
+        turnaround_total += turnaround;
+        if (turnaround > turnaround_max) {
+            turnaround_max = turnaround;
+        }
+
+        // 先释放内存等资源，避免调度新进程时复用
+        release_process(running_process);
+        running_process = NULL;
+
+        // 再调度新进程
+        schedule_process();
+    } else if (is_rt(running_process) && running_process->rt_budget <= 0) {
+        // 实时作业用完本周期预算
+        PCB *proc = running_process;
+        running_process = NULL;
+        edf_complete_job(proc);
+        schedule_process();
+    } else {
+        // 量子用完：由调度器降级/放回就绪队列
+        schedule_process();
+    }
+}
+
+// 事件堆比较：时间早者优先，同时刻按加入顺序
+static bool event_before(const SimEvent *a, const SimEvent *b) {
+    if (a->time != b->time) {
+        return a->time < b->time;
+    }
+    return a->seq < b->seq;
+}
+
+// 加入未来事件 O(log n)
+void schedule_event(int time, EventType type, int pid, int arg, const char *command) {
+    if (event_count == event_capacity) {
+        event_capacity = event_capacity ? event_capacity * 2 : 16;
+        event_queue = (SimEvent*)realloc(event_queue, event_capacity * sizeof(SimEvent));
+    }
+
+    SimEvent ev;
+    ev.time = time;
+    ev.type = type;
+    ev.pid = pid;
+    ev.arg = arg;
+    ev.command = (command != NULL) ? strdup(command) : NULL;
+    ev.seq = event_seq++;
+
+    // 上浮
+    int i = event_count++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!event_before(&ev, &event_queue[parent])) break;
+        event_queue[i] = event_queue[parent];
+        i = parent;
+    }
+    event_queue[i] = ev;
+}
+
+// 取出最早的事件 O(log n)
+SimEvent pop_event() {
+    SimEvent top = event_queue[0];
+    SimEvent last = event_queue[--event_count];
+
+    // 下沉
+    int i = 0;
+    while (true) {
+        int child = 2 * i + 1;
+        if (child >= event_count) break;
+        if (child + 1 < event_count && event_before(&event_queue[child + 1], &event_queue[child])) {
+            child++;
+        }
+        if (!event_before(&event_queue[child], &last)) break;
+        event_queue[i] = event_queue[child];
+        i = child;
+    }
+    if (event_count > 0) {
+        event_queue[i] = last;
+    }
+    return top;
+}
+
+// 运行进程下一次需要时钟中断的时间：生命期结束、实时预算用完或量子用完
+int running_expiry_time() {
+    if (running_process == NULL) {
+        return INT_MAX;
+    }
+
+    int remaining = running_process->time_slice;
+    if (is_rt(running_process)) {
+        if (running_process->rt_budget < remaining) remaining = running_process->rt_budget;
+    } else if (current_algorithm == RR || current_algorithm == MLFQ || current_algorithm == CFS) {
+        if (running_process->quantum_left < remaining) remaining = running_process->quantum_left;
+    }
+    return time_counter + remaining;
+}
+
+// 下一个事件的时间：事件堆、实时作业释放、MLFQ周期提升、运行进程到期中最早者
+int next_event_time() {
+    // 时钟中断被屏蔽或已在等待处理时，不再以运行进程到期作为事件
+    int next = INT_MAX;
+    if (!timer_interrupt_pending && (interrupt_mask & (1u << TIMER_INTERRUPT)) == 0) {
+        next = running_expiry_time();
+    }
+    if (event_count > 0 && event_queue[0].time < next) {
+        next = event_queue[0].time;
+    }
+    if (edf_release_heap.size > 0 && edf_release_heap.items[0]->rt_next_release < next) {
+        next = edf_release_heap.items[0]->rt_next_release;
+    }
+    if (current_algorithm == MLFQ && mlfq_last_boost + MLFQ_BOOST_INTERVAL < next) {
+        next = mlfq_last_boost + MLFQ_BOOST_INTERVAL;
+    }
+    if (compaction_active && time_counter + 1 < next) {
+        next = time_counter + 1;    // 紧缩进行中时逐时钟推进
+    }
+    if (defrag_active && time_counter + 1 < next) {
+        next = time_counter + 1;    // 整理进行中时逐时钟推进
+    }
+    return next;
+}
+
+// 将一段时间记到运行进程上
+void charge_running_process(int delta) {
+    if (running_process == NULL || delta <= 0) {
+        return;
+    }
+
+    running_process->time_slice -= delta;
+    running_process->burst_time += delta;
+    if (running_process->page_table != NULL) {
+        vm_run_references(running_process, delta);
+    }
+    if (is_rt(running_process)) {
+        running_process->rt_budget -= delta;
+    } else if (current_algorithm == RR || current_algorithm == MLFQ) {
+        running_process->quantum_left -= delta;
+    } else if (current_algorithm == CFS) {
+        // vruntime按权重反比增长：权重越大（优先级越高）增长越慢
+        running_process->vruntime += (long long)delta * CFS_NICE_0_LOAD * CFS_VRUNTIME_SCALE /
+                                     cfs_weight(running_process);
+        running_process->quantum_left -= delta;
+        cfs_update_min_vruntime();
+    }
+}
+
+// 是否有就绪的进程
+bool has_ready_process() {
+    return ready_queue != NULL || mlfq_bitmap != 0 || sjf_heap.size > 0 ||
+           cfs_leftmost != NULL || edf_heap.size > 0;
+}
+
+// 处理当前时刻到期的全部事件
+void process_due_events() {
+    // 运行进程到期：产生时钟中断
+    if (running_process != NULL && running_expiry_time() <= time_counter) {
+        raise_interrupt(TIMER_INTERRUPT, 0, 0, 0);
+    }
+
+    // 增量内存紧缩与磁盘整理：advance_clock每次调用都会处理起始时钟，同一时钟只执行一次
+    if (incremental_tick != time_counter) {
+        incremental_tick = time_counter;
+        compaction_tick();
+        defrag_tick();
+    }
+
+    // 多级反馈队列周期性提升
+    if (current_algorithm == MLFQ && time_counter - mlfq_last_boost >= MLFQ_BOOST_INTERVAL) {
+        mlfq_boost();
+    }
+
+    // 释放到达新周期的实时作业
+    edf_release_jobs();
+
+    // 事件堆中到期的事件
+    while (event_count > 0 && event_queue[0].time <= time_counter) {
+        SimEvent ev = pop_event();
+        events_processed++;
+        switch (ev.type) {
+            case EVENT_IO_COMPLETE:
+                raise_interrupt(IO_INTERRUPT, ev.arg, 0, 0);
+                break;
+            case EVENT_ARRIVAL:
+                klog("[时间 %d] 到达事件: %s\n", time_counter, ev.command);
+                if (command_handler != NULL) {
+                    command_handler(ev.command);
+                }
+                break;
+        }
+        free(ev.command);
+    }
+
+    // 新就绪的进程可能抢占运行进程，CPU空闲则调度
+    if (running_process != NULL ||
+        has_ready_process() || (system_interrupt_flag && interrupted_process != NULL)) {
+        schedule_process();
+    }
+}
+
+// 事件驱动地推进时钟到target：时钟直接跳到下一个事件，空闲和长量子不逐时钟处理
+void advance_clock(int target) {
+    while (true) {
+        drain_injected_interrupts();
+        process_due_events();
+        if (time_counter >= target) {
+            break;
+        }
+
+        int next = next_event_time();
+        if (next > target) next = target;
+        if (next <= time_counter) next = time_counter + 1;
+
+        int delta = next - time_counter;
+        if (delta > 1) {
+            clock_jumps++;
+        }
+        if (running_process == NULL) {
+            idle_ticks += delta;
+        }
+        charge_running_process(delta);
+        time_counter = next;
+        TRACE(TRACE_TIMER, running_process != NULL ? running_process->pid : -1, delta, 0);
+        metrics_tick();
+
+        if (running_process != NULL) {
+            KLOG("时钟中断: 进程 %s (PID=%d) 剩余时间片 %d\n",
+                   running_process->name,
+                   running_process->pid,
+                   running_process->time_slice);
+        }
+    }
+}
+
+// 运行模拟ticks个时钟
+void run_simulation(int ticks) {
+    if (ticks <= 1) {
+        klog("\n===== 运行系统 (时间片 %d) =====\n", time_counter + 1);
+    } else {
+        klog("\n===== 运行系统 (时间片 %d-%d) =====\n", time_counter + 1, time_counter + ticks);
+    }
+    
+    if (system_interrupt_flag && interrupted_process != NULL) {
+        klog("注意：系统处于中断状态，进程 %s (PID=%d) 被挂起\n", 
+               interrupted_process->name, interrupted_process->pid);
+    }
+    
+    long long events_before = events_processed;
+    long long jumps_before = clock_jumps;
+    advance_clock(time_counter + (ticks > 0 ? ticks : 1));
+    if (ticks > 1) {
+        klog("本次处理事件 %lld 个，时钟跳跃 %lld 次\n",
+               events_processed - events_before, clock_jumps - jumps_before);
+    }
+    
+    klog("=========================\n\n");
+}
+
+// ======= 二进制事件跟踪 =======
+
+// 当前线程的跟踪环：首次使用时登记，超过TRACE_MAX_THREADS的线程不记录
+static TraceRing* trace_thread_ring() {
+    static thread_local TraceRing *ring = NULL;
+    static thread_local bool registered = false;
+    if (!registered) {
+        registered = true;
+        LONG index = InterlockedIncrement(&trace_thread_count) - 1;
+        if (index < TRACE_MAX_THREADS) {
+            ring = &trace_rings[index];
+            ring->cpu = (int)index;
+        }
+    }
+    return ring;
+}
+
+// 写入一条定长记录：只由本线程推进head，无锁
+void trace_emit(int type, int pid, int arg0, int arg1) {
+    if (kernel != main_kernel) {
+        return;     // 只记录命令行的主内核，参数扫描的工作内核不记录
+    }
+    TraceRing *ring = trace_thread_ring();
+    if (ring == NULL || ring->records == NULL) {
+        InterlockedIncrement(&trace_unregistered_drops);
+        return;
+    }
+    LONG head = ring->head;
+    if ((DWORD)(head - ring->tail) >= TRACE_RING_SIZE) {
+        ring->dropped++;  // 刷写跟不上时丢弃最新记录，不阻塞内核
+        return;
+    }
+    TraceRecord *rec = &ring->records[head & (TRACE_RING_SIZE - 1)];
+    rec->type = (unsigned short)type;
+    rec->cpu = (unsigned short)ring->cpu;
+    rec->tick = time_counter;
+    rec->pid = pid;
+    rec->arg0 = arg0;
+    rec->arg1 = arg1;
+    rec->reserved = 0;
+    rec->ns = now_ns();
+    MemoryBarrier();      // 记录内容先于head可见
+    ring->head = head + 1;
+}
+
+// 把各线程环中已发布的记录写入文件（只由刷写线程或停止跟踪时调用）
+static long long trace_drain() {
+    long long written = 0;
+    LONG count = trace_thread_count < TRACE_MAX_THREADS ? trace_thread_count : TRACE_MAX_THREADS;
+    for (int i = 0; i < count; i++) {
+        TraceRing *ring = &trace_rings[i];
+        if (ring->records == NULL) continue;
+        LONG head = ring->head;
+        MemoryBarrier();
+        LONG tail = ring->tail;
+        while (tail != head) {
+            int start = tail & (TRACE_RING_SIZE - 1);
+            int n = (int)(head - tail);
+            if (start + n > TRACE_RING_SIZE) n = TRACE_RING_SIZE - start;
+            fwrite(&ring->records[start], sizeof(TraceRecord), n, trace_file);
+            tail += n;
+            written += n;
+        }
+        MemoryBarrier();  // 读完记录后才释放槽位
+        ring->tail = tail;
+    }
+    trace_records_written += written;
+    return written;
+}
+
+// 异步刷写线程
+static unsigned __stdcall trace_flush_func(void*) {
+    while (trace_active) {
+        trace_drain();
+        Sleep(TRACE_FLUSH_MS);
+    }
+    return 0;
+}
+
+OsStatus trace_start(const char *path) {
+    if (trace_active) {
+        klog("跟踪已在进行，写入 %s\n", trace_path);
+        return OS_ERR_BAD_STATE;
+    }
+    trace_file = fopen(path, "wb");
+    if (trace_file == NULL) {
+        klog("无法创建跟踪文件 %s\n", path);
+        return OS_ERR_IO;
+    }
+    TraceFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.record_size = sizeof(TraceRecord);
+    header.start_ns = now_ns();
+    fwrite(&header, sizeof(header), 1, trace_file);
+
+    // 环缓冲区首次开启跟踪时分配；丢弃上次停止后残留的记录
+    for (int i = 0; i < TRACE_MAX_THREADS; i++) {
+        TraceRing *ring = &trace_rings[i];
+        if (ring->records == NULL) {
+            ring->records = (TraceRecord*)malloc(TRACE_RING_SIZE * sizeof(TraceRecord));
+        }
+        ring->tail = ring->head;
+        ring->dropped = 0;
+    }
+    trace_unregistered_drops = 0;
+    trace_records_written = 0;
+    strncpy(trace_path, path, sizeof(trace_path) - 1);
+    trace_path[sizeof(trace_path) - 1] = '\0';
+
+    trace_active = 1;
+    trace_thread = (HANDLE)_beginthreadex(NULL, 0, trace_flush_func, NULL, 0, NULL);
+    if (trace_thread == NULL) {
+        trace_active = 0;
+        fclose(trace_file);
+        trace_file = NULL;
+        klog("启动跟踪刷写线程失败\n");
+        return OS_ERR_NO_MEMORY;
+    }
+    klog("跟踪已开启，写入 %s（记录 %d 字节）\n", path, (int)sizeof(TraceRecord));
+    return OS_OK;
+}
+
+OsStatus trace_stop() {
+    if (!trace_active) {
+        klog("跟踪未开启\n");
+        return OS_ERR_BAD_STATE;
+    }
+    trace_active = 0;
+    WaitForSingleObject(trace_thread, INFINITE);
+    CloseHandle(trace_thread);
+    trace_thread = NULL;
+    trace_drain();
+    fclose(trace_file);
+    trace_file = NULL;
+
+    long long dropped = trace_unregistered_drops;
+    for (int i = 0; i < TRACE_MAX_THREADS; i++) dropped += trace_rings[i].dropped;
+    klog("跟踪已停止: %s 写入 %lld 条记录，丢弃 %lld 条\n", trace_path, trace_records_written, dropped);
+    return OS_OK;
+}
+
+void display_trace_status() {
+    klog("跟踪: %s", trace_active ? "开启" : "关闭");
+    if (trace_active) {
+        klog("，文件 %s，已写入 %lld 条", trace_path, trace_records_written);
+    }
+    klog("；内核文本日志: %s\n", kernel_text_log ? "开启" : "关闭");
+    LONG count = trace_thread_count < TRACE_MAX_THREADS ? trace_thread_count : TRACE_MAX_THREADS;
+    for (int i = 0; i < count; i++) {
+        TraceRing *ring = &trace_rings[i];
+        klog("  线程%d: 待刷写 %ld，丢弃 %ld\n", i, (long)(ring->head - ring->tail), (long)ring->dropped);
+    }
+}
+
+static int trace_record_compare(const void *a, const void *b) {
+    long long x = ((const TraceRecord*)a)->ns, y = ((const TraceRecord*)b)->ns;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// 导出为Chrome trace JSON（chrome://tracing、Perfetto可直接打开）：
+// 进程占用CPU显示为时间片段，其余事件显示为瞬时事件
+OsStatus trace_export(const char *bin_path, const char *json_path) {
+    FILE *in = fopen(bin_path, "rb");
+    if (in == NULL) {
+        klog("无法打开跟踪文件 %s\n", bin_path);
+        return OS_ERR_IO;
+    }
+    TraceFileHeader header;
+    if (fread(&header, sizeof(header), 1, in) != 1 ||
+        memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != TRACE_VERSION || header.record_size != (int)sizeof(TraceRecord)) {
+        klog("%s 不是本程序的跟踪文件或版本不符\n", bin_path);
+        fclose(in);
+        return OS_ERR_INVALID;
+    }
+
+    int capacity = 1024, count = 0;
+    TraceRecord *records = (TraceRecord*)malloc(capacity * sizeof(TraceRecord));
+    while (fread(&records[count], sizeof(TraceRecord), 1, in) == 1) {
+        if (++count == capacity) {
+            capacity *= 2;
+            records = (TraceRecord*)realloc(records, capacity * sizeof(TraceRecord));
+        }
+    }
+    fclose(in);
+    // 各线程环分别刷写，按时间戳合并
+    qsort(records, count, sizeof(TraceRecord), trace_record_compare);
+
+    FILE *out = fopen(json_path, "w");
+    if (out == NULL) {
+        klog("无法创建 %s\n", json_path);
+        free(records);
+        return OS_ERR_IO;
+    }
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"OS模拟内核\"}}");
+    fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"CPU\"}}");
+
+    int running = -1;
+    double running_since = 0;
+    for (int i = 0; i < count; i++) {
+        TraceRecord *rec = &records[i];
+        double ts = (rec->ns - header.start_ns) / 1000.0;  // 微秒
+        const char *name = rec->type < NUM_TRACE_EVENTS ? trace_event_names[rec->type] : "unknown";
+
+        // CPU占用片段：切换、阻塞、退出、让出CPU时结束当前进程的片段
+        bool ends_slice = rec->type == TRACE_SWITCH || rec->type == TRACE_IDLE ||
+                          ((rec->type == TRACE_BLOCK || rec->type == TRACE_EXIT ||
+                            rec->type == TRACE_PREEMPT) && rec->pid == running);
+        if (ends_slice && running != -1) {
+            fprintf(out, ",\n{\"name\":\"PID %d\",\"ph\":\"X\",\"pid\":0,\"tid\":0,"
+                         "\"ts\":%.3f,\"dur\":%.3f}", running, running_since, ts - running_since);
+            running = -1;
+        }
+        if (rec->type == TRACE_SWITCH) {
+            running = rec->pid;
+            running_since = ts;
+        }
+
+        fprintf(out, ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,"
+                     "\"args\":{\"tick\":%d,\"pid\":%d,\"arg0\":%d,\"arg1\":%d}}",
+                name, rec->cpu + 1, ts, rec->tick, rec->pid, rec->arg0, rec->arg1);
+    }
+    if (running != -1 && count > 0) {
+        double end = (records[count - 1].ns - header.start_ns) / 1000.0;
+        fprintf(out, ",\n{\"name\":\"PID %d\",\"ph\":\"X\",\"pid\":0,\"tid\":0,"
+                     "\"ts\":%.3f,\"dur\":%.3f}", running, running_since, end - running_since);
+    }
+    fprintf(out, "\n]}\n");
+    fclose(out);
+    free(records);
+    klog("已导出 %d 条记录到 %s\n", count, json_path);
+    return OS_OK;
+}
+
+// ======= 指标注册表 =======
+
+// 对数-线性分桶：每个2的幂区间再分HIST_SUB_BUCKETS个子桶，相对误差不超过1/HIST_SUB_BUCKETS
+static int hist_index(long long value) {
+    if (value < HIST_SUB_BUCKETS) {
+        return value < 0 ? 0 : (int)value;
+    }
+    int shift = std::bit_width((unsigned long long)value) - 1 - HIST_SUB_BITS;
+    return ((shift + 1) << HIST_SUB_BITS) + (int)((value >> shift) & (HIST_SUB_BUCKETS - 1));
+}
+
+// 桶的下界
+static long long hist_bucket_low(int index) {
+    if (index < HIST_SUB_BUCKETS) {
+        return index;
+    }
+    int shift = (index >> HIST_SUB_BITS) - 1;
+    return (long long)(HIST_SUB_BUCKETS | (index & (HIST_SUB_BUCKETS - 1))) << shift;
+}
+
+void hist_record(Histogram *hist, long long value) {
+    hist->counts[hist_index(value)]++;
+    if (hist->count == 0 || value < hist->min) hist->min = value;
+    if (value > hist->max) hist->max = value;
+    hist->count++;
+    hist->sum += value;
+}
+
+// 第p百分位的近似值（所在桶的下界）
+long long hist_percentile(const Histogram *hist, double p) {
+    if (hist->count == 0) return 0;
+    long long rank = (long long)(p / 100.0 * hist->count);
+    if (rank >= hist->count) rank = hist->count - 1;
+    long long seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += hist->counts[i];
+        if (seen > rank) {
+            long long low = hist_bucket_low(i);
+            return low < hist->min ? hist->min : low;
+        }
+    }
+    return hist->max;
+}
+
+static void metric_add(const char *name, const char *help, MetricType type,
+                       const long long *value, long long (*read)(), Histogram *hist) {
+    if (num_metrics == MAX_METRICS) return;
+    Metric *m = &metrics[num_metrics++];
+    m->name = name;
+    m->help = help;
+    m->type = type;
+    m->value = value;
+    m->read = read;
+    m->hist = hist;
+}
+
+static long long metric_blocked_depth() { return blocked_count; }
+static long long metric_disk_free() { return disk_free_blocks; }
+static long long metric_time() { return time_counter; }
+
+static long long metric_free_blocks() { return mem_free_space.regions; }
+static long long metric_largest_free() { return mem_free_space.largest; }
+static long long metric_mem_frag() { return fragmentation_permille(&mem_free_space); }
+static long long metric_disk_runs() { return disk_free_space.regions; }
+static long long metric_disk_largest_run() { return disk_free_space.largest; }
+static long long metric_disk_frag() { return fragmentation_permille(&disk_free_space); }
+static long long metric_fragmented_files() { return file_frag.fragmented; }
+
+void init_metrics() {
+    metric_add("os_time_ticks", "当前模拟时间", METRIC_GAUGE, NULL, metric_time, NULL);
+    metric_add("os_ready_queue_depth", "就绪进程数（含各级队列、堆和红黑树）", METRIC_GAUGE,
+               NULL, metric_ready_depth, NULL);
+    metric_add("os_blocked_queue_depth", "阻塞队列中的进程数", METRIC_GAUGE, NULL, metric_blocked_depth, NULL);
+    metric_add("os_context_switches_total", "进程上CPU次数", METRIC_COUNTER, &metric_context_switches, NULL, NULL);
+    metric_add("os_mem_alloc_success_total", "allocate_memory成功次数", METRIC_COUNTER,
+               &metric_alloc_success, NULL, NULL);
+    metric_add("os_mem_alloc_failure_total", "allocate_memory失败次数", METRIC_COUNTER,
+               &metric_alloc_failure, NULL, NULL);
+    metric_add("os_mem_alloc_search_length", "allocate_memory每次扫描的内存块数", METRIC_HISTOGRAM,
+               NULL, NULL, &metric_alloc_search);
+    metric_add("os_mem_free_blocks", "空闲内存块数", METRIC_GAUGE, NULL, metric_free_blocks, NULL);
+    metric_add("os_mem_largest_free_block", "最大空闲内存块大小", METRIC_GAUGE, NULL, metric_largest_free, NULL);
+    metric_add("os_mem_external_fragmentation_permille", "内存外部碎片指数（千分比）",
+               METRIC_GAUGE, NULL, metric_mem_frag, NULL);
+    metric_add("os_disk_free_blocks", "空闲磁盘块数", METRIC_GAUGE, NULL, metric_disk_free, NULL);
+    metric_add("os_disk_free_runs", "空闲磁盘段数", METRIC_GAUGE, NULL, metric_disk_runs, NULL);
+    metric_add("os_disk_largest_free_run", "最大连续空闲磁盘段（块）", METRIC_GAUGE, NULL, metric_disk_largest_run, NULL);
+    metric_add("os_disk_external_fragmentation_permille", "磁盘外部碎片指数（千分比）",
+               METRIC_GAUGE, NULL, metric_disk_frag, NULL);
+    metric_add("os_fragmented_files", "块链不连续的文件数", METRIC_GAUGE, NULL, metric_fragmented_files, NULL);
+    metric_add("os_defrag_blocks_moved_total", "磁盘整理迁移的块数", METRIC_COUNTER,
+               &defrag_stats.blocks_moved, NULL, NULL);
+    metric_add("os_find_file_probes", "find_file每次比较的目录项数", METRIC_HISTOGRAM,
+               NULL, NULL, &metric_find_probes);
+}
+
+static CommandMetric* command_metric(const char *name) {
+    for (CommandMetric *cm = command_metrics; cm != NULL; cm = cm->next) {
+        if (strcmp(cm->name, name) == 0) return cm;
+    }
+    CommandMetric *cm = (CommandMetric*)calloc(1, sizeof(CommandMetric));
+    strncpy(cm->name, name, sizeof(cm->name) - 1);
+    cm->next = command_metrics;
+    command_metrics = cm;
+    return cm;
+}
+
+// 记录一条命令的处理耗时（按命令名分别统计）
+void metrics_record_command(const char *command, long long ns) {
+    char name[20] = "";
+    sscanf(command, "%19s", name);
+    if (name[0] == '\0') return;
+    hist_record(&command_metric(name)->latency, ns);
+}
+
+static long long metric_read(const Metric *m) {
+    return m->read != NULL ? m->read() : *m->value;
+}
+
+// Prometheus直方图：按2的幂的边界输出累计桶
+static void write_prom_histogram(FILE *out, const char *name, const char *labels, const Histogram *hist) {
+    long long cumulative = 0;
+    int i = 0;
+    for (long long le = 1; hist->count > 0 && le / 2 <= hist->max; le *= 2) {
+        while (i < HIST_BUCKETS && hist_bucket_low(i) < le) {
+            cumulative += hist->counts[i++];
+        }
+        fprintf(out, "%s_bucket{%s%sle=\"%lld\"} %lld\n", name, labels, labels[0] ? "," : "", le - 1, cumulative);
+    }
+    fprintf(out, "%s_bucket{%s%sle=\"+Inf\"} %lld\n", name, labels, labels[0] ? "," : "", hist->count);
+    fprintf(out, "%s_sum%s%s%s %lld\n", name, labels[0] ? "{" : "", labels, labels[0] ? "}" : "", hist->sum);
+    fprintf(out, "%s_count%s%s%s %lld\n", name, labels[0] ? "{" : "", labels, labels[0] ? "}" : "", hist->count);
+}
+
+// 以Prometheus文本格式输出全部指标
+void metrics_write_prometheus(FILE *out) {
+    const char *type_names[] = {"counter", "gauge", "histogram"};
+    for (int i = 0; i < num_metrics; i++) {
+        Metric *m = &metrics[i];
+        fprintf(out, "# HELP %s %s\n# TYPE %s %s\n", m->name, m->help, m->name, type_names[m->type]);
+        if (m->type == METRIC_HISTOGRAM) {
+            write_prom_histogram(out, m->name, "", m->hist);
+        } else {
+            fprintf(out, "%s %lld\n", m->name, metric_read(m));
+        }
+    }
+    fprintf(out, "# HELP os_command_latency_ns 命令处理耗时（纳秒）\n# TYPE os_command_latency_ns histogram\n");
+    for (CommandMetric *cm = command_metrics; cm != NULL; cm = cm->next) {
+        char labels[48];
+        snprintf(labels, sizeof(labels), "command=\"%s\"", cm->name);
+        write_prom_histogram(out, "os_command_latency_ns", labels, &cm->latency);
+    }
+}
+
+// 写入指标文件：先写临时文件再替换，读取方不会看到写了一半的文件
+bool metrics_dump(const char *path) {
+    char tmp_path[FILE_MAX_PATH + 8];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *out = fopen(tmp_path, "w");
+    if (out == NULL) {
+        klog("无法写入指标文件 %s\n", tmp_path);
+        return false;
+    }
+    metrics_write_prometheus(out);
+    fclose(out);
+    remove(path);
+    if (rename(tmp_path, path) != 0) {
+        klog("无法替换指标文件 %s\n", path);
+        return false;
+    }
+    metrics_dumps++;
+    return true;
+}
+
+// 时钟推进时检查是否到了周期性导出的时间
+void metrics_tick() {
+    if (metrics_dump_interval > 0 && time_counter >= metrics_next_dump) {
+        metrics_dump(metrics_dump_path);
+        metrics_next_dump = time_counter + metrics_dump_interval;
+    }
+}
+
+static void print_hist_summary(const char *name, const Histogram *hist) {
+    klog("%-28s\t%lld\t%.1f\t%lld\t%lld\t%lld\t%lld\n", name, hist->count,
+           hist->count > 0 ? (double)hist->sum / hist->count : 0.0,
+           hist_percentile(hist, 50), hist_percentile(hist, 90), hist_percentile(hist, 99), hist->max);
+}
+
+void display_metrics() {
+    klog("\n===== 指标 =====\n");
+    for (int i = 0; i < num_metrics; i++) {
+        if (metrics[i].type != METRIC_HISTOGRAM) {
+            klog("%-28s\t%lld\n", metrics[i].name, metric_read(&metrics[i]));
+        }
+    }
+    klog("\n直方图\t\t\t\t次数\t平均\tp50\tp90\tp99\t最大\n");
+    for (int i = 0; i < num_metrics; i++) {
+        if (metrics[i].type == METRIC_HISTOGRAM) {
+            print_hist_summary(metrics[i].name, metrics[i].hist);
+        }
+    }
+    klog("\n命令耗时(ns)\t\t\t次数\t平均\tp50\tp90\tp99\t最大\n");
+    for (CommandMetric *cm = command_metrics; cm != NULL; cm = cm->next) {
+        print_hist_summary(cm->name, &cm->latency);
+    }
+    if (metrics_dump_interval > 0) {
+        klog("\n每 %d 个时钟导出到 %s，已导出 %lld 次\n",
+               metrics_dump_interval, metrics_dump_path, metrics_dumps);
+    }
+    klog("================\n\n");
+}
+
+// ======= 状态快照 =======
+
+// 释放进程/内存块/文件控制块/I/O请求：来自快照整块的对象只减少计数
+void node_free(void *node) {
+    SnapshotArena **link = &snapshot_arenas;
+    for (SnapshotArena *arena = snapshot_arenas; arena != NULL; link = &arena->next, arena = arena->next) {
+        if ((char*)node >= arena->base && (char*)node < arena->base + arena->size) {
+            if (--arena->live == 0) {
+                *link = arena->next;
+                free(arena->base);
+                free(arena);
+            }
+            return;
+        }
+    }
+    free(node);
+}
+
+// 快照不覆盖的子系统在使用中时拒绝保存/装载
+static bool snapshot_supported(const char *action) {
+    const char *reason = NULL;
+    if (memory_mode != MEM_CONTIGUOUS) {
+        reason = "分页模式";
+    } else if (shm_segments != NULL) {
+        reason = "共享内存段";
+    } else if (sync_objects != NULL) {
+        reason = "同步对象";
+    } else if (num_resources > 0) {
+        reason = "资源类型";
+    } else if (pending_count > 0) {
+        reason = "被屏蔽的待处理中断";
+    } else if (compaction_active || pending_creates != NULL) {
+        reason = "进行中的内存紧缩";
+    } else if (defrag_active) {
+        reason = "进行中的磁盘整理";
+    }
+    if (reason != NULL) {
+        klog("错误: 快照不支持%s，无法%s\n", reason, action);
+        return false;
+    }
+    return true;
+}
+
+static void snapshot_push(PCB **procs, int *locs, int capacity, int *count, PCB *proc, int loc) {
+    if (*count < capacity) {
+        procs[*count] = proc;
+        locs[*count] = loc;
+    }
+    (*count)++;
+}
+
+static int snapshot_count_files(FCB *file) {
+    int count = 1;
+    for (FCB *child = file->child; child != NULL; child = child->sibling) {
+        count += snapshot_count_files(child);
+    }
+    return count;
+}
+
+// 先序记录目录树
+static void snapshot_put_files(FCB *file, int parent, SnapshotFile *out, int *count, int *cwd) {
+    int index = (*count)++;
+    SnapshotFile *rec = &out[index];
+    memset(rec, 0, sizeof(*rec));
+    strncpy(rec->name, file->name, MAX_FILENAME - 1);
+    rec->type = file->type;
+    rec->ino = file->ino;
+    rec->parent = parent;
+    if (file == current_directory) {
+        *cwd = index;
+    }
+    for (FCB *child = file->child; child != NULL; child = child->sibling) {
+        snapshot_put_files(child, index, out, count, cwd);
+    }
+}
+
+OsStatus snapshot_save(const char *path) {
+    if (!snapshot_supported("保存")) {
+        return OS_ERR_UNSUPPORTED;
+    }
+    long long start = now_ns();
+
+    // 按所在队列的顺序收集进程，装载时按同样顺序放回
+    int live = 0;
+    for (int pid = 0; pid < pid_table_size; pid++) {
+        if (pid_table[pid] != NULL) live++;
+    }
+    PCB **procs = (PCB**)malloc((live + 1) * sizeof(PCB*));
+    int *locs = (int*)malloc((live + 1) * sizeof(int));
+    int count = 0;
+    if (running_process != NULL) {
+        snapshot_push(procs, locs, live, &count, running_process, SNAP_RUNNING);
+    }
+    if (interrupted_process != NULL) {
+        snapshot_push(procs, locs, live, &count, interrupted_process, SNAP_INTERRUPTED);
+    }
+    for (int i = 0; i < edf_heap.size; i++) {
+        snapshot_push(procs, locs, live, &count, edf_heap.items[i], SNAP_READY);
+    }
+    switch (current_algorithm) {
+        case MLFQ:
+            for (int level = 0; level < MLFQ_LEVELS; level++) {
+                for (PCB *p = mlfq_head[level]; p != NULL; p = p->next) {
+                    snapshot_push(procs, locs, live, &count, p, SNAP_READY);
+                }
+            }
+            break;
+        case SJF:
+        case SRTF:
+            for (int i = 0; i < sjf_heap.size; i++) {
+                snapshot_push(procs, locs, live, &count, sjf_heap.items[i], SNAP_READY);
+            }
+            break;
+        case CFS:
+            for (PCB *p = cfs_leftmost; p != NULL; p = cfs_next(p)) {
+                snapshot_push(procs, locs, live, &count, p, SNAP_READY);
+            }
+            break;
+        default:
+            for (PCB *p = ready_queue; p != NULL; p = p->next) {
+                snapshot_push(procs, locs, live, &count, p, SNAP_READY);
+            }
+            break;
+    }
+    for (int i = 0; i < edf_release_heap.size; i++) {
+        snapshot_push(procs, locs, live, &count, edf_release_heap.items[i], SNAP_RT_WAITING);
+    }
+    for (PCB *p = blocked_queue; p != NULL; p = p->next) {
+        snapshot_push(procs, locs, live, &count, p, SNAP_BLOCKED);
+    }
+    if (count != live) {
+        klog("错误: 队列中的进程数 %d 与进程表中的 %d 不一致，无法保存\n", count, live);
+        free(procs);
+        free(locs);
+        return OS_ERR_BAD_STATE;
+    }
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.header_size = sizeof(SnapshotHeader);
+    header.memory_size = memory_total;
+    header.disk_blocks = DISK_SIZE/BLOCK_SIZE;
+    header.process_count = live;
+    for (MemoryBlock *b = memory; b != NULL; b = b->next) {
+        header.memory_block_count++;
+    }
+    header.file_count = snapshot_count_files(root_directory);
+    header.inode_count = inode_slots;
+    for (int d = 0; d < NUM_DEVICES; d++) {
+        header.io_request_count += devices[d].queue_length + (devices[d].current != NULL ? 1 : 0);
+    }
+    header.sim_event_count = event_count;
+
+    SnapshotCounters counters;
+    memset(&counters, 0, sizeof(counters));
+    counters.time = time_counter;
+    counters.pid_next = next_pid;
+    counters.algorithm = current_algorithm;
+    counters.interrupt_flag = system_interrupt_flag;
+    counters.last_boost = mlfq_last_boost;
+    counters.disk_sched = disk_policy;
+    counters.head = disk_head;
+    counters.min_vruntime = cfs_min_vruntime;
+    counters.seq = event_seq;
+    counters.events = events_processed;
+    counters.jumps = clock_jumps;
+    counters.idle = idle_ticks;
+    counters.context_switches = metric_context_switches;
+    counters.alloc_success = metric_alloc_success;
+    counters.alloc_failure = metric_alloc_failure;
+    counters.utilization = rt_utilization;
+    counters.admitted = rt_admitted;
+    counters.rejected = rt_rejected;
+    counters.jobs_completed = rt_jobs_completed;
+    counters.deadline_misses = rt_deadline_misses;
+    for (int d = 0; d < NUM_DEVICES; d++) {
+        counters.device_completed[d] = devices[d].completed;
+        counters.device_wait[d] = devices[d].total_wait;
+        counters.device_service[d] = devices[d].total_service;
+    }
+    memcpy(counters.disk_policy_stats, disk_stats, sizeof(disk_stats));
+    counters.compaction = compaction_stats;
+    counters.defrag = defrag_stats;
+    counters.finished = processes_finished;
+    counters.turnarounds = turnaround_total;
+    counters.longest_turnaround = turnaround_max;
+    counters.failed_creates = creates_failed;
+
+    SnapshotProcess *proc_recs = (SnapshotProcess*)calloc(live + 1, sizeof(SnapshotProcess));
+    for (int i = 0; i < live; i++) {
+        PCB *p = procs[i];
+        SnapshotProcess *rec = &proc_recs[i];
+        rec->pid = p->pid;
+        memcpy(rec->name, p->name, sizeof(rec->name));
+        rec->state = p->state;
+        rec->location = locs[i];
+        rec->priority = p->priority;
+        rec->base_priority = p->base_priority;
+        rec->time_slice = p->time_slice;
+        rec->memory_start = p->memory_start;
+        rec->memory_size = p->memory_size;
+        rec->mlfq_level = p->mlfq_level;
+        rec->quantum_left = p->quantum_left;
+        rec->burst_time = p->burst_time;
+        rec->arrival_time = p->arrival_time;
+        rec->burst_estimate = p->burst_estimate;
+        rec->vruntime = p->vruntime;
+        rec->rt_runtime = p->rt_runtime;
+        rec->rt_period = p->rt_period;
+        rec->rt_deadline = p->rt_deadline;
+        rec->rt_budget = p->rt_budget;
+        rec->rt_abs_deadline = p->rt_abs_deadline;
+        rec->rt_next_release = p->rt_next_release;
+        rec->rt_misses = p->rt_misses;
+    }
+
+    SnapshotMemoryBlock *mem_recs = (SnapshotMemoryBlock*)malloc(header.memory_block_count * sizeof(SnapshotMemoryBlock));
+    int m = 0;
+    for (MemoryBlock *b = memory; b != NULL; b = b->next, m++) {
+        mem_recs[m].start_address = b->start_address;
+        mem_recs[m].size = b->size;
+        mem_recs[m].pid = b->pid;
+        mem_recs[m].is_allocated = b->is_allocated;
+    }
+
+    int disk_next[DISK_SIZE/BLOCK_SIZE];
+    char disk_used[DISK_SIZE/BLOCK_SIZE];
+    for (int i = 0; i < DISK_SIZE/BLOCK_SIZE; i++) {
+        disk_next[i] = disk[i].next_block;
+        disk_used[i] = disk[i].is_allocated;
+    }
+
+    SnapshotFile *file_recs = (SnapshotFile*)malloc(header.file_count * sizeof(SnapshotFile));
+    int file_count = 0;
+    header.cwd_index = 0;
+    snapshot_put_files(root_directory, -1, file_recs, &file_count, &header.cwd_index);
+
+    SnapshotIORequest *io_recs = (SnapshotIORequest*)calloc(header.io_request_count + 1, sizeof(SnapshotIORequest));
+    int r = 0;
+    for (int d = 0; d < NUM_DEVICES; d++) {
+        IORequest *current = devices[d].current;
+        IORequest *req = current != NULL ? current : devices[d].queue_head;
+        while (req != NULL) {
+            io_recs[r].device = d;
+            io_recs[r].pid = req->proc != NULL ? req->proc->pid : -1;
+            io_recs[r].block = req->block;
+            io_recs[r].is_write = req->is_write;
+            io_recs[r].submit_time = req->submit_time;
+            io_recs[r].start_time = req->start_time;
+            io_recs[r].current = req == current;
+            r++;
+            req = req == current ? devices[d].queue_head : req->next;
+        }
+    }
+
+    bool ok = false;
+    FILE *out = fopen(path, "wb");
+    if (out == NULL) {
+        klog("无法创建快照文件 %s\n", path);
+    } else {
+        fwrite(&header, sizeof(header), 1, out);
+        fwrite(&counters, sizeof(counters), 1, out);
+        fwrite(proc_recs, sizeof(SnapshotProcess), live, out);
+        fwrite(mem_recs, sizeof(SnapshotMemoryBlock), header.memory_block_count, out);
+        fwrite(disk_next, sizeof(disk_next), 1, out);
+        fwrite(disk_used, sizeof(disk_used), 1, out);
+        fwrite(file_recs, sizeof(SnapshotFile), file_count, out);
+        for (int ino = 0; ino < inode_slots; ino++) {
+            const Inode *node = &inode_table[ino];
+            SnapshotInode rec;
+            memset(&rec, 0, sizeof(rec));
+            rec.type = node->type;
+            rec.links = node->links;
+            rec.size = node->size;
+            rec.block_count = node->block_count;
+            rec.first_block = node->first_block;
+            rec.target_len = node->target != NULL ? (int)strlen(node->target) : 0;
+            rec.create_time = node->create_time;
+            rec.modify_time = node->modify_time;
+            fwrite(&rec, sizeof(rec), 1, out);
+            if (rec.target_len > 0) {
+                fwrite(node->target, 1, rec.target_len, out);
+            }
+        }
+        fwrite(io_recs, sizeof(SnapshotIORequest), header.io_request_count, out);
+        // 事件按堆数组顺序保存，装载后无需重新建堆
+        for (int i = 0; i < event_count; i++) {
+            SnapshotEvent ev;
+            memset(&ev, 0, sizeof(ev));
+            ev.time = event_queue[i].time;
+            ev.type = event_queue[i].type;
+            ev.pid = event_queue[i].pid;
+            ev.arg = event_queue[i].arg;
+            ev.seq = event_queue[i].seq;
+            ev.command_len = event_queue[i].command != NULL ? (int)strlen(event_queue[i].command) : -1;
+            fwrite(&ev, sizeof(ev), 1, out);
+            if (ev.command_len > 0) {
+                fwrite(event_queue[i].command, 1, ev.command_len, out);
+            }
+        }
+        long size = ftell(out);
+        ok = !ferror(out);
+        ok = fclose(out) == 0 && ok;
+        if (ok) {
+            klog("快照已保存到 %s: %d 个进程, %d 个内存块, %d 个文件, %d 个I/O请求, %d 个事件, %ld 字节, 用时 %.2f ms\n",
+                   path, live, header.memory_block_count, file_count, header.io_request_count,
+                   event_count, size, (now_ns() - start) / 1e6);
+        } else {
+            // 不留下写了一半的快照
+            remove(path);
+            klog("写入快照文件 %s 失败\n", path);
+        }
+    }
+
+    free(procs);
+    free(locs);
+    free(proc_recs);
+    free(mem_recs);
+    free(file_recs);
+    free(io_recs);
+    return ok ? OS_OK : OS_ERR_IO;
+}
+
+static void free_space_clear(FreeSpaceStats *fs, int max_size) {
+    memset(fs->size_count, 0, (max_size + 1) * sizeof(int));
+    memset(fs->classes, 0, sizeof(fs->classes));
+    fs->regions = 0;
+    fs->total = 0;
+    fs->largest = 0;
+}
+
+// 丢弃当前的内存链表、文件系统、I/O请求与事件（调用前已确认没有进程）
+static void snapshot_reset_state() {
+    while (memory != NULL) {
+        MemoryBlock *next = memory->next;
+        node_free(memory);
+        memory = next;
+    }
+    free_space_clear(&mem_free_space, memory_total);
+
+    if (root_directory != NULL) {
+        delete_file(root_directory);
+    }
+    root_directory = current_directory = NULL;
+    inode_slots = 0;
+    inode_free_list = -1;
+    inodes_in_use = 0;
+    free_space_clear(&disk_free_space, DISK_SIZE/BLOCK_SIZE);
+    memset(disk_owner, 0, sizeof(disk_owner));
+    memset(&file_frag, 0, sizeof(file_frag));
+
+    for (int d = 0; d < NUM_DEVICES; d++) {
+        node_free(devices[d].current);
+        devices[d].current = NULL;
+        while (devices[d].queue_head != NULL) {
+            IORequest *req = devices[d].queue_head;
+            devices[d].queue_head = req->next;
+            node_free(req);
+        }
+        devices[d].queue_tail = NULL;
+        devices[d].queue_length = 0;
+    }
+
+    while (event_count > 0) {
+        SimEvent ev = pop_event();
+        free(ev.command);
+    }
+}
+
+static bool read_records(FILE *in, void *buf, size_t size, int count) {
+    return count == 0 || fread(buf, size, count, in) == (size_t)count;
+}
+
+OsStatus snapshot_load(const char *path) {
+    if (!snapshot_supported("装载")) {
+        return OS_ERR_UNSUPPORTED;
+    }
+    for (int pid = 0; pid < pid_table_size; pid++) {
+        if (pid_table[pid] != NULL) {
+            klog("错误: 装载快照需要没有进程\n");
+            return OS_ERR_BAD_STATE;
+        }
+    }
+    FILE *in = fopen(path, "rb");
+    if (in == NULL) {
+        klog("无法打开快照文件 %s\n", path);
+        return OS_ERR_IO;
+    }
+    long long start = now_ns();
+
+    SnapshotHeader header;
+    if (fread(&header, sizeof(header), 1, in) != 1 ||
+        memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+        header.version != SNAPSHOT_VERSION || header.header_size != (int)sizeof(SnapshotHeader)) {
+        klog("错误: %s 不是本版本的快照文件\n", path);
+        fclose(in);
+        return OS_ERR_INVALID;
+    }
+    if (header.memory_size != memory_total || header.disk_blocks != DISK_SIZE/BLOCK_SIZE) {
+        klog("错误: 快照的内存大小 %d / 磁盘块数 %d 与本程序不一致\n",
+               header.memory_size, header.disk_blocks);
+        fclose(in);
+        return OS_ERR_INVALID;
+    }
+    if (header.process_count < 0 || header.memory_block_count <= 0 || header.file_count <= 0 ||
+        header.inode_count <= 0 || header.io_request_count < 0 || header.sim_event_count < 0) {
+        klog("错误: 快照文件 %s 已损坏\n", path);
+        fclose(in);
+        return OS_ERR_INVALID;
+    }
+
+    // 全部记录一次性读入并校验，通过后才替换当前状态
+    SnapshotCounters counters;
+    SnapshotProcess *proc_recs = (SnapshotProcess*)malloc((header.process_count + 1) * sizeof(SnapshotProcess));
+    SnapshotMemoryBlock *mem_recs = (SnapshotMemoryBlock*)malloc(header.memory_block_count * sizeof(SnapshotMemoryBlock));
+    int disk_next[DISK_SIZE/BLOCK_SIZE];
+    char disk_used[DISK_SIZE/BLOCK_SIZE];
+    SnapshotFile *file_recs = (SnapshotFile*)malloc(header.file_count * sizeof(SnapshotFile));
+    SnapshotInode *inode_recs = (SnapshotInode*)malloc(header.inode_count * sizeof(SnapshotInode));
+    char **targets = (char**)calloc(header.inode_count, sizeof(char*));
+    SnapshotIORequest *io_recs = (SnapshotIORequest*)malloc((header.io_request_count + 1) * sizeof(SnapshotIORequest));
+    SimEvent *events = (SimEvent*)calloc(header.sim_event_count + 1, sizeof(SimEvent));
+    bool ok = fread(&counters, sizeof(counters), 1, in) == 1 &&
+              read_records(in, proc_recs, sizeof(SnapshotProcess), header.process_count) &&
+              read_records(in, mem_recs, sizeof(SnapshotMemoryBlock), header.memory_block_count) &&
+              fread(disk_next, sizeof(disk_next), 1, in) == 1 &&
+              fread(disk_used, sizeof(disk_used), 1, in) == 1 &&
+              read_records(in, file_recs, sizeof(SnapshotFile), header.file_count);
+    for (int i = 0; ok && i < header.inode_count; i++) {
+        SnapshotInode *rec = &inode_recs[i];
+        ok = fread(rec, sizeof(*rec), 1, in) == 1 && rec->target_len >= 0 && rec->target_len < FILE_MAX_PATH;
+        if (!ok) break;
+        if (rec->type == SYMLINK_TYPE && rec->links > 0) {
+            targets[i] = (char*)malloc(rec->target_len + 1);
+            ok = read_records(in, targets[i], 1, rec->target_len);
+            targets[i][rec->target_len] = '\0';
+        } else {
+            ok = rec->target_len == 0;
+        }
+    }
+    ok = ok && read_records(in, io_recs, sizeof(SnapshotIORequest), header.io_request_count);
+    for (int i = 0; ok && i < header.sim_event_count; i++) {
+        SnapshotEvent ev;
+        ok = fread(&ev, sizeof(ev), 1, in) == 1 && ev.command_len >= -1 && ev.command_len < 4096 &&
+             (ev.type == EVENT_IO_COMPLETE || (ev.type == EVENT_ARRIVAL && ev.command_len >= 0));
+        if (!ok) break;
+        events[i].time = ev.time;
+        events[i].type = (EventType)ev.type;
+        events[i].pid = ev.pid;
+        events[i].arg = ev.arg;
+        events[i].seq = ev.seq;
+        if (ev.command_len >= 0) {
+            events[i].command = (char*)malloc(ev.command_len + 1);
+            ok = read_records(in, events[i].command, 1, ev.command_len);
+            events[i].command[ev.command_len] = '\0';
+        }
+    }
+    fclose(in);
+
+    // 校验：PID唯一且小于next_pid，运行/被中断的进程各至多一个，内存块首尾相接覆盖整个内存，块链和文件树的下标有效
+    char *seen = NULL;
+    if (ok) {
+        ok = counters.pid_next > 0 && counters.algorithm >= FCFS && counters.algorithm <= CFS &&
+             counters.disk_sched >= 0 && counters.disk_sched < NUM_DISK_POLICIES;
+    }
+    if (ok) {
+        seen = (char*)calloc(counters.pid_next, 1);
+        int running = 0, interrupted = 0;
+        for (int i = 0; ok && i < header.process_count; i++) {
+            SnapshotProcess *rec = &proc_recs[i];
+            ok = rec->pid > 0 && rec->pid < counters.pid_next && !seen[rec->pid] &&
+                 rec->location >= SNAP_RUNNING && rec->location <= SNAP_BLOCKED &&
+                 rec->mlfq_level >= 0 && rec->mlfq_level < MLFQ_LEVELS;
+            if (ok) seen[rec->pid] = 1;
+            if (rec->location == SNAP_RUNNING) running++;
+            if (rec->location == SNAP_INTERRUPTED) interrupted++;
+        }
+        ok = ok && running <= 1 && interrupted <= 1;
+    }
+    for (int i = 0, addr = 0; ok && i < header.memory_block_count; i++) {
+        ok = mem_recs[i].start_address == addr && mem_recs[i].size > 0;
+        addr += mem_recs[i].size;
+        if (i == header.memory_block_count - 1) ok = ok && addr == memory_total;
+    }
+    for (int i = 0; ok && i < DISK_SIZE/BLOCK_SIZE; i++) {
+        ok = disk_next[i] >= -1 && disk_next[i] < DISK_SIZE/BLOCK_SIZE;
+    }
+    // 目录项引用的inode须存在且类型一致，inode的链接数须等于引用它的目录项数（目录只能有一个）
+    int *refs = (int*)calloc(header.inode_count, sizeof(int));
+    for (int i = 0; ok && i < header.file_count; i++) {
+        SnapshotFile *rec = &file_recs[i];
+        rec->name[MAX_FILENAME - 1] = '\0';
+        ok = (i == 0 ? rec->parent == -1 && rec->type == DIRECTORY_TYPE && rec->ino == 0
+                     : rec->parent >= 0 && rec->parent < i && file_recs[rec->parent].type == DIRECTORY_TYPE) &&
+             rec->ino >= 0 && rec->ino < header.inode_count && inode_recs[rec->ino].type == rec->type;
+        if (ok) refs[rec->ino]++;
+    }
+    for (int i = 0; ok && i < header.inode_count; i++) {
+        SnapshotInode *rec = &inode_recs[i];
+        ok = rec->links == refs[i] &&
+             (rec->links == 0 || ((rec->type == FILE_TYPE || rec->type == SYMLINK_TYPE ||
+                                   (rec->type == DIRECTORY_TYPE && rec->links == 1)) &&
+                                  rec->first_block >= -1 && rec->first_block < DISK_SIZE/BLOCK_SIZE &&
+                                  (rec->type == FILE_TYPE || rec->first_block == -1)));
+    }
+    free(refs);
+    // 文件块链：只经过已分配的块，长度恰为block_count，任何块不属于两个文件（也就排除了环）
+    char owned[DISK_SIZE/BLOCK_SIZE];
+    memset(owned, 0, sizeof(owned));
+    for (int i = 0; ok && i < header.inode_count; i++) {
+        SnapshotInode *rec = &inode_recs[i];
+        if (rec->links == 0 || rec->type != FILE_TYPE) continue;
+        int length = 0;
+        for (int b = rec->first_block; ok && b != -1; b = disk_next[b]) {
+            ok = disk_used[b] && !owned[b] && ++length <= rec->block_count;
+            if (ok) owned[b] = 1;
+        }
+        ok = ok && length == rec->block_count;
+    }
+    ok = ok && header.cwd_index >= 0 && header.cwd_index < header.file_count &&
+         file_recs[header.cwd_index].type == DIRECTORY_TYPE;
+    // I/O请求：每个设备至多一个服务中的请求，每个进程至多一个请求（seen置2表示已有请求）
+    bool serving[NUM_DEVICES] = {false};
+    for (int i = 0; ok && i < header.io_request_count; i++) {
+        SnapshotIORequest *rec = &io_recs[i];
+        ok = rec->device >= 0 && rec->device < NUM_DEVICES &&
+             (rec->pid == -1 || (rec->pid > 0 && rec->pid < counters.pid_next && seen[rec->pid] == 1)) &&
+             !(rec->current && serving[rec->device]);
+        if (ok && rec->pid != -1) seen[rec->pid] = 2;
+        if (ok && rec->current) serving[rec->device] = true;
+    }
+    free(seen);
+    if (!ok) {
+        klog("错误: 快照文件 %s 已损坏\n", path);
+        for (int i = 0; i < header.sim_event_count; i++) {
+            free(events[i].command);
+        }
+        free(events);
+        free(proc_recs);
+        free(mem_recs);
+        free(file_recs);
+        for (int i = 0; i < header.inode_count; i++) {
+            free(targets[i]);
+        }
+        free(targets);
+        free(inode_recs);
+        free(io_recs);
+        return OS_ERR_INVALID;
+    }
+
+    snapshot_reset_state();
+
+    // 进程、内存块、文件控制块、I/O请求整块分配
+    size_t proc_bytes = header.process_count * sizeof(PCB);
+    size_t mem_bytes = header.memory_block_count * sizeof(MemoryBlock);
+    size_t file_bytes = header.file_count * sizeof(FCB);
+    SnapshotArena *arena = (SnapshotArena*)malloc(sizeof(SnapshotArena));
+    arena->size = proc_bytes + mem_bytes + file_bytes + header.io_request_count * sizeof(IORequest);
+    arena->base = (char*)calloc(1, arena->size);
+    arena->live = header.process_count + header.memory_block_count + header.file_count +
+                  header.io_request_count;
+    arena->next = snapshot_arenas;
+    snapshot_arenas = arena;
+    PCB *pcbs = (PCB*)arena->base;
+    MemoryBlock *blocks = (MemoryBlock*)(arena->base + proc_bytes);
+    FCB *fcbs = (FCB*)(arena->base + proc_bytes + mem_bytes);
+    IORequest *io_nodes = (IORequest*)(arena->base + proc_bytes + mem_bytes + file_bytes);
+
+    time_counter = counters.time;
+    incremental_tick = counters.time;   // 保存前已处理过当前时钟
+    next_pid = counters.pid_next;
+    current_algorithm = (ScheduleAlgorithm)counters.algorithm;
+    system_interrupt_flag = counters.interrupt_flag;
+    mlfq_last_boost = counters.last_boost;
+    disk_policy = (DiskPolicy)counters.disk_sched;
+    disk_head = counters.head;
+    cfs_min_vruntime = counters.min_vruntime;
+    event_seq = counters.seq;
+    events_processed = counters.events;
+    clock_jumps = counters.jumps;
+    idle_ticks = counters.idle;
+    metric_context_switches = counters.context_switches;
+    metric_alloc_success = counters.alloc_success;
+    metric_alloc_failure = counters.alloc_failure;
+    rt_utilization = counters.utilization;
+    rt_admitted = counters.admitted;
+    rt_rejected = counters.rejected;
+    rt_jobs_completed = counters.jobs_completed;
+    rt_deadline_misses = counters.deadline_misses;
+    for (int d = 0; d < NUM_DEVICES; d++) {
+        devices[d].completed = counters.device_completed[d];
+        devices[d].total_wait = counters.device_wait[d];
+        devices[d].total_service = counters.device_service[d];
+    }
+    memcpy(disk_stats, counters.disk_policy_stats, sizeof(disk_stats));
+    compaction_stats = counters.compaction;
+    defrag_stats = counters.defrag;
+    processes_finished = counters.finished;
+    turnaround_total = counters.turnarounds;
+    turnaround_max = counters.longest_turnaround;
+    creates_failed = counters.failed_creates;
+
+    // 内存链表与空闲块统计
+    for (int i = 0; i < header.memory_block_count; i++) {
+        blocks[i].start_address = mem_recs[i].start_address;
+        blocks[i].size = mem_recs[i].size;
+        blocks[i].is_allocated = mem_recs[i].is_allocated != 0;
+        blocks[i].pid = mem_recs[i].pid;
+        blocks[i].next = i + 1 < header.memory_block_count ? &blocks[i + 1] : NULL;
+        if (!blocks[i].is_allocated) {
+            free_space_add(&mem_free_space, blocks[i].size);
+        }
+    }
+    memory = blocks;
+
+    // 磁盘块与空闲段边界标记
+    disk_free_blocks = 0;
+    for (int i = 0; i < DISK_SIZE/BLOCK_SIZE; i++) {
+        disk[i].next_block = disk_next[i];
+        disk[i].is_allocated = disk_used[i] != 0;
+    }
+    for (int i = 0; i < DISK_SIZE/BLOCK_SIZE; ) {
+        if (disk[i].is_allocated) {
+            i++;
+            continue;
+        }
+        int run = i;
+        while (i < DISK_SIZE/BLOCK_SIZE && !disk[i].is_allocated) i++;
+        disk_set_run(run, i - run);
+        disk_free_blocks += i - run;
+    }
+
+    // inode表：空闲槽按inode号从小到大串成空闲链表
+    if (inode_capacity < header.inode_count) {
+        inode_capacity = header.inode_count;
+        inode_table = (Inode*)realloc(inode_table, inode_capacity * sizeof(Inode));
+    }
+    inode_slots = header.inode_count;
+    for (int i = header.inode_count - 1; i >= 0; i--) {
+        SnapshotInode *rec = &inode_recs[i];
+        Inode *node = &inode_table[i];
+        node->type = (FileType)rec->type;
+        node->links = rec->links;
+        node->size = rec->size;
+        node->block_count = rec->block_count;
+        node->first_block = rec->first_block;
+        node->block_runs = 0;
+        node->create_time = (time_t)rec->create_time;
+        node->modify_time = (time_t)rec->modify_time;
+        node->target = targets[i];
+        node->entries = NULL;
+        node->next_free = -1;
+        if (node->links == 0) {
+            node->next_free = inode_free_list;
+            inode_free_list = i;
+            continue;
+        }
+        inodes_in_use++;
+        if (node->first_block != -1) {
+            node->block_runs = chain_runs(node->first_block);
+            file_frag_account(node, 1);
+            for (int b = node->first_block; b != -1; b = disk[b].next_block) {
+                disk_owner[b] = i;
+            }
+        }
+    }
+
+    // 目录树：逆先序插到父目录的子链表头部，恢复原来的兄弟顺序
+    for (int i = 0; i < header.file_count; i++) {
+        SnapshotFile *rec = &file_recs[i];
+        FCB *file = &fcbs[i];
+        memcpy(file->name, rec->name, MAX_FILENAME);
+        file->type = (FileType)rec->type;
+        file->ino = rec->ino;
+        file->parent = rec->parent >= 0 ? &fcbs[rec->parent] : file;
+    }
+    // 子树聚合：记录按先序排列，逆序累加时子节点总在父节点之前完成；
+    // 文件的大小和块数计在先序中的首个目录项下，其余硬链接接在它后面
+    for (int i = 0; i < header.file_count; i++) {
+        FCB *file = &fcbs[i];
+        Inode *node = file_inode(file);
+        bool is_file = file->type == FILE_TYPE;
+        bool first = is_file && node->entries == NULL;
+        if (first) {
+            node->entries = file;
+        } else if (is_file) {
+            file->next_link = node->entries->next_link;
+            node->entries->next_link = file;
+        }
+        file->tree_size = first ? node->size : 0;
+        file->tree_blocks = first ? node->block_count : 0;
+        file->tree_files = is_file ? 1 : 0;
+        file->tree_dirs = file->type == DIRECTORY_TYPE ? 1 : 0;
+    }
+    for (int i = header.file_count - 1; i > 0; i--) {
+        FCB *parent = fcbs[i].parent;
+        fcbs[i].sibling = parent->child;
+        parent->child = &fcbs[i];
+        parent->tree_size += fcbs[i].tree_size;
+        parent->tree_blocks += fcbs[i].tree_blocks;
+        parent->tree_files += fcbs[i].tree_files;
+        parent->tree_dirs += fcbs[i].tree_dirs;
+    }
+    root_directory = &fcbs[0];
+    current_directory = &fcbs[header.cwd_index];
+
+    // 进程：按保存时的队列顺序放回，普通就绪进程按当前算法批量装载
+    PCB *ready_head = NULL;
+    PCB *ready_last = NULL;
+    for (int i = 0; i < header.process_count; i++) {
+        SnapshotProcess *rec = &proc_recs[i];
+        PCB *p = &pcbs[i];
+        p->pid = rec->pid;
+        memcpy(p->name, rec->name, sizeof(p->name));
+        p->name[sizeof(p->name) - 1] = '\0';
+        p->state = (ProcessState)rec->state;
+        p->priority = rec->priority;
+        p->base_priority = rec->base_priority;
+        p->time_slice = rec->time_slice;
+        p->memory_start = rec->memory_start;
+        p->memory_size = rec->memory_size;
+        p->mlfq_level = rec->mlfq_level;
+        p->quantum_left = rec->quantum_left;
+        p->burst_time = rec->burst_time;
+        p->arrival_time = rec->arrival_time;
+        p->burst_estimate = rec->burst_estimate;
+        p->heap_index = -1;
+        p->vruntime = rec->vruntime;
+        p->rt_runtime = rec->rt_runtime;
+        p->rt_period = rec->rt_period;
+        p->rt_deadline = rec->rt_deadline;
+        p->rt_budget = rec->rt_budget;
+        p->rt_abs_deadline = rec->rt_abs_deadline;
+        p->rt_next_release = rec->rt_next_release;
+        p->rt_misses = rec->rt_misses;
+        p->res_wait = -1;
+        register_process(p);
+
+        switch (rec->location) {
+            case SNAP_RUNNING:
+                running_process = p;
+                break;
+            case SNAP_INTERRUPTED:
+                interrupted_process = p;
+                break;
+            case SNAP_READY:
+                if (is_rt(p)) {
+                    heap_push(&edf_heap, p);
+                } else if (ready_last == NULL) {
+                    ready_head = ready_last = p;
+                } else {
+                    ready_last->next = p;
+                    ready_last = p;
+                }
+                break;
+            case SNAP_RT_WAITING:
+                heap_push(&edf_release_heap, p);
+                break;
+        }
+    }
+    load_ready_queue(ready_head);
+    // 阻塞队列头插，逆序加入以保持原顺序
+    for (int i = header.process_count - 1; i >= 0; i--) {
+        if (proc_recs[i].location == SNAP_BLOCKED) {
+            add_to_blocked_queue(&pcbs[i]);
+        }
+    }
+
+    for (int i = 0; i < header.io_request_count; i++) {
+        SnapshotIORequest *rec = &io_recs[i];
+        IORequest *req = &io_nodes[i];
+        req->proc = rec->pid != -1 ? lookup_process(rec->pid) : NULL;
+        req->device = rec->device;
+        req->block = rec->block;
+        req->is_write = rec->is_write != 0;
+        req->submit_time = rec->submit_time;
+        req->start_time = rec->start_time;
+        req->next = NULL;
+        if (req->proc != NULL) {
+            req->proc->io_request = req;
+        }
+        IODevice *dev = &devices[rec->device];
+        if (rec->current) {
+            dev->current = req;
+        } else {
+            if (dev->queue_tail == NULL) {
+                dev->queue_head = req;
+            } else {
+                dev->queue_tail->next = req;
+            }
+            dev->queue_tail = req;
+            dev->queue_length++;
+        }
+    }
+
+    if (header.sim_event_count > event_capacity) {
+        event_capacity = header.sim_event_count;
+        event_queue = (SimEvent*)realloc(event_queue, event_capacity * sizeof(SimEvent));
+    }
+    memcpy(event_queue, events, header.sim_event_count * sizeof(SimEvent));
+    event_count = header.sim_event_count;
+
+    klog("快照已从 %s 装载: %d 个进程, %d 个内存块, %d 个文件, %d 个I/O请求, %d 个事件, 时间 %d, 用时 %.2f ms\n",
+           path, header.process_count, header.memory_block_count, header.file_count,
+           header.io_request_count, header.sim_event_count, time_counter, (now_ns() - start) / 1e6);
+
+    free(events);
+    free(proc_recs);
+    free(mem_recs);
+    free(file_recs);
+    free(targets);
+    free(inode_recs);
+    free(io_recs);
+    return OS_OK;
+}
+
+// 处理系统中断（响应stop命令）
+OsStatus handle_system_interrupt() {
+    klog("\n[中断响应] 收到系统中断请求\n");
+    
+    // 检查是否有正在运行的进程
+    if (running_process == NULL) {
+        klog("[中断处理] 当前没有运行中的进程\n");
+        return OS_ERR_BAD_STATE;
+    }
+    if (system_interrupt_flag) {
+        klog("[中断处理] 系统已经处于中断状态\n");
+        return OS_ERR_BAD_STATE;
+    }
+    
+    // 保存当前运行进程
+    interrupted_process = running_process;
+    klog("[中断处理] 进程 %s (PID=%d) 被中断挂起\n", 
+           interrupted_process->name, interrupted_process->pid);
+    
+    // 标记中断状态
+    system_interrupt_flag = true;
+    
+    // 将被中断进程状态设置为就绪状态，但不加入就绪队列
+    interrupted_process->state = READY;
+    
+    // 清空当前运行进程指针
+    running_process = NULL;
+    
+    klog("[中断处理] 进入重新调度\n");
+    
+    // 调度其他进程运行
+    schedule_process();
+    return OS_OK;
+}
+
+// 恢复被中断的进程
+OsStatus resume_interrupted_process() {
+    if (!system_interrupt_flag || interrupted_process == NULL) {
+        klog("没有被中断的进程需要恢复\n");
+        return OS_ERR_BAD_STATE;
+    }
+    
+    klog("\n[中断恢复] 恢复被中断的进程 %s (PID=%d)\n", 
+           interrupted_process->name, interrupted_process->pid);
+    
+    // 如果当前有运行中的进程，先将其放回就绪队列
+    if (running_process != NULL) {
+        klog("[中断恢复] 当前运行中的进程 %s (PID=%d) 被放回就绪队列\n",
+               running_process->name, running_process->pid);
+        running_process->state = READY;
+        add_to_ready_queue(running_process);
+    }
+    
+    // 恢复被中断的进程为运行中
+    running_process = interrupted_process;
+    running_process->state = RUNNING;
+    
+    // 清除中断记录
+    interrupted_process = NULL;
+    system_interrupt_flag = false;
+    
+    klog("[中断恢复] 被中断进程已恢复运行\n");
+    return OS_OK;
+}
+
+// ======= 库接口 =======
+// 每个接口函数在调用期间把当前线程的内核切换为k，返回前恢复，
+// 因此可以在命令行线程或任意工作线程上驱动任意一个内核
+
+static void fill_process_info(const PCB *proc, OsProcessInfo *info) {
+    info->pid = proc->pid;
+    strncpy(info->name, proc->name, OS_NAME_LEN - 1);
+    info->name[OS_NAME_LEN - 1] = '\0';
+    info->state = proc->state;
+    info->priority = proc->priority;
+    info->time_slice = proc->time_slice;
+    info->memory_start = proc->memory_start;
+    info->memory_size = proc->memory_size;
+    info->arrival_time = proc->arrival_time;
+}
+
+// 按配置创建内核并设为当前线程的内核；配置无效时返回NULL且不改变当前内核
+static Kernel* create_from_config(const OsConfig *config, unsigned int seed) {
+    int memory_size = config->memory_size == 0 ? MEMORY_SIZE : config->memory_size;
+    if (memory_size < 0 || memory_size > KERNEL_MAX_MEMORY ||
+        config->algorithm < FCFS || config->algorithm > CFS) {
+        return NULL;
+    }
+    Kernel *k = kernel_create(memory_size, seed, config->output, config->output_context);
+    if (config->algorithm != current_algorithm) {
+        set_schedule_algorithm(config->algorithm);
+    }
+    return k;
+}
+
+Kernel* os_kernel_create(const OsConfig *config) {
+    OsConfig defaults = {};
+    if (config == NULL) {
+        config = &defaults;
+    }
+    Kernel *previous = kernel;
+    Kernel *k = create_from_config(config, config->seed);
+    kernel = previous;
+    return k;
+}
+
+void os_kernel_destroy(Kernel *k) {
+    if (k == NULL) return;
+    Kernel *previous = kernel;
+    kernel_destroy(k);
+    kernel = previous == k ? NULL : previous;
+}
+
+void os_set_output(Kernel *k, OsOutputFunc output, void *context) {
+    k->output = output;
+    k->output_context = context;
+}
+
+Kernel* os_system_init(const OsConfig *config) {
+    OsConfig defaults = {};
+    if (config == NULL) {
+        config = &defaults;
+    }
+    if (main_kernel != NULL) {
+        return NULL;
+    }
+    Kernel *previous = kernel;
+    // 种子为0时取当前时间，每次运行的随机序列不同
+    Kernel *k = create_from_config(config, config->seed != 0 ? config->seed : (unsigned int)time(NULL));
+    if (k != NULL) {
+        main_kernel = k;
+        init_metrics();
+        inject_ring_init(&injection_ring, INJECT_RING_SIZE);
+        InitializeCriticalSection(&kernel_lock);
+        klog("系统初始化完成，内存大小: %d，磁盘大小: %d\n", memory_total, DISK_SIZE);
+    }
+    kernel = previous;
+    return k;
+}
+
+void os_system_cleanup(Kernel *k) {
+    if (k == NULL || k != main_kernel) return;
+    Kernel *previous = kernel;
+    kernel = k;
+    // 先停止跟踪，停止的统计还能写到本内核的输出
+    if (trace_active) {
+        trace_stop();
+    }
+    kernel_destroy(k);
+    main_kernel = NULL;
+
+    inject_ring_free(&injection_ring);
+    while (command_metrics != NULL) {
+        CommandMetric *next = command_metrics->next;
+        free(command_metrics);
+        command_metrics = next;
+    }
+    for (int i = 0; i < TRACE_MAX_THREADS; i++) {
+        free(trace_rings[i].records);
+        trace_rings[i].records = NULL;
+    }
+    DeleteCriticalSection(&kernel_lock);
+    kernel = previous == k ? NULL : previous;
+}
+
+void os_set_command_handler(void (*handler)(char *command)) {
+    command_handler = handler;
+}
+
+void os_lock(void) {
+    EnterCriticalSection(&kernel_lock);
+}
+
+void os_unlock(void) {
+    LeaveCriticalSection(&kernel_lock);
+}
+
+bool os_try_lock(void) {
+    return TryEnterCriticalSection(&kernel_lock) != 0;
+}
+
+// 不持内核锁调用：注入队列是无锁的，跟踪记录写入调用线程自己的跟踪环
+bool os_inject_clock(Kernel *k, int ticks) {
+    Kernel *previous = kernel;
+    kernel = k;
+    bool pushed = inject_interrupt(TIMER_INTERRUPT, -1, INJECT_CLOCK_TICK, ticks);
+    TRACE(TRACE_INJECT, -1, INJECT_CLOCK_TICK, ticks);
+    kernel = previous;
+    return pushed;
+}
+
+void os_poll(Kernel *k) {
+    Kernel *previous = kernel;
+    kernel = k;
+    kernel_poll();
+    kernel = previous;
+}
+
+void os_record_command(const char *command, long long ns) {
+    metrics_record_command(command, ns);
+}
+
+long long os_now_ns(void) {
+    return now_ns();
+}
+
+OsStatus os_injection_benchmark(Kernel *k, int producers, int events) {
+    if (producers <= 0 || producers > 64 || events <= 0) {
+        return OS_ERR_INVALID;
+    }
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = injection_benchmark(producers, events);
+    kernel = previous;
+    return status;
+}
+
+static OsStatus create_process_in(Kernel *k, const char *name, int memory_size, int priority,
+                                  int time_slice, const RTParams *rt, int *pid) {
+    if (name == NULL) {
+        return OS_ERR_INVALID;
+    }
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status;
+    char copy[OS_NAME_LEN];
+    snprintf(copy, sizeof(copy), "%s", name);
+    PCB *proc = create_process(copy, memory_size, priority, time_slice, rt, &status);
+    if (proc != NULL && pid != NULL) {
+        *pid = proc->pid;
+    }
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_create_process(Kernel *k, const char *name, int memory_size, int priority,
+                           int time_slice, int *pid) {
+    return create_process_in(k, name, memory_size, priority, time_slice, NULL, pid);
+}
+
+OsStatus os_create_rt_process(Kernel *k, const char *name, int memory_size, int runtime,
+                              int period, int deadline, int time_slice, int *pid) {
+    RTParams rt;
+    rt.runtime = runtime;
+    rt.period = period;
+    rt.deadline = deadline;
+    return create_process_in(k, name, memory_size, 0, time_slice, &rt, pid);
+}
+
+OsStatus os_kill_process(Kernel *k, int pid) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = terminate_process(pid);
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_wakeup_process(Kernel *k, int pid) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = wakeup_process(pid);
+    kernel = previous;
+    return status;
+}
+
+// 以系统调用的形式由进程发起；系统调用中断被屏蔽时留待解除屏蔽后处理
+static OsStatus raise_syscall(Kernel *k, int pid, int code, int param) {
+    Kernel *previous = kernel;
+    kernel = k;
+    raise_interrupt(SYSTEM_CALL, pid, code, param);
+    OsStatus status = pending_heaps[SYSTEM_CALL].count > 0 ? OS_ERR_DEFERRED : OS_OK;
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_request_io(Kernel *k, int pid, const char *device) {
+    Kernel *previous = kernel;
+    kernel = k;
+    int d = find_device(device);
+    kernel = previous;
+    if (d < 0) {
+        return OS_ERR_INVALID;
+    }
+    return raise_syscall(k, pid, SYS_IO_REQUEST, d);
+}
+
+OsStatus os_fork_process(Kernel *k, int pid) {
+    return raise_syscall(k, pid, SYS_FORK, 0);
+}
+
+OsStatus os_set_algorithm(Kernel *k, ScheduleAlgorithm algorithm) {
+    if (algorithm < FCFS || algorithm > CFS) {
+        return OS_ERR_INVALID;
+    }
+    Kernel *previous = kernel;
+    kernel = k;
+    set_schedule_algorithm(algorithm);
+    kernel = previous;
+    return OS_OK;
+}
+
+OsStatus os_get_process(Kernel *k, int pid, OsProcessInfo *info) {
+    Kernel *previous = kernel;
+    kernel = k;
+    PCB *proc = lookup_process(pid);
+    if (proc != NULL) {
+        fill_process_info(proc, info);
+    }
+    kernel = previous;
+    return proc != NULL ? OS_OK : OS_ERR_NOT_FOUND;
+}
+
+int os_list_processes(Kernel *k, OsProcessInfo *infos, int max) {
+    Kernel *previous = kernel;
+    kernel = k;
+    int count = 0;
+    for (int pid = 0; pid < pid_table_size; pid++) {
+        if (pid_table[pid] != NULL) {
+            if (count < max) {
+                fill_process_info(pid_table[pid], &infos[count]);
+            }
+            count++;
+        }
+    }
+    kernel = previous;
+    return count;
+}
+
+int os_run(Kernel *k, int ticks) {
+    Kernel *previous = kernel;
+    kernel = k;
+    if (ticks > 0) {
+        run_simulation(ticks);
+    }
+    int now = time_counter;
+    kernel = previous;
+    return now;
+}
+
+int os_step(Kernel *k, int limit) {
+    Kernel *previous = kernel;
+    kernel = k;
+    int next = next_event_time();
+    if (next > limit) next = limit;
+    advance_clock(next > time_counter ? next : time_counter + 1);
+    int now = time_counter;
+    kernel = previous;
+    return now;
+}
+
+OsStatus os_schedule_command(Kernel *k, int delay, const char *command, int *time) {
+    if (delay <= 0 || command == NULL || command[0] == '\0') {
+        return OS_ERR_INVALID;
+    }
+    Kernel *previous = kernel;
+    kernel = k;
+    schedule_event(time_counter + delay, EVENT_ARRIVAL, -1, 0, command);
+    if (time != NULL) {
+        *time = time_counter + delay;
+    }
+    kernel = previous;
+    return OS_OK;
+}
+
+void os_get_stats(Kernel *k, OsStats *stats) {
+    Kernel *previous = kernel;
+    kernel = k;
+    stats->time = time_counter;
+    stats->ready = (int)metric_ready_depth();
+    stats->blocked = blocked_count;
+    stats->running_pid = running_process != NULL ? running_process->pid : -1;
+    stats->active = event_count > 0 || running_process != NULL || stats->ready > 0 ||
+                    blocked_count > 0 || pending_creates != NULL || compaction_active;
+    stats->finished = processes_finished;
+    stats->turnaround_sum = turnaround_total;
+    stats->turnaround_longest = turnaround_max;
+    stats->failed_creates = creates_failed;
+    stats->context_switches = metric_context_switches;
+    stats->idle = idle_ticks;
+    stats->events = events_processed;
+    stats->memory_size = memory_total;
+    stats->memory_free = mem_free_space.total;
+    stats->memory_largest_free = mem_free_space.largest;
+    stats->memory_frag_permille = fragmentation_permille(&mem_free_space);
+    stats->compactions = compaction_stats.runs;
+    stats->disk_free = disk_free_blocks;
+    stats->disk_largest_free_run = disk_free_space.largest;
+    kernel = previous;
+}
+
+void os_report(Kernel *k, OsReport report) {
+    Kernel *previous = kernel;
+    kernel = k;
+    switch (report) {
+        case OS_REPORT_PROCESSES:     display_processes(); break;
+        case OS_REPORT_STATS:         display_stats(); break;
+        case OS_REPORT_MEMORY:        display_memory(); break;
+        case OS_REPORT_FRAGMENTATION: display_fragmentation(); break;
+        case OS_REPORT_DEVICES:       display_devices(); break;
+        case OS_REPORT_DISK:          display_disk(); break;
+        case OS_REPORT_DIRECTORY:     list_command(); break;
+        case OS_REPORT_INTERRUPTS:    display_interrupt_stats(); break;
+        case OS_REPORT_IPC:           display_ipc(); break;
+        case OS_REPORT_SYNC:          display_sync(); break;
+        case OS_REPORT_RESOURCES:     display_resources(); break;
+        case OS_REPORT_METRICS:       display_metrics(); break;
+        case OS_REPORT_TRACE:         display_trace_status(); break;
+    }
+    kernel = previous;
+}
+
+void os_get_settings(Kernel *k, OsSettings *settings) {
+    Kernel *previous = kernel;
+    kernel = k;
+    settings->algorithm = current_algorithm;
+    settings->paging = memory_mode == MEM_PAGING;
+    settings->banker = banker_enabled;
+    settings->inherit_priority = priority_inheritance;
+    settings->compaction_bytes = compaction_budget;
+    settings->defrag_blocks = defrag_budget;
+    settings->disk_scheduler = disk_policy_names[disk_policy];
+    settings->page_replacement = repl_names[repl_policy];
+    settings->dump_interval = metrics_dump_interval;
+    kernel = previous;
+}
+
+OsStatus os_set_banker(Kernel *k, bool enabled) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = OS_OK;
+    if (enabled && !banker_safe(NULL, NULL)) {
+        status = OS_ERR_REJECTED;
+    } else {
+        banker_enabled = enabled;
+    }
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_set_priority_inheritance(Kernel *k, bool enabled) {
+    Kernel *previous = kernel;
+    kernel = k;
+    priority_inheritance = enabled;
+    kernel = previous;
+    return OS_OK;
+}
+
+OsStatus os_set_compaction_budget(Kernel *k, int bytes) {
+    if (bytes < 0) {
+        return OS_ERR_INVALID;
+    }
+    Kernel *previous = kernel;
+    kernel = k;
+    compaction_budget = bytes;
+    kernel = previous;
+    return OS_OK;
+}
+
+OsStatus os_set_defrag_budget(Kernel *k, int blocks) {
+    if (blocks < 0) {
+        return OS_ERR_INVALID;
+    }
+    Kernel *previous = kernel;
+    kernel = k;
+    defrag_budget = blocks;
+    kernel = previous;
+    return OS_OK;
+}
+
+OsStatus os_set_disk_policy(Kernel *k, const char *name) {
+    int policy = find_disk_policy(name);
+    if (policy < 0) {
+        return OS_ERR_INVALID;
+    }
+    Kernel *previous = kernel;
+    kernel = k;
+    disk_policy = (DiskPolicy)policy;
+    kernel = previous;
+    return OS_OK;
+}
+
+OsStatus os_set_memory_mode(Kernel *k, const char *name) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = set_memory_mode(name);
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_set_replacement_policy(Kernel *k, const char *name) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = set_replacement_policy(name);
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_set_text_log(bool enabled) {
+#if KERNEL_TEXT_LOG
+    kernel_text_log = enabled;
+    return OS_OK;
+#else
+    (void)enabled;
+    return OS_ERR_UNSUPPORTED;
+#endif
+}
+
+OsStatus os_get_text_log(bool *enabled) {
+    *enabled = KERNEL_TEXT_LOG && kernel_text_log;
+    return KERNEL_TEXT_LOG ? OS_OK : OS_ERR_UNSUPPORTED;
+}
+
+void os_get_interrupt_state(Kernel *k, OsInterruptState *state) {
+    Kernel *previous = kernel;
+    kernel = k;
+    state->interrupted = system_interrupt_flag;
+    state->running_pid = running_process != NULL ? running_process->pid : -1;
+    state->interrupted_pid = -1;
+    state->interrupted_name[0] = '\0';
+    if (interrupted_process != NULL) {
+        state->interrupted_pid = interrupted_process->pid;
+        snprintf(state->interrupted_name, sizeof(state->interrupted_name), "%s",
+                 interrupted_process->name);
+    }
+    kernel = previous;
+}
+
+OsStatus os_interrupt_running(Kernel *k) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = handle_system_interrupt();
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_resume_interrupted(Kernel *k) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = resume_interrupted_process();
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_set_interrupt_masked(Kernel *k, const char *type, bool masked) {
+    int t = find_interrupt_type(type);
+    if (t < 0) {
+        return OS_ERR_INVALID;
+    }
+    Kernel *previous = kernel;
+    kernel = k;
+    if (masked) {
+        interrupt_mask |= 1u << t;
+    } else {
+        interrupt_mask &= ~(1u << t);
+    }
+    kernel = previous;
+    return OS_OK;
+}
+
+void os_dispatch_interrupts(Kernel *k) {
+    Kernel *previous = kernel;
+    kernel = k;
+    dispatch_interrupts();
+    kernel = previous;
+}
+
+OsStatus os_compact(Kernel *k) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = OS_OK;
+    if (memory_mode != MEM_CONTIGUOUS) {
+        status = OS_ERR_UNSUPPORTED;
+    } else if (!memory_fragmented()) {
+        status = OS_ERR_BAD_STATE;
+    } else {
+        start_compaction();
+    }
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_vm_access(Kernel *k, int pid, int address, bool write, OsVmAccess *access) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = OS_OK;
+    PCB *proc = lookup_process(pid);
+    access->address_space = proc != NULL ? proc->memory_size : 0;
+    if (proc == NULL || proc->page_table == NULL) {
+        status = proc == NULL ? OS_ERR_NOT_FOUND : OS_ERR_UNSUPPORTED;
+    } else if (address < 0 || address >= proc->memory_size) {
+        status = OS_ERR_INVALID;
+    } else {
+        long long faults = proc->page_faults;
+        long long hits = vm_stats.tlb_hits;
+        access->physical_address = vm_translate(proc, address, write);
+        access->page = address / PAGE_SIZE;
+        access->offset = address % PAGE_SIZE;
+        access->frame = access->physical_address / PAGE_SIZE;
+        access->tlb_hit = vm_stats.tlb_hits > hits;
+        access->page_fault = proc->page_faults > faults;
+    }
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_shm_create(Kernel *k, const char *name, int size) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status;
+    shm_create(name, size, &status);
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_shm_attach(Kernel *k, int pid, const char *name) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = shm_attach(pid, name);
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_shm_detach(Kernel *k, int pid, const char *name) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = shm_detach(pid, name);
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_shm_remove(Kernel *k, const char *name) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = shm_remove(name);
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_channel_create(Kernel *k, const char *name, int slots) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status;
+    channel_create(name, slots, &status);
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_channel_send(Kernel *k, int pid, const char *name, const char *message) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = ipc_send(pid, name, message);
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_channel_receive(Kernel *k, int pid, const char *name) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = ipc_recv(pid, name);
+    kernel = previous;
+    return status;
+}
+
+static OsStatus create_sync_in(Kernel *k, SyncType type, const char *name, int value, const char *mutex) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status;
+    sync_create(type, name, value, mutex != NULL ? find_sync(mutex) : NULL, &status);
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_mutex_create(Kernel *k, const char *name) {
+    return create_sync_in(k, SYNC_MUTEX, name, 0, NULL);
+}
+
+OsStatus os_semaphore_create(Kernel *k, const char *name, int value) {
+    return create_sync_in(k, SYNC_SEMAPHORE, name, value, NULL);
+}
+
+OsStatus os_condvar_create(Kernel *k, const char *name, const char *mutex) {
+    return create_sync_in(k, SYNC_CONDVAR, name, 0, mutex);
+}
+
+OsStatus os_sync_call(Kernel *k, int pid, OsSyncOp op, const char *name) {
+    static const int codes[] = {
+        SYS_MUTEX_LOCK, SYS_MUTEX_UNLOCK, SYS_SEM_WAIT, SYS_SEM_POST,
+        SYS_COND_WAIT, SYS_COND_SIGNAL, SYS_COND_BROADCAST
+    };
+    if (op < OS_MUTEX_LOCK || op > OS_COND_BROADCAST) {
+        return OS_ERR_INVALID;
+    }
+    Kernel *previous = kernel;
+    kernel = k;
+    SyncObject *obj = find_sync(name);
+    kernel = previous;
+    if (obj == NULL) {
+        return OS_ERR_NOT_FOUND;
+    }
+    return raise_syscall(k, pid, codes[op], obj->id);
+}
+
+OsStatus os_resource_create(Kernel *k, const char *name, int units, int claim) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = resource_create(name, units, claim);
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_resource_request(Kernel *k, int pid, const char *name, int count) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = resource_request(pid, name, count);
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_resource_release(Kernel *k, int pid, const char *name, int count) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = resource_release(pid, name, count);
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_resource_claim(Kernel *k, int pid, const char *name, int claim) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = resource_claim(pid, name, claim);
+    kernel = previous;
+    return status;
+}
+
+int os_deadlock_scan(Kernel *k) {
+    Kernel *previous = kernel;
+    kernel = k;
+    int count = deadlock_scan();
+    kernel = previous;
+    return count;
+}
+
+OsStatus os_create_file(Kernel *k, const char *name, int size) {
+    if (name == NULL || name[0] == '\0' || strlen(name) >= MAX_FILENAME) {
+        return OS_ERR_INVALID;
+    }
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = create_file_command(name, size);
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_make_directory(Kernel *k, const char *name) {
+    if (name == NULL || name[0] == '\0' || strlen(name) >= MAX_FILENAME) {
+        return OS_ERR_INVALID;
+    }
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = create_directory_command(name);
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_remove_file(Kernel *k, const char *name) {
+    if (name == NULL || name[0] == '\0') {
+        return OS_ERR_INVALID;
+    }
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = delete_file_command(name);
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_remove_directory(Kernel *k, const char *name) {
+    if (name == NULL || name[0] == '\0') {
+        return OS_ERR_INVALID;
+    }
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = delete_directory_command(name);
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_change_directory(Kernel *k, const char *path) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = change_directory_command(path);
+    kernel = previous;
+    return status;
+}
+
+void os_current_directory(Kernel *k, char *path, int size) {
+    Kernel *previous = kernel;
+    kernel = k;
+    file_path(current_directory, path, size);
+    kernel = previous;
+}
+
+OsStatus os_link(Kernel *k, const char *target, const char *name, bool symbolic) {
+    if (target == NULL || target[0] == '\0' || name == NULL || name[0] == '\0') {
+        return OS_ERR_INVALID;
+    }
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = link_file(target, name, symbolic);
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_read_file(Kernel *k, const char *path) {
+    if (path == NULL || path[0] == '\0') {
+        return OS_ERR_INVALID;
+    }
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = read_file_command(path);
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_disk_usage(Kernel *k, const char *path, OsDiskUsage *usage) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = disk_usage(path, usage);
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_tree(Kernel *k, const char *path) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = tree_command(path);
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_find(Kernel *k, const char *path, const char *pattern) {
+    if (pattern == NULL || pattern[0] == '\0') {
+        return OS_ERR_INVALID;
+    }
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = find_files(path != NULL ? path : "", pattern);
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_defrag_start(Kernel *k) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = OS_OK;
+    if (defrag_active) {
+        status = OS_ERR_BAD_STATE;
+    } else {
+        start_defrag();
+    }
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_defrag_stop(Kernel *k, OsDefragInfo *info) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = OS_OK;
+    if (!defrag_active) {
+        status = OS_ERR_BAD_STATE;
+    } else {
+        if (info != NULL) {
+            defrag_info(info);
+        }
+        stop_defrag();
+    }
+    kernel = previous;
+    return status;
+}
+
+void os_get_defrag(Kernel *k, OsDefragInfo *info) {
+    Kernel *previous = kernel;
+    kernel = k;
+    defrag_info(info);
+    kernel = previous;
+}
+
+void os_disk_benchmark(Kernel *k) {
+    Kernel *previous = kernel;
+    kernel = k;
+    disk_benchmark();
+    kernel = previous;
+}
+
+OsStatus os_snapshot_save(Kernel *k, const char *path) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = snapshot_save(path);
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_snapshot_load(Kernel *k, const char *path) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = snapshot_load(path);
+    kernel = previous;
+    return status;
+}
+
+// 跟踪设施是全局的，只记录主内核；k只决定提示写到哪个内核的输出
+OsStatus os_trace_start(Kernel *k, const char *path) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = trace_start(path);
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_trace_stop(Kernel *k) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = trace_stop();
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_trace_export(Kernel *k, const char *bin_path, const char *json_path) {
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = trace_export(bin_path, json_path);
+    kernel = previous;
+    return status;
+}
+
+OsStatus os_metrics_dump(Kernel *k, const char *path, int interval) {
+    if (path == NULL || path[0] == '\0' || strlen(path) >= FILE_MAX_PATH) {
+        return OS_ERR_INVALID;
+    }
+    Kernel *previous = kernel;
+    kernel = k;
+    OsStatus status = OS_ERR_IO;
+    if (metrics_dump(path)) {
+        status = OS_OK;
+        if (interval > 0) {
+            snprintf(metrics_dump_path, sizeof(metrics_dump_path), "%s", path);
+            metrics_dump_interval = interval;
+            metrics_next_dump = time_counter + interval;
+        }
+    }
+    kernel = previous;
+    return status;
+}
+
+void os_metrics_dump_stop(Kernel *k) {
+    Kernel *previous = kernel;
+    kernel = k;
+    metrics_dump_interval = 0;
+    kernel = previous;
+}
+
+// 指标注册表只登记主内核的状态，量表在调用时从k读取
+void os_write_prometheus(Kernel *k, FILE *out) {
+    Kernel *previous = kernel;
+    kernel = k;
+    metrics_write_prometheus(out);
+    kernel = previous;
+}
+
+int os_find_algorithm(const char *key) {
+    for (int a = FCFS; a <= CFS; a++) {
+        if (strcmp(algorithm_keys[a], key) == 0) {
+            return a;
+        }
+    }
+    return -1;
+}
+
+const char* os_algorithm_key(ScheduleAlgorithm algorithm) {
+    return algorithm >= FCFS && algorithm <= CFS ? algorithm_keys[algorithm] : "?";
+}
+
+const char* os_algorithm_name(ScheduleAlgorithm algorithm) {
+    return get_algorithm_name(algorithm);
+}
+
+const char* os_status_text(OsStatus status) {
+    static const char *texts[] = {
+        "成功", "参数无效", "不存在", "已存在", "内存不足",
+        "等待内存紧缩", "准入拒绝", "磁盘空间不足", "类型不符",
+        "状态不允许", "模式不支持", "文件读写失败"
+    };
+    return status >= OS_OK && status <= OS_ERR_IO ? texts[status] : "未知错误";
+}
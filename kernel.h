@@ -0,0 +1,1236 @@
+// 内核内部头文件：常量、数据结构、内核上下文与核心函数声明。
+// 只由内核核心包含；命令行前端和参数扫描等使用者只包含os_api.h
+#ifndef KERNEL_H
+#define KERNEL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <windows.h>
+#include <process.h>
+#include <bit>
+#include <math.h>
+#include <limits.h>
+#include <stdarg.h>
+#include "os_api.h"
+
+// 定义最大进程数和内存大小
+#define MAX_PROCESSES 100
+#define MEMORY_SIZE 1024
+#define DEFAULT_TIME_SLICE 5
+#define RR_QUANTUM 4            // 时间片轮转的调度量子（time_slice是进程的总运行需求）
+#define MAX_FILENAME 32
+#define FILE_MAX_PATH 256  // 修改为FILE_MAX_PATH以避免与Windows MAX_PATH冲突
+#define DISK_SIZE 2048
+#define BLOCK_SIZE 16
+#define MAX_FILE_BLOCKS 128
+#define MAX_FILES 64
+#define FIND_PARALLEL_MIN 4096      // 子树节点数达到该值时find并行遍历
+#define FIND_MAX_THREADS 16         // find工作线程数上限
+#define TREE_MAX_DEPTH 64           // tree显示的最大深度
+#define SYMLINK_MAX_FOLLOW 8        // 解析一个路径时最多跟随的符号链接数（防止成环）
+#define INODE_TABLE_INITIAL 64      // inode表的初始容量
+#define MLFQ_LEVELS 4               // 多级反馈队列级数
+#define MLFQ_BOOST_INTERVAL 50      // 多级反馈队列周期性提升（老化）间隔
+#define BURST_ALPHA 0.5             // CPU区间指数平均的权重
+#define INITIAL_BURST_ESTIMATE 5.0  // 新进程的初始CPU区间预测值
+#define CFS_TARGET_LATENCY 20       // 完全公平调度目标延迟（所有可运行进程各运行一次的周期）
+#define CFS_MIN_GRANULARITY 2       // 完全公平调度最小时间片
+#define CFS_NICE_0_LOAD 1024        // nice为0时的权重
+#define CFS_VRUNTIME_SCALE 1024     // vruntime定点精度（1 tick = 1024）
+#define NUM_DEVICES 3               // 模拟I/O设备数
+#define NUM_INTERRUPT_TYPES 3       // 中断类型数
+#define MAX_INTERRUPT_NESTING 8     // 最大中断嵌套深度
+#define LATENCY_BUCKETS 24          // 延迟直方图桶数（按2的幂分桶）
+#define RT_UTIL_BOUND 0.95          // 实时类可准入的总利用率上限（为普通进程保留余量）
+#define COMPACT_BUDGET_DEFAULT 128  // 内存紧缩每个时钟最多移动的字节数
+#define DEFRAG_BUDGET_DEFAULT 4     // 磁盘整理每个时钟最多迁移的块数
+#define SNAPSHOT_MAGIC "OSSNAP"     // 快照文件魔数
+#define SNAPSHOT_VERSION 3
+#define MAX_SHM_ATTACH 8            // 每个共享段最多连接的进程数
+#define SHM_PID_BASE -2             // 共享段内存块的标记：SHM_PID_BASE - 段号（与进程PID区分）
+#define IPC_MSG_SIZE 16             // 通道每个消息槽的字节数
+#define WAIT_IPC -1                 // block_process的等待原因：IPC通道（非设备）
+#define WAIT_SYNC -2                // block_process的等待原因：同步对象（非设备）
+#define WAIT_RESOURCE -3            // block_process的等待原因：资源管理器中的资源（非设备）
+#define MAX_RESOURCE_TYPES 8        // 资源类型数上限
+#define SYNC_PI_MAX_DEPTH 8         // 优先级继承沿锁链传递的最大深度
+#define PAGE_SIZE 64                // 页/页框大小
+#define NUM_FRAMES (MEMORY_SIZE / PAGE_SIZE) // 物理页框数
+#define MAX_VIRTUAL_SIZE (MEMORY_SIZE * 8)  // 分页模式下单个进程的最大虚拟地址空间
+#define TLB_ENTRIES 8               // 快表项数（全相联，LRU替换）
+#define PAGE_REFS_PER_TICK 4        // 运行进程每个时钟产生的访存次数
+#define VM_LOCALITY_PAGES 3         // 局部性窗口页数
+#define VM_PHASE_REFS 64            // 每隔多少次访存局部性窗口迁移一次
+#define WSCLOCK_TAU 32              // 工作集窗口（访存次数），超过即视为离开工作集
+#define SWAP_MAX_PAGES 16           // 交换区最多占用的页数（其余磁盘空间留给文件）
+#define DISK_BLOCKS (DISK_SIZE/BLOCK_SIZE)  // 磁盘块数
+#define DISK_SECTORS_PER_TRACK 4    // 每磁道扇区（块）数
+#define DISK_CYLINDERS (DISK_BLOCKS / DISK_SECTORS_PER_TRACK) // 柱面数
+#define DISK_SEEK_SETTLE_US 1000    // 寻道启动/稳定时间（微秒）
+#define DISK_SEEK_PER_CYL_US 100    // 每跨一个柱面的寻道时间（微秒）
+#define DISK_ROTATION_US 4000       // 旋转一周时间（微秒）
+#define DISK_US_PER_TICK 1000       // 一个模拟时钟对应的微秒数
+#define INJECT_RING_SIZE 1024       // 中断注入环形队列容量（2的幂）
+#define INJECT_CLOCK_TICK 1         // 注入的时钟中断代码：推进param个时钟
+#define TRACE_ENABLED 1             // 编译期跟踪开关：0时跟踪点不产生任何代码
+#define KERNEL_TEXT_LOG 1           // 编译期内核文本日志开关：0时调度/中断等热路径不输出文字
+#define KLOG_BUFFER_SIZE 512        // 一次文字输出的栈缓冲区，更长的输出在堆上格式化
+#define TRACE_RING_SIZE 8192        // 每线程跟踪环容量（记录数，2的幂）
+#define TRACE_MAX_THREADS 8         // 可记录跟踪的线程数
+#define TRACE_FLUSH_MS 100          // 刷写线程的刷写间隔（毫秒）
+#define TRACE_MAGIC "OSTRACE"       // 跟踪文件魔数
+#define TRACE_VERSION 1
+#define HIST_SUB_BITS 3             // 直方图每个2的幂区间的子桶位数
+#define HIST_SUB_BUCKETS (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS ((64 - HIST_SUB_BITS + 1) * HIST_SUB_BUCKETS)
+#define MAX_METRICS 32              // 注册表容量
+#define FRAG_SIZE_CLASSES 12        // 空闲区大小分布的2的幂档数（覆盖到MEMORY_SIZE）
+#define FRAG_ADVISE_PERMILLE 500    // 外部碎片指数达到该千分比时提示整理
+#define KERNEL_MAX_MEMORY ((1 << FRAG_SIZE_CLASSES) - 1) // 内核内存大小上限（空闲区分档覆盖的范围）
+
+static_assert(KERNEL_MAX_MEMORY == OS_MAX_MEMORY, "库接口公布的内存上限须与空闲区分档一致");
+static_assert(FILE_MAX_PATH == OS_PATH_LEN, "库接口的路径长度须与文件系统一致");
+static_assert(DEFAULT_TIME_SLICE == OS_DEFAULT_TIME_SLICE, "库接口的默认运行需求须与内核一致");
+
+// 进程状态枚举
+typedef enum {
+    READY,
+    RUNNING,
+    BLOCKED,
+    TERMINATED
+} ProcessState;
+
+// 进程控制块
+typedef struct PCB {
+    int pid;                // 进程ID
+    char name[20];          // 进程名称
+    ProcessState state;     // 进程状态
+    int priority;           // 优先级，数值越小优先级越高
+    int time_slice;         // 时间片（剩余总运行时间，归零即完成）
+    int arrival_time;       // 创建时间，用于统计周转时间
+    int memory_start;       // 内存起始地址
+    int memory_size;        // 内存大小
+    int mlfq_level;         // 多级反馈队列所在级别，0为最高级
+    int quantum_left;       // 本次调度剩余量子（RR量子/MLFQ级别量子/CFS动态时间片）
+    int burst_time;         // 本次CPU区间已运行的时间
+    double burst_estimate;  // 下一个CPU区间的预测长度（指数平均）
+    int heap_index;         // 在就绪堆中的下标，不在堆中为-1
+    long long vruntime;     // 加权虚拟运行时间（定点，见CFS_VRUNTIME_SCALE）
+    struct PCB *rb_left;    // 红黑树左孩子
+    struct PCB *rb_right;   // 红黑树右孩子
+    struct PCB *rb_parent;  // 红黑树父节点
+    bool rb_red;            // 红黑树节点颜色
+    int rt_runtime;         // 实时：每周期运行预算，0表示普通进程
+    int rt_period;          // 实时：周期
+    int rt_deadline;        // 实时：相对截止期（不超过周期）
+    int rt_budget;          // 实时：本周期剩余预算
+    int rt_abs_deadline;    // 实时：当前作业的绝对截止期
+    int rt_next_release;    // 实时：下一周期的释放时间
+    int rt_misses;          // 实时：错过截止期次数
+    struct IORequest *io_request; // 正在等待的I/O请求
+    struct PageTableEntry *page_table; // 分页模式：页表，连续分配模式为NULL
+    int page_count;         // 虚拟页数
+    int resident_pages;     // 驻留内存的页数
+    long long page_faults;  // 缺页次数
+    int vm_locality;        // 访存局部性窗口的起始页
+    long long vm_refs;      // 已产生的访存次数
+    int base_priority;      // 基础优先级（优先级继承结束后恢复）
+    struct SyncObject *sync_wait; // 正在等待的同步对象，无为NULL
+    struct PCB *sync_next;  // 同步对象等待队列链表指针
+    int sync_wait_start;    // 开始等待同步对象的时间
+    int res_alloc[MAX_RESOURCE_TYPES]; // 持有的各类资源单位数
+    int res_claim[MAX_RESOURCE_TYPES]; // 声明的最大需求（银行家算法）
+    int res_wait;           // 正在等待的资源类型，无为-1
+    int res_wait_count;     // 等待的单位数
+    int res_wait_start;     // 开始等待资源的时间
+    struct PCB *res_next;   // 资源等待队列链表指针
+    int wfg_stamp;          // 等待图搜索的访问标记
+    struct PCB *wfg_from;   // 等待图搜索中到达本进程的前驱（用于输出环）
+    struct PCB *prev;       // 阻塞队列前驱指针（O(1)移除）
+    struct PCB *next;       // 链表指针
+} PCB;
+
+// 命名共享内存段：从内存链表分配，多个进程连接，引用计数归零且已删除时释放
+typedef struct ShmSegment {
+    int id;
+    char name[20];
+    int start;                  // 在内存区中的起始地址
+    int size;
+    char *data;                 // 段内容
+    int attached[MAX_SHM_ATTACH]; // 连接的进程PID
+    int refs;                   // 连接数
+    bool removed;               // 已删除名字，最后一个进程断开后释放
+    struct Channel *channel;    // 建在段上的通道，没有为NULL
+    struct ShmSegment *next;
+} ShmSegment;
+
+// 单生产者单消费者环形消息通道，消息槽位于共享段内
+typedef struct Channel {
+    ShmSegment *segment;
+    int capacity;               // 消息槽数
+    long long head;             // 下一个读取位置（单调递增）
+    long long tail;             // 下一个写入位置（单调递增）
+    int producer;               // 生产者PID，首次发送时确定
+    int consumer;               // 消费者PID，首次接收时确定
+    int waiting_sender;         // 因通道满而阻塞的发送者，无为-1
+    int waiting_receiver;       // 因通道空而阻塞的接收者，无为-1
+    char pending[IPC_MSG_SIZE]; // 阻塞发送者待写入的消息
+    long long messages;         // 已发送消息数
+    long long bytes;            // 已发送字节数
+    long long send_blocks;
+    long long recv_blocks;
+    long long ns;               // 发送/接收操作累计主机时间
+    int created_time;
+} Channel;
+
+// 同步对象类型
+typedef enum {
+    SYNC_MUTEX,
+    SYNC_SEMAPHORE,
+    SYNC_CONDVAR
+} SyncType;
+
+// 内核同步对象：每个对象一个FIFO等待队列
+typedef struct SyncObject {
+    int id;
+    SyncType type;
+    char name[20];
+    int value;                  // 信号量计数
+    int owner;                  // 互斥锁持有者PID，空闲为-1
+    struct SyncObject *mutex;   // 条件变量绑定的互斥锁
+    PCB *wait_head;             // 等待队列（经PCB的sync_next链接）
+    PCB *wait_tail;
+    int waiting;                // 当前等待进程数
+    int max_waiting;
+    long long acquires;         // 获得次数（含被唤醒后获得）
+    long long contended;        // 需要等待的次数
+    long long handoffs;         // 释放时直接移交给等待者的次数
+    long long total_wait;       // 累计等待时间（模拟时钟）
+    int max_wait;
+    long long wait_hist[LATENCY_BUCKETS]; // 等待时间分布
+    struct SyncObject *next;
+} SyncObject;
+
+// 资源类型：多单位资源，持有者列表提供等待图的出边
+typedef struct {
+    char name[20];
+    int total;                  // 总单位数
+    int available;              // 可用单位数
+    int default_claim;          // 新进程默认声明的最大需求
+    int *holders;               // 持有该资源的进程PID
+    int holder_count;
+    int holder_capacity;
+    PCB *wait_head;             // FIFO等待队列（经PCB的res_next链接）
+    PCB *wait_tail;
+    int waiting;
+    long long requests;         // 申请次数
+    long long grants;           // 分配次数
+    long long blocks;           // 需要等待的次数
+    long long unsafe_denials;   // 银行家算法判定不安全而推迟的次数
+    long long total_wait;       // 被推迟的请求累计等待时间
+} Resource;
+
+// 死锁检测统计
+typedef struct {
+    long long checks;           // 阻塞时的增量检测次数
+    long long edges_scanned;    // 检测遍历的等待边数
+    long long cycles;           // 发现等待环次数
+    long long deadlocks;        // 归约确认死锁次数
+} DeadlockStats;
+
+// 内存管理模式
+typedef enum {
+    MEM_CONTIGUOUS,         // 连续分配（最佳适应）
+    MEM_PAGING              // 分页 + 请求调页
+} MemoryMode;
+
+// 页表项
+typedef struct PageTableEntry {
+    int frame;              // 页框号，不在内存为-1
+    bool present;           // 是否驻留内存
+    bool referenced;        // 访问位
+    bool dirty;             // 修改位
+    bool cow;               // 写时复制：与其他进程共享页框，写入前需复制
+    int swap_block;         // 交换区中的首个磁盘块，未换出过为-1
+} PageTableEntry;
+
+// 共享页框的附加映射（反向映射）
+typedef struct FrameMapping {
+    PCB *proc;
+    int page;
+    struct FrameMapping *next;
+} FrameMapping;
+
+// 物理页框
+typedef struct {
+    PCB *owner;             // 主映射的进程，空闲为NULL
+    int page;               // 主映射的虚拟页号
+    int refs;               // 映射数（fork共享时大于1）
+    FrameMapping *shared;   // 其余共享映射
+    long long load_seq;     // 装入顺序（FIFO置换）
+    long long last_use;     // 最近访问的虚拟时间（LRU/WSClock）
+} Frame;
+
+// 页面置换算法
+typedef enum {
+    REPL_FIFO,              // 先进先出
+    REPL_LRU,               // 精确最近最久未使用
+    REPL_CLOCK,             // 时钟（第二次机会）
+    REPL_WSCLOCK,           // 工作集时钟
+    NUM_REPL_POLICIES
+} ReplacementPolicy;
+
+// 快表项：按PID区分地址空间，进程切换无需刷新
+typedef struct {
+    bool valid;
+    int pid;
+    int page;
+    int frame;
+    long long last_use;     // 最近使用时刻（LRU替换）
+} TLBEntry;
+
+// 虚拟内存统计
+typedef struct {
+    long long references;   // 访存次数
+    long long tlb_hits;
+    long long tlb_misses;
+    long long page_faults;
+    long long evictions;    // 页面置换次数
+    long long swap_outs;    // 脏页写回交换区次数
+    long long swap_ins;     // 从交换区读回次数
+    long long swap_failures;// 交换区已满、脏页内容丢弃的次数
+} VMStats;
+
+// fork统计
+typedef struct {
+    long long cow_forks;    // 写时复制fork次数（分页模式）
+    long long copy_forks;   // 完整复制fork次数（连续分配模式）
+    long long pages_shared; // fork时共享而未复制的页数
+    long long copied;       // 写时复制实际复制的页数
+    long long reused;       // 写入时共享者已退出、无需复制的页数
+    long long bytes_copied; // 完整复制fork复制的字节数
+} CowStats;
+
+// 实时进程参数
+typedef struct {
+    int runtime;            // 每周期运行预算
+    int period;             // 周期
+    int deadline;           // 相对截止期
+} RTParams;
+
+// 因碎片而等待紧缩完成后再创建的进程
+typedef struct PendingCreate {
+    char name[20];
+    int memory_size;
+    int priority;
+    int time_slice;
+    bool has_rt;
+    RTParams rt;
+    struct PendingCreate *next;
+} PendingCreate;
+
+// 内存紧缩统计
+typedef struct {
+    long long runs;             // 完成的紧缩次数
+    long long blocks_moved;     // 移动的已分配块数
+    long long bytes_moved;      // 移动的字节数
+    long long ticks;            // 紧缩跨越的时钟数
+    long long total_ns;         // 紧缩耗费的主机时间
+} CompactionStats;
+
+// PCB二叉堆（按before定义的顺序，堆顶最先出队）
+typedef struct {
+    PCB **items;            // 堆数组
+    int size;               // 元素个数
+    int capacity;           // 数组容量
+    bool (*before)(const PCB *a, const PCB *b);  // a是否应排在b之前
+} PCBHeap;
+
+// 内存块
+typedef struct MemoryBlock {
+    int start_address;       // 内存块起始地址
+    int size;                // 内存块大小
+    bool is_allocated;       // 是否已分配
+    int pid;                 // 分配给的进程ID
+    struct MemoryBlock *next;// 链表指针
+} MemoryBlock;
+
+// 空闲区统计：分配器在空闲区产生/消失时增量维护，读取为O(1)
+typedef struct {
+    int *size_count;                    // 按大小计数的空闲区个数
+    int regions;                        // 空闲区个数
+    int total;                          // 空闲总量
+    int largest;                        // 最大空闲区
+    int classes[FRAG_SIZE_CLASSES];     // 第k档为[2^k, 2^(k+1))
+} FreeSpaceStats;
+
+// 中断类型
+typedef enum {
+    TIMER_INTERRUPT,
+    IO_INTERRUPT,
+    SYSTEM_CALL
+} InterruptType;
+
+// 系统调用号
+typedef enum {
+    SYS_IO_REQUEST,         // 发起I/O请求并阻塞（参数：设备号）
+    SYS_FORK,               // 复制调用进程创建子进程
+    SYS_MUTEX_LOCK,         // 同步系统调用（参数：同步对象ID）
+    SYS_MUTEX_UNLOCK,
+    SYS_SEM_WAIT,
+    SYS_SEM_POST,
+    SYS_COND_WAIT,
+    SYS_COND_SIGNAL,
+    SYS_COND_BROADCAST
+} SyscallNumber;
+
+// 中断结构
+typedef struct Interrupt {
+    InterruptType type;     // 中断类型
+    int source;             // 中断源（设备号/发起系统调用的PID）
+    int priority;           // 中断优先级，数值越小优先级越高
+    int code;               // 系统调用号
+    int param;              // 系统调用参数
+    int raise_time;         // 产生时的模拟时间
+    long long seq;          // 产生顺序，同优先级按FIFO处理
+} Interrupt;
+
+// 一类中断的待处理队列：按优先级组成的二叉堆
+typedef struct {
+    Interrupt *items;
+    int count;
+    int capacity;
+} InterruptHeap;
+
+// 中断处理程序（中断向量表项）
+typedef void (*InterruptHandler)(const Interrupt *irq);
+
+// 每种中断的统计
+typedef struct {
+    long long raised;       // 产生次数
+    long long handled;      // 处理次数
+    long long deferred;     // 因屏蔽或优先级不足而延后处理的次数
+    long long nested;       // 嵌套在其他中断处理中执行的次数
+    long long total_handler_ns; // 处理程序累计执行时间（纳秒）
+    long long latency_hist[LATENCY_BUCKETS];    // 产生到开始处理的延迟（模拟时钟）
+    long long handler_ns_hist[LATENCY_BUCKETS]; // 处理程序执行时间（纳秒）
+} InterruptStats;
+
+// 中断注入队列槽位：seq为槽位序号，生产者写入后置为pos+1，消费者取出后置为pos+容量
+typedef struct {
+    volatile LONG seq;
+    Interrupt irq;
+    long long enqueue_ns;   // 入队时刻（纳秒）
+} InjectSlot;
+
+// 无锁多生产者单消费者环形队列：主机线程不持内核锁即可注入中断
+typedef struct {
+    InjectSlot *slots;
+    LONG mask;                  // 容量-1
+    char pad0[64];
+    volatile LONG tail;         // 生产者竞争的入队位置
+    char pad1[64];
+    LONG head;                  // 仅消费者访问的出队位置
+    volatile LONG dropped;      // 队列满而丢弃的记录数
+    long long drained;          // 已取出的记录数
+    long long total_latency_ns; // 入队到取出的累计延迟
+    long long max_latency_ns;
+    long long latency_hist[LATENCY_BUCKETS];
+} InjectRing;
+
+// 跟踪事件类型
+typedef enum {
+    TRACE_SWITCH,           // 进程开始占用CPU（arg0=剩余时间片）
+    TRACE_PREEMPT,          // 进程被放回就绪队列（arg0=原因）
+    TRACE_IDLE,             // 就绪队列为空，CPU空闲
+    TRACE_BLOCK,            // 进程阻塞（arg0=设备号或等待原因）
+    TRACE_WAKEUP,           // 进程被唤醒
+    TRACE_CREATE,           // 创建进程（arg0=内存大小，arg1=优先级）
+    TRACE_EXIT,             // 进程退出
+    TRACE_TIMER,            // 时钟推进（arg0=推进的时钟数）
+    TRACE_IRQ,              // 中断处理（arg0=中断类型，arg1=系统调用号）
+    TRACE_IO_DONE,          // I/O完成（arg0=设备号）
+    TRACE_MEM_ALLOC,        // 内存分配（arg0=起始地址，arg1=大小，失败时起始为-1）
+    TRACE_MEM_FREE,         // 内存释放（arg0=块数，arg1=总大小）
+    TRACE_PAGE_FAULT,       // 缺页（arg0=页号）
+    TRACE_INJECT,           // 主机线程注入时钟
+    NUM_TRACE_EVENTS
+} TraceEventType;
+
+// 定长二进制跟踪记录（32字节）
+typedef struct {
+    unsigned short type;    // TraceEventType
+    unsigned short cpu;     // 产生记录的线程编号
+    int tick;               // 模拟时间
+    int pid;
+    int arg0;
+    int arg1;
+    int reserved;
+    long long ns;           // 主机时间戳（纳秒）
+} TraceRecord;
+
+// 跟踪文件头，后接若干TraceRecord
+typedef struct {
+    char magic[8];
+    int version;
+    int record_size;
+    long long start_ns;
+} TraceFileHeader;
+
+// 每线程单生产者单消费者跟踪环：本线程推进head，刷写线程推进tail
+typedef struct {
+    TraceRecord *records;
+    int cpu;
+    char pad0[64];
+    volatile LONG head;
+    char pad1[64];
+    volatile LONG tail;
+    LONG dropped;               // 环满丢弃的记录数（只由本线程写）
+} TraceRing;
+
+// 对数-线性分桶直方图（HDR风格，固定相对精度）
+typedef struct {
+    long long counts[HIST_BUCKETS];
+    long long count;
+    long long sum;
+    long long min;
+    long long max;
+} Histogram;
+
+typedef enum {
+    METRIC_COUNTER,
+    METRIC_GAUGE,
+    METRIC_HISTOGRAM
+} MetricType;
+
+// 注册表项：计数器/量表直接读变量或调用读取函数，直方图指向Histogram
+typedef struct {
+    const char *name;
+    const char *help;
+    MetricType type;
+    const long long *value;
+    long long (*read)();
+    Histogram *hist;
+} Metric;
+
+// 按命令名统计的处理耗时
+typedef struct CommandMetric {
+    char name[20];
+    Histogram latency;          // 纳秒
+    struct CommandMetric *next;
+} CommandMetric;
+
+// I/O设备类型
+typedef enum {
+    DEVICE_DISK,            // 磁盘
+    DEVICE_TERMINAL,        // 终端
+    DEVICE_NETWORK          // 网络
+} DeviceType;
+
+// I/O请求
+typedef struct IORequest {
+    struct PCB *proc;       // 发起请求的进程，文件层异步请求或被取消时为NULL
+    int device;             // 目标设备
+    int block;              // 磁盘块号（非块设备为-1）
+    bool is_write;          // 写请求
+    int submit_time;        // 提交时间
+    int start_time;         // 开始服务时间
+    struct IORequest *next; // 设备请求队列指针
+} IORequest;
+
+// I/O设备：FIFO请求队列 + 服务时间模型，服务完成时产生I/O中断
+typedef struct {
+    const char *name;       // 设备名
+    DeviceType type;        // 设备类型
+    int base_service;       // 基础服务时间
+    int service_jitter;     // 服务时间随机抖动范围
+    IORequest *queue_head;  // 等待队列
+    IORequest *queue_tail;
+    int queue_length;       // 等待队列长度
+    IORequest *current;     // 正在服务的请求
+    long long completed;    // 完成请求数
+    long long total_wait;   // 累计排队时间
+    long long total_service;// 累计服务时间（即忙碌时间）
+} IODevice;
+
+// 磁盘调度（电梯）算法
+typedef enum {
+    DISK_FCFS,              // 先来先服务
+    DISK_SSTF,              // 最短寻道时间优先
+    DISK_SCAN,              // 扫描（电梯），到达端点后反向
+    DISK_CLOOK,             // 循环LOOK：单向服务，无请求时跳回最低柱面
+    NUM_DISK_POLICIES
+} DiskPolicy;
+
+// 磁头状态
+typedef struct {
+    int cylinder;           // 当前柱面
+    int direction;          // 移动方向：1向外（柱面号增大），-1向内
+} DiskHead;
+
+// 一次磁盘访问的时间分解（微秒）
+typedef struct {
+    int seek_distance;      // 寻道柱面数（SCAN含到端点的行程）
+    int seek_us;
+    int rotation_us;
+    int transfer_us;
+} DiskAccess;
+
+// 每种磁盘调度算法的累计统计
+typedef struct {
+    long long requests;
+    long long seek_distance;
+    long long seek_us;
+    long long rotation_us;
+    long long transfer_us;
+    long long wait_ticks;   // 排队时间（模拟时钟）
+} DiskPolicyStats;
+
+// 模拟事件类型
+typedef enum {
+    EVENT_IO_COMPLETE,      // 设备完成当前I/O请求
+    EVENT_ARRIVAL           // 定时到达的命令（如新进程到达）
+} EventType;
+
+// 未来事件
+typedef struct {
+    int time;               // 发生时间
+    EventType type;         // 事件类型
+    int pid;                // 相关进程ID，-1表示无
+    int arg;                // 事件参数（I/O完成事件为设备号）
+    char *command;          // 到达事件要执行的命令
+    long long seq;          // 加入顺序，同时刻事件按FIFO处理
+} SimEvent;
+
+// 文件类型枚举
+typedef enum {
+    FILE_TYPE,
+    DIRECTORY_TYPE,
+    SYMLINK_TYPE
+} FileType;
+
+// inode：文件本身的元数据，存放在按inode号索引的紧凑数组中，可被多个目录项引用（硬链接）
+typedef struct {
+    FileType type;              // 文件类型
+    int links;                  // 引用它的目录项数，0表示空闲槽
+    int size;                   // 文件大小（符号链接为目标路径长度）
+    int block_count;            // 占用块数
+    int first_block;            // 第一个数据块索引
+    int block_runs;             // 块链中的连续段数（1为完全连续）
+    int next_free;              // 空闲槽：下一个空闲inode号
+    time_t create_time;         // 创建时间
+    time_t modify_time;         // 修改时间
+    char *target;               // 符号链接的目标路径
+    struct FCB *entries;        // 普通文件：引用它的目录项链表，表头目录项的子树承担文件的大小和块数
+} Inode;
+
+// 文件控制块（目录项）：名字和目录树链接，元数据在inode中
+typedef struct FCB {
+    char name[MAX_FILENAME];    // 文件名
+    FileType type;              // 文件类型（inode类型的副本，遍历目录时不必访问inode表）
+    int ino;                    // inode号
+    struct FCB *parent;         // 父目录
+    struct FCB *child;          // 子文件/目录（如果是目录）
+    struct FCB *sibling;        // 同级文件/目录
+    struct FCB *next_link;      // 同一文件inode的下一个目录项（硬链接）
+    long long tree_size;        // 子树中文件大小之和（增量维护，du为O(1)；硬链接的文件只计一次）
+    int tree_blocks;            // 子树占用的磁盘块数（同上）
+    int tree_files;             // 子树中的文件目录项数
+    int tree_dirs;              // 子树中的目录数（含自身）
+} FCB;
+
+// 磁盘块结构
+typedef struct {
+    bool is_allocated;          // 是否已分配
+    int next_block;             // 下一块索引（用于文件块链）
+} DiskBlock;
+
+// 文件块链连续性汇总
+typedef struct {
+    long long files;            // 占用磁盘块的文件数
+    long long blocks;           // 文件块总数
+    long long runs;             // 连续段总数
+    long long fragmented;       // 段数大于1的文件数
+} FileFragStats;
+
+// 磁盘整理统计
+typedef struct {
+    long long runs;             // 完成的整理次数
+    long long blocks_moved;     // 迁移的块数（含为腾出目标位置而迁走的块）
+    long long files_packed;     // 排列到位的文件数
+    long long ticks;            // 整理跨越的时钟数
+} DefragStats;
+
+// 快照文件头，后接计数器和各类定长记录数组（进程、内存块、磁盘块、文件、I/O请求、事件）
+typedef struct {
+    char magic[8];
+    int version;
+    int header_size;            // 用于识别记录布局不同的文件
+    int memory_size;            // 须与内核的内存大小一致
+    int disk_blocks;            // 须与本程序的磁盘块数一致
+    int process_count;
+    int memory_block_count;
+    int file_count;
+    int inode_count;            // inode表长（含空闲槽）
+    int io_request_count;
+    int sim_event_count;
+    int cwd_index;              // 当前目录在文件记录中的下标
+} SnapshotHeader;
+
+// 快照中的全局状态与计数器
+typedef struct {
+    int time;
+    int pid_next;
+    int algorithm;
+    int interrupt_flag;
+    int last_boost;
+    int disk_sched;
+    DiskHead head;
+    long long min_vruntime;
+    long long seq;
+    long long events;
+    long long jumps;
+    long long idle;
+    long long context_switches;
+    long long alloc_success;
+    long long alloc_failure;
+    double utilization;
+    int admitted;
+    int rejected;
+    int jobs_completed;
+    int deadline_misses;
+    long long device_completed[NUM_DEVICES];
+    long long device_wait[NUM_DEVICES];
+    long long device_service[NUM_DEVICES];
+    DiskPolicyStats disk_policy_stats[NUM_DISK_POLICIES];
+    CompactionStats compaction;
+    DefragStats defrag;
+    long long finished;
+    long long turnarounds;
+    int longest_turnaround;
+    long long failed_creates;
+} SnapshotCounters;
+
+// 进程在快照中的位置，装载时据此放回对应队列
+typedef enum {
+    SNAP_RUNNING,
+    SNAP_INTERRUPTED,
+    SNAP_READY,
+    SNAP_RT_WAITING,            // 实时进程用完本周期预算，等待下一次释放
+    SNAP_BLOCKED
+} SnapshotLocation;
+
+typedef struct {
+    int pid;
+    char name[20];
+    int state;
+    int location;
+    int priority;
+    int base_priority;
+    int time_slice;
+    int arrival_time;
+    int memory_start;
+    int memory_size;
+    int mlfq_level;
+    int quantum_left;
+    int burst_time;
+    double burst_estimate;
+    long long vruntime;
+    int rt_runtime;
+    int rt_period;
+    int rt_deadline;
+    int rt_budget;
+    int rt_abs_deadline;
+    int rt_next_release;
+    int rt_misses;
+} SnapshotProcess;
+
+typedef struct {
+    int start_address;
+    int size;
+    int pid;
+    int is_allocated;
+} SnapshotMemoryBlock;
+
+// 目录项按先序记录，parent为父目录的记录下标（根目录为-1）
+typedef struct {
+    char name[MAX_FILENAME];
+    int type;
+    int ino;
+    int parent;
+} SnapshotFile;
+
+// inode按inode号记录（空闲槽links为0），符号链接其后紧跟target_len字节的目标路径
+typedef struct {
+    int type;
+    int links;
+    int size;
+    int block_count;
+    int first_block;
+    int target_len;
+    long long create_time;
+    long long modify_time;
+} SnapshotInode;
+
+typedef struct {
+    int device;
+    int pid;                    // 发起请求的进程，无为-1
+    int block;
+    int is_write;
+    int submit_time;
+    int start_time;
+    int current;                // 是否正在服务
+} SnapshotIORequest;
+
+// 事件记录后紧跟command_len字节的命令文本
+typedef struct {
+    int time;
+    int type;
+    int pid;
+    int arg;
+    long long seq;
+    int command_len;
+} SnapshotEvent;
+
+// 装载快照时整块分配的进程/内存块/文件控制块；块内对象释放时只计数，全部释放后归还整块
+typedef struct SnapshotArena {
+    char *base;
+    size_t size;
+    long long live;
+    struct SnapshotArena *next;
+} SnapshotArena;
+
+// 全局变量（整个程序共享：宿主线程、指标注册表与跟踪设施）
+
+// 多级反馈队列各级时间量子
+extern const int mlfq_quantum[MLFQ_LEVELS];
+
+// SJF/SRTF与EDF堆的比较函数
+bool sjf_before(const PCB *a, const PCB *b);
+bool edf_before(const PCB *a, const PCB *b);
+bool release_before(const PCB *a, const PCB *b);
+
+// nice值(-20..19)到权重的映射，相邻nice约相差10%的CPU份额
+extern const int cfs_prio_to_weight[40];
+
+// I/O设备的初始配置：磁盘、终端、网络
+extern const IODevice device_table[NUM_DEVICES];
+
+extern const int interrupt_priority[NUM_INTERRUPT_TYPES];
+extern const char *interrupt_names[NUM_INTERRUPT_TYPES];
+extern const char *algorithm_keys[];
+extern const char *sync_type_names[];
+extern const char *repl_names[NUM_REPL_POLICIES];
+extern const char *disk_policy_names[NUM_DISK_POLICIES];
+
+// 主机线程（定时器、设备）经无锁队列注入中断，内核在时钟边界取出
+extern InjectRing injection_ring;
+extern CRITICAL_SECTION kernel_lock;           // 内核状态锁：命令处理与自动运行互斥
+extern int host_clock_ticks;               // 已注入但尚未运行的时钟数
+
+// 指标注册表
+extern Metric metrics[MAX_METRICS];
+extern int num_metrics;
+extern CommandMetric *command_metrics;
+
+// 事件跟踪
+extern TraceRing trace_rings[TRACE_MAX_THREADS];
+extern volatile LONG trace_thread_count;   // 已登记跟踪环的线程数
+extern volatile LONG trace_active;         // 运行期跟踪开关
+extern volatile LONG trace_unregistered_drops;
+extern long long trace_records_written;
+extern FILE *trace_file;
+extern char trace_path[FILE_MAX_PATH];
+extern HANDLE trace_thread;             // 异步刷写线程
+extern bool kernel_text_log;            // 运行期内核文本日志开关
+extern const char *trace_event_names[];
+
+
+// 内核上下文：一次模拟的全部状态。命令行使用主内核，参数扫描的每个工作线程各建一个，
+// 互不共享；下方的同名宏经线程局部的kernel指针访问当前线程的内核
+typedef struct Kernel {
+    PCB *ready_queue;               // 就绪队列
+    PCB *ready_tail;                // 就绪队列队尾（FCFS/RR O(1)入队）
+    PCB *running_process;           // 当前运行进程
+    PCB *blocked_queue;             // 阻塞队列
+    PCB **pid_table;                // PID索引：pid -> PCB，O(1)查找
+    int pid_table_size;
+    int memory_total;               // 内存大小，不超过KERNEL_MAX_MEMORY
+    MemoryBlock *memory;            // 内存链表
+    DiskBlock disk[DISK_SIZE/BLOCK_SIZE]; // 磁盘块数组
+    int *mem_free_size_count;       // 按大小计数，memory_total+1项
+    FreeSpaceStats mem_free_space;  // 空闲内存块统计
+    int disk_run_size_count[DISK_SIZE/BLOCK_SIZE + 1];
+    FreeSpaceStats disk_free_space; // 空闲磁盘段统计
+    int disk_run_len[DISK_SIZE/BLOCK_SIZE]; // 边界标记：空闲段首尾两块记录段长
+    FileFragStats file_frag;                // 文件连续性统计
+    int disk_owner[DISK_SIZE/BLOCK_SIZE];   // 文件数据块所属inode号；交换区等不可迁移的块为0（根目录的inode，不占数据块）
+
+    // 磁盘整理：从块0起把文件依次排成连续段，每个时钟最多迁移defrag_budget块（0表示一次完成）
+    bool defrag_active;
+    int defrag_budget;
+    int defrag_cursor;                  // 之前的文件已排列完毕
+    int defrag_inode;                   // 正在排列的文件的inode号，0为无，被删除时置0
+    int defrag_started;
+    long long defrag_run_blocks;        // 本次整理已迁移的块数
+    long long defrag_run_files;
+    DefragStats defrag_stats;
+    SnapshotArena *snapshot_arenas;
+    FCB *root_directory;            // 根目录
+    Inode *inode_table;             // inode表，根目录固定为0号
+    int inode_capacity;
+    int inode_slots;                // 已启用的槽数（表长）
+    int inode_free_list;            // 空闲inode链表头，-1为空
+    int inodes_in_use;
+    FCB *current_directory;         // 当前目录
+    int next_pid;                   // 下一个可用的进程ID
+    int time_counter;               // 时钟计数器
+    ScheduleAlgorithm current_algorithm;  // 当前调度算法，默认为时间片轮转
+    unsigned int rand_state;        // 本内核的随机数状态，同一种子可复现
+    OsOutputFunc output;            // 文字日志与报告的去处，NULL为不输出（参数扫描的工作内核）
+    void *output_context;
+    long long processes_finished;   // 运行完时间片而结束的进程数
+    long long turnaround_total;     // 这些进程的周转时间之和
+    int turnaround_max;
+    long long creates_failed;       // 因内存不足等原因创建失败的进程数
+
+    // 多级反馈队列：每级一个FIFO队列，位图第i位表示第i级非空
+    PCB *mlfq_head[MLFQ_LEVELS];
+    PCB *mlfq_tail[MLFQ_LEVELS];
+    int mlfq_depth[MLFQ_LEVELS];
+    unsigned int mlfq_bitmap;
+    int mlfq_last_boost;            // 上次提升的时间
+
+    // SJF/SRTF就绪堆：按预测（剩余）CPU区间排序
+    PCBHeap sjf_heap;
+
+    // CFS就绪红黑树：按vruntime排序，缓存最左节点O(1)选取下一个进程
+    PCB *cfs_root;
+    PCB *cfs_leftmost;
+    int cfs_nr_ready;               // 树中进程数
+    long long cfs_ready_weight;     // 树中进程权重之和
+    long long cfs_min_vruntime;     // 单调递增的最小vruntime基准
+
+    // 实时调度类（EDF）：就绪作业按绝对截止期排序，用完预算的作业按释放时间等待下一周期
+    PCBHeap edf_heap;
+    PCBHeap edf_release_heap;
+    double rt_utilization;          // 已准入实时进程的总利用率
+    int rt_admitted;                // 已准入的实时进程数
+    int rt_rejected;                // 准入控制拒绝次数
+    int rt_jobs_completed;          // 完成的实时作业数
+    int rt_deadline_misses;         // 错过截止期的作业数
+
+    // 事件驱动时钟：未来事件的最小堆
+    SimEvent *event_queue;
+    int event_count;
+    int event_capacity;
+    long long event_seq;
+    long long events_processed;     // 已处理事件数
+    long long clock_jumps;          // 时钟跨越多个时钟的次数
+    long long idle_ticks;           // CPU空闲的时钟数
+
+    // I/O设备：磁盘、终端、网络
+    IODevice devices[NUM_DEVICES];
+
+    // 中断控制器：每类待处理中断各自按优先级组成二叉堆，支持屏蔽、嵌套和向量化处理
+    InterruptHeap pending_heaps[NUM_INTERRUPT_TYPES];
+    int pending_count;                  // 各类待处理中断的总数
+    long long interrupt_seq;
+    unsigned int interrupt_mask;        // 第i位为1表示屏蔽第i类中断
+    int interrupt_nesting;              // 当前中断嵌套深度
+    int max_interrupt_nesting;          // 出现过的最大嵌套深度
+    int in_service_priority;            // 正在处理的中断优先级，INT_MAX表示无
+    bool timer_interrupt_pending;       // 已有待处理的时钟中断
+    InterruptHandler interrupt_vector[NUM_INTERRUPT_TYPES];
+    InterruptStats interrupt_stats[NUM_INTERRUPT_TYPES];
+    bool system_interrupt_flag;         // 中断标志
+    PCB *interrupted_process;           // 被中断的进程
+
+    // 增量内存紧缩：每个时钟最多移动compaction_budget字节（0表示一次完成）
+    bool compaction_active;
+    int compaction_budget;
+    int compaction_started;             // 本次紧缩开始的时钟
+    long long compaction_run_bytes;     // 本次紧缩已移动的字节数
+    int incremental_tick;               // 最近一次执行紧缩/整理步骤的时钟，保证每个时钟只执行一次
+    PendingCreate *pending_creates;     // 等待紧缩完成的进程创建请求
+    PendingCreate *pending_creates_tail;
+    CompactionStats compaction_stats;
+
+    // 共享内存段链表
+    ShmSegment *shm_segments;
+    int next_shm_id;
+
+    // 同步对象链表
+    SyncObject *sync_objects;
+    int next_sync_id;
+    bool priority_inheritance;          // 互斥锁优先级继承（优先级调度下生效）
+    long long sync_pi_boosts;
+
+    // 资源管理器
+    Resource resources[MAX_RESOURCE_TYPES];
+    int num_resources;
+    bool banker_enabled;                // 银行家算法（准入与分配安全性检查）
+    long long banker_checks;
+    long long banker_rejections;
+    DeadlockStats deadlock_stats;
+    int wfg_epoch;                      // 等待图搜索的访问标记代数
+
+    // 分页：页框表、空闲页框栈、快表
+    MemoryMode memory_mode;
+    Frame frames[NUM_FRAMES];
+    int free_frames[NUM_FRAMES];
+    int free_frame_count;
+    long long frame_load_seq;
+    TLBEntry tlb[TLB_ENTRIES];
+    long long tlb_clock;
+    VMStats vm_stats;
+    ReplacementPolicy repl_policy;
+    VMStats repl_stats[NUM_REPL_POLICIES];  // 按置换算法累计
+    int clock_hand;                         // CLOCK/WSClock指针
+    int swap_pages_used;                    // 已分配交换区的页数
+    int swap_refs[DISK_BLOCKS];             // 交换块引用计数（按首块索引）
+    CowStats cow_stats;
+
+    // 磁盘：磁头位置与电梯调度
+    DiskHead disk_head;
+    DiskPolicy disk_policy;
+    DiskPolicyStats disk_stats[NUM_DISK_POLICIES];
+
+    // 本内核的指标计数（注册表登记的是主内核的地址）
+    long long metric_context_switches;
+    long long metric_alloc_success;
+    long long metric_alloc_failure;
+    Histogram metric_alloc_search;          // allocate_memory扫描的块数
+    Histogram metric_find_probes;           // find_file比较的目录项数
+    int ready_list_count;                   // FCFS/RR/优先级就绪链表长度
+    int blocked_count;                      // 阻塞队列长度
+    int disk_free_blocks;                   // 空闲磁盘块数
+    int metrics_dump_interval;              // 周期性导出间隔（时钟），0为关闭
+    int metrics_next_dump;
+    char metrics_dump_path[FILE_MAX_PATH];
+    long long metrics_dumps;
+} Kernel;
+
+extern Kernel *main_kernel;             // 命令行使用的内核
+extern thread_local Kernel *kernel;     // 当前线程正在运行的内核
+extern void (*command_handler)(char *command);  // 执行到达事件中的命令，由前端设置
+
+// 内核文字输出：交给当前内核的输出函数，未设置时不输出
+int klog(const char *format, ...);
+
+// 跟踪点：关闭时只读一个标志；编译期关闭时不产生代码
+#if TRACE_ENABLED
+#define TRACE(type, pid, arg0, arg1) \
+    do { if (trace_active) trace_emit((type), (pid), (arg0), (arg1)); } while (0)
+#else
+#define TRACE(type, pid, arg0, arg1) ((void)0)
+#endif
+
+// 内核热路径的文字输出，可在编译期或运行期关闭
+#if KERNEL_TEXT_LOG
+#define KLOG(...) do { if (kernel_text_log) klog(__VA_ARGS__); } while (0)
+#else
+#define KLOG(...) ((void)0)
+#endif
+
+// 函数声明
+Kernel* kernel_create(int memory_size, unsigned int seed, OsOutputFunc output, void *context);
+void kernel_destroy(Kernel *k);
+int kernel_rand();
+PCB* create_process(char *name, int memory_size, int priority, int time_slice, const RTParams *rt,
+                    OsStatus *status);
+PCB* fork_process(int pid);
+OsStatus terminate_process(int pid);
+void block_process(int pid, int device);
+OsStatus wakeup_process(int pid);
+void schedule_process();
+int allocate_memory(int size, int pid);
+void free_memory(int pid);
+void display_memory();
+int total_free_memory();
+void free_space_add(FreeSpaceStats *fs, int size);
+void free_space_remove(FreeSpaceStats *fs, int size);
+int fragmentation_permille(const FreeSpaceStats *fs);
+void disk_mark_allocated(int block);
+void disk_mark_free(int block);
+int chain_runs(int first_block);
+void file_frag_account(const Inode *file, int sign);
+void display_fragmentation();
+void start_defrag();
+void defrag_tick();
+void stop_defrag();
+void defrag_info(OsDefragInfo *info);
+void node_free(void *node);
+OsStatus snapshot_save(const char *path);
+OsStatus snapshot_load(const char *path);
+bool memory_fragmented();
+void start_compaction();
+void compaction_tick();
+long long now_ns();
+void vm_init();
+OsStatus set_memory_mode(const char *name);
+OsStatus set_replacement_policy(const char *name);
+void vm_setup_process(PCB *proc);
+void vm_release(PCB *proc);
+int vm_translate(PCB *proc, int vaddr, bool write);
+void vm_run_references(PCB *proc, int ticks);
+void vm_fork(PCB *parent, PCB *child);
+void display_paging();
+ShmSegment* find_shm(const char *name);
+ShmSegment* find_shm_by_tag(int tag);
+ShmSegment* shm_create(const char *name, int size, OsStatus *status);
+OsStatus shm_attach(int pid, const char *name);
+OsStatus shm_detach(int pid, const char *name);
+OsStatus shm_remove(const char *name);
+void shm_release_process(int pid);
+void ipc_cancel_wait(int pid);
+Channel* channel_create(const char *name, int slots, OsStatus *status);
+OsStatus ipc_send(int pid, const char *name, const char *msg);
+OsStatus ipc_recv(int pid, const char *name);
+void display_ipc();
+SyncObject* find_sync(const char *name);
+SyncObject* find_sync_by_id(int id);
+SyncObject* sync_create(SyncType type, const char *name, int value, SyncObject *mutex,
+                        OsStatus *status);
+bool mutex_lock(SyncObject *mutex, PCB *proc);
+bool mutex_unlock(SyncObject *mutex, PCB *proc);
+bool sem_wait(SyncObject *sem, PCB *proc);
+void sem_post(SyncObject *sem, PCB *proc);
+bool cond_wait(SyncObject *cond, PCB *proc);
+int cond_signal(SyncObject *cond, bool broadcast);
+void sync_cancel_wait(PCB *proc);
+void sync_release_process(PCB *proc);
+void sync_syscall(int pid, int code, int id);
+void display_sync();
+int find_resource(const char *name);
+OsStatus resource_create(const char *name, int units, int claim);
+bool banker_safe(PCB *extra, const int *request);
+bool banker_admit(const char *name);
+void deadlock_check(PCB *proc);
+OsStatus resource_request(int pid, const char *name, int count);
+OsStatus resource_release(int pid, const char *name, int count);
+OsStatus resource_claim(int pid, const char *name, int claim);
+void resource_cancel_wait(PCB *proc);
+void resource_release_process(PCB *proc);
+int deadlock_scan();
+void display_resources();
+void display_processes();
+void handle_timer_interrupt();
+void run_simulation(int ticks);
+void advance_clock(int target);
+void process_due_events();
+int next_event_time();
+int running_expiry_time();
+void charge_running_process(int delta);
+bool has_ready_process();
+void schedule_event(int time, EventType type, int pid, int arg, const char *command);
+SimEvent pop_event();
+void register_process(PCB *proc);
+PCB* lookup_process(int pid);
+void release_process(PCB *proc);
+int find_device(const char *name);
+void submit_io_request(PCB *proc, int device);
+void submit_block_request(PCB *proc, int block, bool is_write);
+void submit_block_chain(int first_block, bool is_write);
+int find_disk_policy(const char *name);
+IORequest* elevator_pick(IORequest *queue, DiskPolicy policy, DiskHead *head,
+                         int *extra_travel, IORequest **prev_out);
+void disk_access(DiskHead *head, int block, int extra_travel, long long start_us, DiskAccess *out);
+void disk_benchmark();
+OsStatus read_file_command(const char* name);
+void start_device(int device);
+void handle_io_interrupt(int device);
+void cancel_io_request(PCB *proc);
+void display_devices();
+void add_to_ready_queue(PCB *proc);
+PCB* remove_from_ready_queue();
+void add_to_blocked_queue(PCB *proc);
+PCB* remove_from_blocked_queue(int pid);
+PCB* remove_pid_from_ready_queue(int pid);
+void mlfq_enqueue(PCB *proc);
+PCB* mlfq_dequeue();
+void mlfq_boost();
+void mlfq_promote(PCB *proc);
+void load_ready_queue(PCB *list);
+PCB* sort_by_priority(PCB *list);
+double predicted_remaining(const PCB *proc);
+void update_burst_estimate(PCB *proc);
+void heap_reserve(PCBHeap *heap, int count);
+void heap_push(PCBHeap *heap, PCB *proc);
+PCB* heap_pop(PCBHeap *heap);
+void heap_remove(PCBHeap *heap, PCB *proc);
+void heap_build(PCBHeap *heap);
+int cfs_weight(const PCB *proc);
+int cfs_timeslice(const PCB *proc);
+void cfs_update_min_vruntime();
+void cfs_enqueue(PCB *proc);
+void cfs_dequeue(PCB *proc);
+PCB* cfs_next(PCB *node);
+bool is_rt(const PCB *proc);
+void edf_complete_job(PCB *proc);
+void edf_release_jobs();
+void rt_release_utilization(PCB *proc);
+void display_stats();
+void set_schedule_algorithm(ScheduleAlgorithm algorithm);
+const char* get_algorithm_name(ScheduleAlgorithm algorithm);
+void init_file_system();
+FCB* create_file(const char* name, FileType type, FCB* parent, OsStatus* status);
+void delete_file(FCB* file);
+int allocate_disk_block(int count);
+void free_disk_block(int first_block);
+void list_directory(FCB* dir);
+FCB* find_file(FCB* dir, const char* name);
+void display_file_system();
+FCB* change_directory(const char* path);
+FCB* resolve_path(const char* path, bool follow);
+Inode* file_inode(const FCB* file);
+int inode_alloc(FileType type);
+void inode_put(int ino);
+void file_path(const FCB* node, char* buf, size_t size);
+void fs_account(FCB* node, long long size, int blocks, int files, int dirs);
+OsStatus create_file_command(const char* name, int size);
+OsStatus create_directory_command(const char* name);
+OsStatus delete_file_command(const char* name);
+OsStatus delete_directory_command(const char* name);
+void list_command();
+OsStatus change_directory_command(const char* path);
+OsStatus tree_command(const char* path);
+OsStatus disk_usage(const char* path, OsDiskUsage* usage);
+OsStatus find_files(const char* path, const char* pattern);
+OsStatus link_file(const char* target, const char* name, bool symbolic);
+void display_disk();
+// 中断处理相关函数声明
+OsStatus handle_system_interrupt();
+OsStatus resume_interrupted_process();
+void init_interrupt_controller();
+void raise_interrupt(InterruptType type, int source, int code, int param);
+void dispatch_interrupts();
+void handle_system_call(const Interrupt *irq);
+int find_interrupt_type(const char *name);
+void display_interrupt_stats();
+bool inject_ring_init(InjectRing *ring, int capacity);
+void inject_ring_free(InjectRing *ring);
+bool inject_ring_push(InjectRing *ring, InterruptType type, int source, int code, int param);
+bool inject_ring_pop(InjectRing *ring, Interrupt *out);
+bool inject_interrupt(InterruptType type, int source, int code, int param);
+int drain_injected_interrupts();
+void kernel_poll();
+OsStatus injection_benchmark(int producers, int events);
+void trace_emit(int type, int pid, int arg0, int arg1);
+void hist_record(Histogram *hist, long long value);
+long long hist_percentile(const Histogram *hist, double p);
+void init_metrics();
+void metrics_record_command(const char *command, long long ns);
+void metrics_write_prometheus(FILE *out);
+bool metrics_dump(const char *path);
+void metrics_tick();
+void display_metrics();
+OsStatus trace_start(const char *path);
+OsStatus trace_stop();
+void display_trace_status();
+OsStatus trace_export(const char *bin_path, const char *json_path);
+
+#endif
@@ -0,0 +1,299 @@
+// 操作系统模拟内核的库接口
+//
+// 内核核心编译为静态库oskernel，命令行前端和参数扫描都只经本接口使用它。
+// 每个Kernel是一份独立的模拟：不同线程可以各自创建、驱动自己的内核，
+// 但同一个内核同一时刻只能由一个线程调用。结果经返回的状态码和查询结构取得；
+// 内核自己不写标准输出，它的文字日志和报告交给使用者设置的输出函数（未设置则不输出）。
+#ifndef OS_API_H
+#define OS_API_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#define OS_MAX_MEMORY 4095          // 内核内存大小上限
+#define OS_NAME_LEN 20              // 进程名长度（含结尾的'\0'）
+#define OS_PATH_LEN 256             // 路径长度（含结尾的'\0'）
+#define OS_DEFAULT_TIME_SLICE 5     // 进程默认的运行需求
+
+// 调度算法
+typedef enum {
+    FCFS,       // 先来先服务
+    PRIORITY,   // 优先级调度
+    RR,         // 时间片轮转
+    MLFQ,       // 多级反馈队列
+    SJF,        // 短作业优先（非抢占）
+    SRTF,       // 最短剩余时间优先（抢占式SJF）
+    CFS         // 完全公平调度
+} ScheduleAlgorithm;
+
+// 接口调用的结果
+typedef enum {
+    OS_OK,
+    OS_ERR_INVALID,         // 参数无效
+    OS_ERR_NOT_FOUND,       // 进程、文件或目录不存在
+    OS_ERR_EXISTS,          // 同名文件或目录已存在
+    OS_ERR_NO_MEMORY,       // 内存不足
+    OS_ERR_DEFERRED,        // 空闲内存足够但不连续：进程将在内存紧缩完成后创建
+    OS_ERR_REJECTED,        // 被银行家算法或实时准入控制拒绝
+    OS_ERR_NO_SPACE,        // 磁盘空间不足
+    OS_ERR_WRONG_TYPE,      // 对目录做文件操作，或反之
+    OS_ERR_BAD_STATE,       // 当前状态不允许，如整理已在进行、没有被中断的进程、存在进程时切换内存模式
+    OS_ERR_UNSUPPORTED,     // 当前内存管理模式或编译配置不支持
+    OS_ERR_IO               // 文件读写失败
+} OsStatus;
+
+typedef struct Kernel Kernel;
+
+// 内核文字输出：text是一段已格式化的文字，不一定以换行结束
+typedef void (*OsOutputFunc)(void *context, const char *text);
+
+// 创建内核的配置；全零即默认配置
+typedef struct {
+    int memory_size;                // 内存大小，0表示默认的1024
+    unsigned int seed;              // 内核随机数种子，相同种子的模拟结果相同
+    ScheduleAlgorithm algorithm;    // 初始调度算法
+    OsOutputFunc output;            // 内核文字日志与报告的去处，NULL表示不输出
+    void *output_context;           // 传给output的第一个参数
+} OsConfig;
+
+// 进程信息
+typedef struct {
+    int pid;
+    char name[OS_NAME_LEN];
+    int state;                      // 0就绪 1运行 2阻塞 3结束
+    int priority;
+    int time_slice;                 // 剩余运行时间
+    int memory_start;
+    int memory_size;
+    int arrival_time;
+} OsProcessInfo;
+
+// 内核统计
+typedef struct {
+    int time;                       // 当前模拟时间
+    int ready;                      // 就绪进程数
+    int blocked;                    // 阻塞进程数
+    int running_pid;                // 运行中进程的PID，空闲时为-1
+    bool active;                    // 仍有进程、事件或内存紧缩待处理
+    long long finished;             // 运行完成的进程数
+    long long turnaround_sum;       // 完成进程的周转时间之和
+    int turnaround_longest;
+    long long failed_creates;       // 因内存不足创建失败的进程数
+    long long context_switches;
+    long long idle;                 // CPU空闲的时钟数
+    long long events;
+    int memory_size;                // 内存大小
+    int memory_free;                // 空闲内存总量
+    int memory_largest_free;        // 最大空闲区
+    int memory_frag_permille;       // 内存外部碎片指数（千分比）
+    long long compactions;          // 完成的内存紧缩次数
+    int disk_free;                  // 空闲磁盘块数
+    int disk_largest_free_run;      // 最长连续空闲磁盘段
+} OsStats;
+
+// 运行期可调的参数
+typedef struct {
+    ScheduleAlgorithm algorithm;
+    bool paging;                    // 分页（请求调页）模式，否则为连续分配
+    bool banker;                    // 银行家算法准入与分配安全性检查
+    bool inherit_priority;          // 互斥锁优先级继承（优先级调度生效）
+    int compaction_bytes;           // 内存紧缩每时钟移动的字节数，0表示一次完成
+    int defrag_blocks;              // 磁盘整理每时钟迁移的块数，0表示一次完成
+    const char *disk_scheduler;     // 磁盘调度算法名
+    const char *page_replacement;   // 页面置换算法名
+    int dump_interval;              // 周期性导出指标的间隔，0表示不导出
+} OsSettings;
+
+// 系统中断（stop/recover）状态
+typedef struct {
+    bool interrupted;               // 系统处于中断状态
+    int running_pid;                // 运行中进程的PID，空闲时为-1
+    int interrupted_pid;            // 被中断挂起的进程，无为-1
+    char interrupted_name[OS_NAME_LEN];
+} OsInterruptState;
+
+// 磁盘整理状态：本次运行与累计统计
+typedef struct {
+    bool active;
+    int budget;                     // 每时钟迁移的块数，0表示一次完成
+    int cursor;                     // 下一个要放置的磁盘块
+    int progress;                   // 本次进度（百分比）
+    long long run_blocks;           // 本次已迁移的块数
+    long long run_files;            // 本次已排列的文件数
+    long long runs;                 // 完成的整理次数
+    long long blocks_moved;         // 累计迁移的块数
+    long long files_packed;         // 累计排列的文件数
+    long long ticks;                // 累计执行整理的时钟数
+} OsDefragInfo;
+
+// 文件或目录子树的大小（硬链接的文件只计一次）
+typedef struct {
+    char path[OS_PATH_LEN];
+    bool directory;
+    long long size;                 // 字节数
+    int blocks;                     // 占用的磁盘块数
+    long long allocated;            // 占用的磁盘字节数（整块计）
+    int files;                      // 子树中的文件目录项数（目录）
+    int directories;                // 子树中的子目录数（目录，不含自身）
+} OsDiskUsage;
+
+// 分页模式下一次访存的地址转换结果
+typedef struct {
+    int physical_address;
+    int page;
+    int offset;
+    int frame;
+    bool tlb_hit;                   // 快表命中
+    bool page_fault;                // 发生缺页
+    int address_space;              // 进程虚拟地址空间大小（地址越界时供提示）
+} OsVmAccess;
+
+// 同步对象上的操作，以系统调用的形式由进程发起
+typedef enum {
+    OS_MUTEX_LOCK,
+    OS_MUTEX_UNLOCK,
+    OS_SEM_WAIT,
+    OS_SEM_POST,
+    OS_COND_WAIT,
+    OS_COND_SIGNAL,
+    OS_COND_BROADCAST
+} OsSyncOp;
+
+// 写到内核文字输出的报告
+typedef enum {
+    OS_REPORT_PROCESSES,            // 进程与队列
+    OS_REPORT_STATS,                // 调度与内核统计
+    OS_REPORT_MEMORY,               // 内存链表或页框
+    OS_REPORT_FRAGMENTATION,        // 内存与磁盘碎片
+    OS_REPORT_DEVICES,              // I/O设备
+    OS_REPORT_DISK,                 // 磁盘使用与磁头调度
+    OS_REPORT_DIRECTORY,            // 当前目录的内容
+    OS_REPORT_INTERRUPTS,           // 中断控制器统计
+    OS_REPORT_IPC,                  // 共享段与通道
+    OS_REPORT_SYNC,                 // 同步对象
+    OS_REPORT_RESOURCES,            // 资源、分配矩阵与死锁统计
+    OS_REPORT_METRICS,              // 计数器、量表与直方图
+    OS_REPORT_TRACE                 // 事件跟踪
+} OsReport;
+
+// 内核生命周期；配置无效时返回NULL
+Kernel* os_kernel_create(const OsConfig *config);
+void os_kernel_destroy(Kernel *k);
+void os_set_output(Kernel *k, OsOutputFunc output, void *context);
+
+// 命令行的主内核：接收主机线程注入的时钟与中断，记录命令耗时与事件跟踪。
+// 进程内只有一个；seed为0时取当前时间
+Kernel* os_system_init(const OsConfig *config);
+void os_system_cleanup(Kernel *k);
+void os_set_command_handler(void (*handler)(char *command));   // 执行到达事件（at）中的命令
+void os_lock(void);                                 // 命令处理与自动运行互斥地使用主内核
+void os_unlock(void);
+bool os_try_lock(void);
+bool os_inject_clock(Kernel *k, int ticks);         // 主机线程注入时钟，队列满时返回false
+void os_poll(Kernel *k);                            // 取出注入的记录并运行积累的时钟（持锁调用）
+void os_record_command(const char *command, long long ns);
+long long os_now_ns(void);
+OsStatus os_injection_benchmark(Kernel *k, int producers, int events);
+
+// 进程
+OsStatus os_create_process(Kernel *k, const char *name, int memory_size, int priority,
+                           int time_slice, int *pid);
+OsStatus os_create_rt_process(Kernel *k, const char *name, int memory_size, int runtime,
+                              int period, int deadline, int time_slice, int *pid);
+OsStatus os_kill_process(Kernel *k, int pid);
+OsStatus os_wakeup_process(Kernel *k, int pid);
+OsStatus os_request_io(Kernel *k, int pid, const char *device);    // 设备disk/tty/net，以系统调用发起
+OsStatus os_fork_process(Kernel *k, int pid);
+OsStatus os_set_algorithm(Kernel *k, ScheduleAlgorithm algorithm);
+OsStatus os_get_process(Kernel *k, int pid, OsProcessInfo *info);
+int os_list_processes(Kernel *k, OsProcessInfo *infos, int max);   // 返回进程总数，最多填max个
+
+// 推进模拟：os_run运行ticks个时钟；os_step跳到下一个事件（至少1个时钟，不超过limit）。
+// 都返回推进后的模拟时间
+int os_run(Kernel *k, int ticks);
+int os_step(Kernel *k, int limit);
+OsStatus os_schedule_command(Kernel *k, int delay, const char *command, int *time);
+void os_get_stats(Kernel *k, OsStats *stats);
+void os_report(Kernel *k, OsReport report);
+
+// 运行期参数
+void os_get_settings(Kernel *k, OsSettings *settings);
+OsStatus os_set_banker(Kernel *k, bool enabled);                   // 当前状态不安全时拒绝开启
+OsStatus os_set_priority_inheritance(Kernel *k, bool enabled);
+OsStatus os_set_compaction_budget(Kernel *k, int bytes);
+OsStatus os_set_defrag_budget(Kernel *k, int blocks);
+OsStatus os_set_disk_policy(Kernel *k, const char *name);          // fcfs/sstf/scan/clook
+OsStatus os_set_memory_mode(Kernel *k, const char *name);          // contiguous/paging，须没有进程
+OsStatus os_set_replacement_policy(Kernel *k, const char *name);   // fifo/lru/clock/wsclock
+OsStatus os_set_text_log(bool enabled);                            // 调度/中断等热路径的文字日志
+OsStatus os_get_text_log(bool *enabled);                           // 编译期关闭时返回OS_ERR_UNSUPPORTED
+
+// 中断
+void os_get_interrupt_state(Kernel *k, OsInterruptState *state);
+OsStatus os_interrupt_running(Kernel *k);                          // 挂起运行中的进程
+OsStatus os_resume_interrupted(Kernel *k);
+OsStatus os_set_interrupt_masked(Kernel *k, const char *type, bool masked);    // timer/io/syscall
+void os_dispatch_interrupts(Kernel *k);                            // 处理解除屏蔽后积压的中断
+
+// 内存：增量紧缩与分页
+OsStatus os_compact(Kernel *k);
+OsStatus os_vm_access(Kernel *k, int pid, int address, bool write, OsVmAccess *access);
+
+// 进程间通信：共享段与单生产者单消费者通道
+OsStatus os_shm_create(Kernel *k, const char *name, int size);
+OsStatus os_shm_attach(Kernel *k, int pid, const char *name);
+OsStatus os_shm_detach(Kernel *k, int pid, const char *name);
+OsStatus os_shm_remove(Kernel *k, const char *name);
+OsStatus os_channel_create(Kernel *k, const char *name, int slots);
+OsStatus os_channel_send(Kernel *k, int pid, const char *name, const char *message);
+OsStatus os_channel_receive(Kernel *k, int pid, const char *name);
+
+// 同步对象
+OsStatus os_mutex_create(Kernel *k, const char *name);
+OsStatus os_semaphore_create(Kernel *k, const char *name, int value);
+OsStatus os_condvar_create(Kernel *k, const char *name, const char *mutex);
+OsStatus os_sync_call(Kernel *k, int pid, OsSyncOp op, const char *name);
+
+// 资源与死锁
+OsStatus os_resource_create(Kernel *k, const char *name, int units, int claim);
+OsStatus os_resource_request(Kernel *k, int pid, const char *name, int count);
+OsStatus os_resource_release(Kernel *k, int pid, const char *name, int count);
+OsStatus os_resource_claim(Kernel *k, int pid, const char *name, int claim);
+int os_deadlock_scan(Kernel *k);                                   // 返回死锁的进程数
+
+// 文件系统：路径相对于内核的当前目录
+OsStatus os_create_file(Kernel *k, const char *name, int size);
+OsStatus os_make_directory(Kernel *k, const char *name);
+OsStatus os_remove_file(Kernel *k, const char *name);
+OsStatus os_remove_directory(Kernel *k, const char *name);
+OsStatus os_change_directory(Kernel *k, const char *path);
+void os_current_directory(Kernel *k, char *path, int size);
+OsStatus os_link(Kernel *k, const char *target, const char *name, bool symbolic);
+OsStatus os_read_file(Kernel *k, const char *path);                // 向磁盘提交读取全部块的请求
+OsStatus os_disk_usage(Kernel *k, const char *path, OsDiskUsage *usage);
+OsStatus os_tree(Kernel *k, const char *path);                     // 树形显示写到文字输出
+OsStatus os_find(Kernel *k, const char *path, const char *pattern);
+
+// 磁盘：后台整理与调度算法对比
+OsStatus os_defrag_start(Kernel *k);
+OsStatus os_defrag_stop(Kernel *k, OsDefragInfo *info);            // info为停止前本次运行的状态
+void os_get_defrag(Kernel *k, OsDefragInfo *info);
+void os_disk_benchmark(Kernel *k);
+
+// 快照、事件跟踪与指标
+OsStatus os_snapshot_save(Kernel *k, const char *path);
+OsStatus os_snapshot_load(Kernel *k, const char *path);            // 须没有进程
+OsStatus os_trace_start(Kernel *k, const char *path);
+OsStatus os_trace_stop(Kernel *k);
+OsStatus os_trace_export(Kernel *k, const char *bin_path, const char *json_path);
+OsStatus os_metrics_dump(Kernel *k, const char *path, int interval);   // interval>0时之后周期性更新
+void os_metrics_dump_stop(Kernel *k);
+void os_write_prometheus(Kernel *k, FILE *out);
+
+// 名称查询
+int os_find_algorithm(const char *key);                 // 未知名称返回-1
+const char* os_algorithm_key(ScheduleAlgorithm algorithm);
+const char* os_algorithm_name(ScheduleAlgorithm algorithm);
+const char* os_status_text(OsStatus status);
+
+#endif
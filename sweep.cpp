@@ -0,0 +1,337 @@
+// 参数扫描：在多个线程上并行运行一组配置的模拟并汇总结果。
+// 只经os_api.h驱动内核，是内核库的一个使用者
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <windows.h>
+#include <process.h>
+#include "os_api.h"
+
+#define SWEEP_PROCESSES 40          // 参数扫描每个工作负载的进程数
+#define SWEEP_MAX_GAP 3             // 相邻进程到达间隔的上限（时钟）
+#define SWEEP_JOB_MIN_MEMORY 16     // 工作负载进程的内存需求范围
+#define SWEEP_JOB_MAX_MEMORY 128
+#define SWEEP_TIME_LIMIT 100000     // 单次模拟的时钟上限
+#define SWEEP_MAX_THREADS 16        // 工作线程数上限
+#define SWEEP_MAX_VALUES 16         // 每个扫描维度的取值个数上限
+
+// 参数扫描的一次模拟：配置与结果
+typedef struct {
+    ScheduleAlgorithm algorithm;
+    int time_slice;             // 工作负载进程的平均时间片
+    int memory_size;
+    unsigned int seed;          // 工作负载种子
+    int end_time;               // 结束时的模拟时间
+    int created;
+    long long finished;
+    long long failed;           // 因内存不足创建失败的进程数
+    double avg_turnaround;
+    int max_turnaround;
+    long long context_switches;
+    long long idle;             // CPU空闲的时钟数
+    int peak_frag;              // 内存外部碎片指数的峰值（千分比）
+    long long compactions;
+    double host_ms;             // 本次模拟耗费的主机时间
+} SweepRun;
+
+// 参数扫描线程池：工作线程原子地领取下一个配置
+typedef struct {
+    SweepRun *runs;
+    LONG count;
+    volatile LONG next;
+} SweepPool;
+
+// 主机单调时钟（纳秒）
+static long long sweep_now_ns() {
+    static LARGE_INTEGER frequency = {0};
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+    return (long long)((double)counter.QuadPart * 1e9 / frequency.QuadPart);
+}
+
+// 工作负载的随机数：与内核相同的线性同余序列
+static int sweep_rand(unsigned int *state) {
+    *state = *state * 214013u + 2531011u;
+    return (int)((*state >> 16) & 0x7fff);
+}
+
+// 解析逗号分隔的整数列表，a-b表示闭区间；返回取值个数，格式错误或超过max个时返回-1
+static int sweep_parse_ints(const char *text, int *values, int max) {
+    int count = 0;
+    const char *p = text;
+    while (*p != '\0') {
+        char *end;
+        long low = strtol(p, &end, 10);
+        if (end == p) return -1;
+        long high = low;
+        if (*end == '-') {
+            p = end + 1;
+            high = strtol(p, &end, 10);
+            if (end == p || high < low) return -1;
+        }
+        for (long v = low; v <= high; v++) {
+            if (count >= max) return -1;
+            values[count++] = (int)v;
+        }
+        if (*end == ',') {
+            end++;
+        } else if (*end != '\0') {
+            return -1;
+        }
+        p = end;
+    }
+    return count;
+}
+
+// 解析逗号分隔的调度算法名，all表示全部算法
+static int sweep_parse_algorithms(const char *text, int *values, int max) {
+    int count = 0;
+    if (strcmp(text, "all") == 0) {
+        for (int a = FCFS; a <= CFS && count < max; a++) {
+            values[count++] = a;
+        }
+        return count;
+    }
+    const char *p = text;
+    while (*p != '\0') {
+        size_t len = strcspn(p, ",");
+        char key[16];
+        if (len >= sizeof(key)) return -1;
+        memcpy(key, p, len);
+        key[len] = '\0';
+        int found = os_find_algorithm(key);
+        if (found < 0 || count >= max) return -1;
+        values[count++] = found;
+        p += len;
+        if (*p == ',') p++;
+    }
+    return count;
+}
+
+// 在当前线程上新建一个安静的内核运行一次模拟：同一种子生成相同的到达时间、内存需求和优先级，
+// 进程运行时间在1..2*time_slice间均匀分布
+static void sweep_run(SweepRun *run) {
+    long long start = sweep_now_ns();
+    OsConfig config = {run->memory_size, run->seed, run->algorithm, NULL, NULL};
+    Kernel *k = os_kernel_create(&config);
+
+    // 工作负载与内核使用各自的随机数序列，互不影响
+    unsigned int state = run->seed;
+    int arrivals[SWEEP_PROCESSES], sizes[SWEEP_PROCESSES], priorities[SWEEP_PROCESSES], lengths[SWEEP_PROCESSES];
+    int arrival = 0;
+    for (int i = 0; i < SWEEP_PROCESSES; i++) {
+        arrival += sweep_rand(&state) % (SWEEP_MAX_GAP + 1);
+        arrivals[i] = arrival;
+        sizes[i] = SWEEP_JOB_MIN_MEMORY + sweep_rand(&state) % (SWEEP_JOB_MAX_MEMORY - SWEEP_JOB_MIN_MEMORY + 1);
+        priorities[i] = sweep_rand(&state) % 10;
+        lengths[i] = 1 + sweep_rand(&state) % (2 * run->time_slice);
+    }
+
+    // 逐事件推进（到达时刻也是事件），每一步后采样内存碎片；全部到达且没有进程待运行时结束
+    OsStats stats;
+    os_get_stats(k, &stats);
+    int next_arrival = 0;
+    while (stats.time < SWEEP_TIME_LIMIT && (next_arrival < SWEEP_PROCESSES || stats.active)) {
+        while (next_arrival < SWEEP_PROCESSES && arrivals[next_arrival] <= stats.time) {
+            char name[OS_NAME_LEN];
+            snprintf(name, sizeof(name), "w%d", next_arrival);
+            os_create_process(k, name, sizes[next_arrival], priorities[next_arrival], lengths[next_arrival], NULL);
+            next_arrival++;
+        }
+        int limit = next_arrival < SWEEP_PROCESSES ? arrivals[next_arrival] : SWEEP_TIME_LIMIT;
+        os_step(k, limit < SWEEP_TIME_LIMIT ? limit : SWEEP_TIME_LIMIT);
+        os_get_stats(k, &stats);
+        if (stats.memory_frag_permille > run->peak_frag) {
+            run->peak_frag = stats.memory_frag_permille;
+        }
+    }
+
+    run->end_time = stats.time;
+    run->created = next_arrival;
+    run->finished = stats.finished;
+    run->failed = stats.failed_creates;
+    run->avg_turnaround = stats.finished > 0 ? (double)stats.turnaround_sum / stats.finished : 0.0;
+    run->max_turnaround = stats.turnaround_longest;
+    run->context_switches = stats.context_switches;
+    run->idle = stats.idle;
+    run->compactions = stats.compactions;
+    os_kernel_destroy(k);
+    run->host_ms = (sweep_now_ns() - start) / 1e6;
+}
+
+// 工作线程：不断领取下一个未运行的配置
+static unsigned __stdcall sweep_worker_func(void *arg) {
+    SweepPool *pool = (SweepPool*)arg;
+    LONG index;
+    while ((index = InterlockedIncrement(&pool->next) - 1) < pool->count) {
+        sweep_run(&pool->runs[index]);
+    }
+    return 0;
+}
+
+static double sweep_cpu_utilization(const SweepRun *run) {
+    return run->end_time > 0 ? 100.0 * (run->end_time - run->idle) / run->end_time : 0.0;
+}
+
+// 把全部模拟结果写成CSV，或在文件名以.json结尾时写成JSON
+static bool sweep_write_report(const char *path, const SweepRun *runs, int count) {
+    FILE *out = fopen(path, "w");
+    if (out == NULL) {
+        printf("无法创建 %s\n", path);
+        return false;
+    }
+    size_t len = strlen(path);
+    bool json = len >= 5 && strcmp(path + len - 5, ".json") == 0;
+    if (json) {
+        fprintf(out, "{\"processes\":%d,\"runs\":[\n", SWEEP_PROCESSES);
+    } else {
+        fprintf(out, "algorithm,time_slice,memory_size,seed,end_time,created,finished,failed,"
+                     "avg_turnaround,max_turnaround,context_switches,idle_ticks,cpu_utilization,"
+                     "peak_fragmentation_permille,compactions,host_ms\n");
+    }
+    for (int i = 0; i < count; i++) {
+        const SweepRun *run = &runs[i];
+        if (json) {
+            fprintf(out, "{\"algorithm\":\"%s\",\"time_slice\":%d,\"memory_size\":%d,\"seed\":%u,"
+                         "\"end_time\":%d,\"created\":%d,\"finished\":%lld,\"failed\":%lld,"
+                         "\"avg_turnaround\":%.3f,\"max_turnaround\":%d,\"context_switches\":%lld,"
+                         "\"idle_ticks\":%lld,\"cpu_utilization\":%.2f,\"peak_fragmentation_permille\":%d,"
+                         "\"compactions\":%lld,\"host_ms\":%.3f}%s\n",
+                    os_algorithm_key(run->algorithm), run->time_slice, run->memory_size, run->seed,
+                    run->end_time, run->created, run->finished, run->failed, run->avg_turnaround,
+                    run->max_turnaround, run->context_switches, run->idle, sweep_cpu_utilization(run),
+                    run->peak_frag, run->compactions, run->host_ms, i + 1 < count ? "," : "");
+        } else {
+            fprintf(out, "%s,%d,%d,%u,%d,%d,%lld,%lld,%.3f,%d,%lld,%lld,%.2f,%d,%lld,%.3f\n",
+                    os_algorithm_key(run->algorithm), run->time_slice, run->memory_size, run->seed,
+                    run->end_time, run->created, run->finished, run->failed, run->avg_turnaround,
+                    run->max_turnaround, run->context_switches, run->idle, sweep_cpu_utilization(run),
+                    run->peak_frag, run->compactions, run->host_ms);
+        }
+    }
+    if (json) {
+        fprintf(out, "]}\n");
+    }
+    fclose(out);
+    return true;
+}
+
+// sweep <算法> <时间片> <内存> <种子> [报告文件] [线程数]：各维度取值的全部组合在线程池上并行模拟，
+// 每次模拟使用独立的内核，结果按配置顺序汇总，与线程调度无关
+void sweep_command(const char *command) {
+    char alg_text[64] = "", slice_text[64] = "", memory_text[64] = "", seed_text[64] = "";
+    char path[256] = "";
+    int threads = 0;
+    sscanf(command, "%*s %63s %63s %63s %63s %255s %d",
+           alg_text, slice_text, memory_text, seed_text, path, &threads);
+
+    int algs[SWEEP_MAX_VALUES], slices[SWEEP_MAX_VALUES], memories[SWEEP_MAX_VALUES], seeds[SWEEP_MAX_VALUES];
+    int alg_count = sweep_parse_algorithms(alg_text, algs, SWEEP_MAX_VALUES);
+    int slice_count = sweep_parse_ints(slice_text, slices, SWEEP_MAX_VALUES);
+    int memory_count = sweep_parse_ints(memory_text, memories, SWEEP_MAX_VALUES);
+    int seed_count = sweep_parse_ints(seed_text, seeds, SWEEP_MAX_VALUES);
+    bool valid = alg_count > 0 && slice_count > 0 && memory_count > 0 && seed_count > 0;
+    for (int i = 0; valid && i < slice_count; i++) {
+        valid = slices[i] > 0;
+    }
+    for (int i = 0; valid && i < memory_count; i++) {
+        valid = memories[i] > 0 && memories[i] <= OS_MAX_MEMORY;
+    }
+    for (int i = 0; valid && i < seed_count; i++) {
+        valid = seeds[i] >= 0;
+    }
+    if (!valid) {
+        printf("用法: sweep <算法列表|all> <时间片列表> <内存大小列表> <种子列表> [报告.csv|报告.json] [线程数]\n");
+        printf("列表以逗号分隔，a-b表示区间，每维最多%d个值；内存大小1-%d；如 sweep rr,mlfq,cfs 2,5 256,1024 1-8 out.csv\n",
+               SWEEP_MAX_VALUES, OS_MAX_MEMORY);
+        return;
+    }
+
+    // 按 算法×时间片×内存×种子 的顺序展开配置
+    int count = alg_count * slice_count * memory_count * seed_count;
+    SweepRun *runs = (SweepRun*)calloc(count, sizeof(SweepRun));
+    int n = 0;
+    for (int a = 0; a < alg_count; a++) {
+        for (int t = 0; t < slice_count; t++) {
+            for (int m = 0; m < memory_count; m++) {
+                for (int s = 0; s < seed_count; s++) {
+                    runs[n].algorithm = (ScheduleAlgorithm)algs[a];
+                    runs[n].time_slice = slices[t];
+                    runs[n].memory_size = memories[m];
+                    runs[n].seed = (unsigned int)seeds[s];
+                    n++;
+                }
+            }
+        }
+    }
+
+    if (threads <= 0) {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        threads = (int)info.dwNumberOfProcessors;
+    }
+    if (threads > SWEEP_MAX_THREADS) threads = SWEEP_MAX_THREADS;
+    if (threads > count) threads = count;
+
+    SweepPool pool;
+    pool.runs = runs;
+    pool.count = count;
+    pool.next = 0;
+    HANDLE workers[SWEEP_MAX_THREADS];
+    int started = 0;
+    sweep_now_ns();   // 初始化计时频率，避免工作线程并发初始化
+    long long begin = sweep_now_ns();
+    for (int i = 0; i < threads; i++) {
+        workers[started] = (HANDLE)_beginthreadex(NULL, 0, sweep_worker_func, &pool, 0, NULL);
+        if (workers[started] == NULL) {
+            printf("启动工作线程失败\n");
+            break;
+        }
+        started++;
+    }
+    if (started == 0) {
+        sweep_worker_func(&pool);   // 无法创建线程时在当前线程上依次运行
+    }
+    for (int i = 0; i < started; i++) {
+        WaitForSingleObject(workers[i], INFINITE);
+        CloseHandle(workers[i]);
+    }
+    double elapsed_ms = (sweep_now_ns() - begin) / 1e6;
+
+    // 同一配置的各个种子取平均
+    printf("\n===== 参数扫描 =====\n");
+    printf("%d 种算法 × %d 种时间片 × %d 种内存 × %d 个种子 = %d 次模拟，每次 %d 个进程，%d 个工作线程\n",
+           alg_count, slice_count, memory_count, seed_count, count, SWEEP_PROCESSES, started > 0 ? started : 1);
+    printf("算法\t时间片\t内存\t完成\t失败\t平均周转\t最长周转\t上下文切换\tCPU利用率\t碎片峰值‰\t结束时间\n");
+    double total_ms = 0;
+    for (int first = 0; first < count; first += seed_count) {
+        double finished = 0, failed = 0, turnaround = 0, switches = 0, utilization = 0, frag = 0, end = 0;
+        int longest = 0;
+        for (int i = first; i < first + seed_count; i++) {
+            finished += runs[i].finished;
+            failed += runs[i].failed;
+            turnaround += runs[i].avg_turnaround;
+            switches += runs[i].context_switches;
+            utilization += sweep_cpu_utilization(&runs[i]);
+            frag += runs[i].peak_frag;
+            end += runs[i].end_time;
+            if (runs[i].max_turnaround > longest) longest = runs[i].max_turnaround;
+            total_ms += runs[i].host_ms;
+        }
+        printf("%s\t%d\t%d\t%.1f\t%.1f\t%.2f\t\t%d\t\t%.1f\t\t%.1f%%\t\t%.0f\t\t%.1f\n",
+               os_algorithm_key(runs[first].algorithm), runs[first].time_slice, runs[first].memory_size,
+               finished / seed_count, failed / seed_count, turnaround / seed_count, longest,
+               switches / seed_count, utilization / seed_count, frag / seed_count, end / seed_count);
+    }
+    printf("耗时 %.2f ms（各次模拟合计 %.2f ms，并行加速 %.2fx）\n",
+           elapsed_ms, total_ms, elapsed_ms > 0 ? total_ms / elapsed_ms : 0.0);
+    if (path[0] != '\0' && sweep_write_report(path, runs, count)) {
+        printf("报告已写入 %s（%d 行）\n", path, count);
+    }
+    printf("====================\n\n");
+    free(runs);
+}